@@ -10,14 +10,20 @@ CONFIG += c++17
 
 SOURCES += \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    metricspanel.cpp \
+    tankpresenter.cpp
 
 HEADERS += \
-    mainwindow.h
+    mainwindow.h \
+    metricspanel.h \
+    tankpresenter.h
 
 FORMS += \
     mainwindow.ui
 
+include(engine/engine.pri)
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,92 @@
+#ifndef AUDIO_COMUN_H
+#define AUDIO_COMUN_H
+
+// Partes que comparten audio_list.c, audio_stream.c y audio_summary.c: hilos,
+// enteros little-endian de los archivos al lado del .raw y el reemplazo atomico
+// de esos archivos. No es parte de la interfaz.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+//hilos
+
+#if defined(_WIN32)
+typedef SRWLOCK cerrojo_t;
+typedef CONDITION_VARIABLE aviso_t;
+typedef HANDLE hilo_t;
+static inline void cerrojo_init(cerrojo_t *m){ InitializeSRWLock(m); }
+static inline void cerrojo_fin(cerrojo_t *m){ (void)m; }
+static inline void tomar(cerrojo_t *m){ AcquireSRWLockExclusive(m); }
+static inline void soltar(cerrojo_t *m){ ReleaseSRWLockExclusive(m); }
+static inline void aviso_init(aviso_t *a){ InitializeConditionVariable(a); }
+static inline void aviso_fin(aviso_t *a){ (void)a; }
+static inline void esperar(aviso_t *a,cerrojo_t *m){ SleepConditionVariableSRW(a,m,INFINITE,0); }
+static inline void avisar(aviso_t *a){ WakeAllConditionVariable(a); }
+#else
+typedef pthread_mutex_t cerrojo_t;
+typedef pthread_cond_t aviso_t;
+typedef pthread_t hilo_t;
+static inline void cerrojo_init(cerrojo_t *m){ pthread_mutex_init(m,NULL); }
+static inline void cerrojo_fin(cerrojo_t *m){ pthread_mutex_destroy(m); }
+static inline void tomar(cerrojo_t *m){ pthread_mutex_lock(m); }
+static inline void soltar(cerrojo_t *m){ pthread_mutex_unlock(m); }
+static inline void aviso_init(aviso_t *a){ pthread_cond_init(a,NULL); }
+static inline void aviso_fin(aviso_t *a){ pthread_cond_destroy(a); }
+static inline void esperar(aviso_t *a,cerrojo_t *m){ pthread_cond_wait(a,m); }
+static inline void avisar(aviso_t *a){ pthread_cond_broadcast(a); }
+#endif
+
+// lo que corre el hilo; tiene que vivir hasta unir()
+struct tarea{
+    void (*f)(void *arg);
+    void *arg;
+};
+
+#if defined(_WIN32)
+static inline DWORD WINAPI hilo_main(LPVOID arg){ struct tarea *t=(struct tarea*)arg; t->f(t->arg); return 0; }
+static inline int lanzar(hilo_t *h,struct tarea *t){ *h=CreateThread(NULL,0,hilo_main,t,0,NULL); return *h?0:-1; }
+static inline void unir(hilo_t h){ WaitForSingleObject(h,INFINITE); CloseHandle(h); }
+static inline int nucleos(void){ SYSTEM_INFO s; GetSystemInfo(&s); return (int)s.dwNumberOfProcessors; }
+#else
+static inline void *hilo_main(void *arg){ struct tarea *t=(struct tarea*)arg; t->f(t->arg); return NULL; }
+static inline int lanzar(hilo_t *h,struct tarea *t){ return pthread_create(h,NULL,hilo_main,t)==0?0:-1; }
+static inline void unir(hilo_t h){ pthread_join(h,NULL); }
+static inline int nucleos(void){ const long n=sysconf(_SC_NPROCESSORS_ONLN); return n>0?(int)n:1; }
+#endif
+
+//archivos al lado del .raw
+
+static inline void put_u32(unsigned char *d,uint32_t v){ for(int k=0;k<4;++k) d[k]=(unsigned char)(v>>(8*k)); }
+static inline void put_u64(unsigned char *d,uint64_t v){ for(int k=0;k<8;++k) d[k]=(unsigned char)(v>>(8*k)); }
+static inline uint32_t get_u32(const unsigned char *s){ uint32_t v=0; for(int k=3;k>=0;--k) v=(v<<8)|s[k]; return v; }
+static inline uint64_t get_u64(const unsigned char *s){ uint64_t v=0; for(int k=7;k>=0;--k) v=(v<<8)|s[k]; return v; }
+static inline void put_f32(unsigned char *d,float v){ uint32_t u; memcpy(&u,&v,4); put_u32(d,u); }
+static inline float get_f32(const unsigned char *s){ const uint32_t u=get_u32(s); float v; memcpy(&v,&u,4); return v; }
+
+// path+sufijo en memoria nueva (NULL si no hay)
+static inline char *ruta_con(const char *path,const char *sufijo){
+    const size_t a=strlen(path);
+    const size_t b=strlen(sufijo);
+    char *r=(char*)malloc(a+b+1);
+    if(r){ memcpy(r,path,a); memcpy(r+a,sufijo,b+1); }
+    return r;
+}
+
+static inline int reemplazar(const char *tmp,const char *destino){
+#if defined(_WIN32)
+    return MoveFileExA(tmp,destino,MOVEFILE_REPLACE_EXISTING)?0:-1;
+#else
+    return rename(tmp,destino);
+#endif
+}
+
+#endif // AUDIO_COMUN_H
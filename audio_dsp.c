@@ -0,0 +1,513 @@
+#include "audio_dsp.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)||defined(_M_X64)||defined(__i386__)||defined(_M_IX86)
+#define AUDIO_DSP_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// gcc y clang compilan cada nucleo para su conjunto de instrucciones sin tocar
+// las banderas del proyecto; MSVC acepta los intrinsecos sin nada
+#if defined(AUDIO_DSP_X86)&&(defined(__GNUC__)||defined(__clang__))
+#define CON_SSE __attribute__((target("sse2")))
+#define CON_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define CON_SSE
+#define CON_AVX2
+#endif
+
+#define TAPS AUDIO_RESAMPLER_TAPS
+#define HIST (AUDIO_RESAMPLER_TAPS-1)
+
+//nucleos escalares
+
+static float punto_escalar(const float *c,const float *x){
+    float a0=0,a1=0,a2=0,a3=0;
+    for(int k=0;k<TAPS;k+=4){
+        a0+=c[k]*x[k];
+        a1+=c[k+1]*x[k+1];
+        a2+=c[k+2]*x[k+2];
+        a3+=c[k+3]*x[k+3];
+    }
+    return (a0+a1)+(a2+a3);
+}
+
+static void ganancia_escalar(float *dst,const float *src,uint32_t n,float g){
+    for(uint32_t i=0;i<n;++i){
+        float v=src[i]*g;
+        v=v>1.0f?1.0f:v;
+        dst[i]=v<-1.0f?-1.0f:v;
+    }
+}
+
+static void medir_escalar(const float *x,uint32_t n,float *pico,double *suma){
+    float p=0;
+    double s=0;
+    for(uint32_t i=0;i<n;++i){
+        const float a=fabsf(x[i]);
+        p=a>p?a:p;
+        s+=(double)x[i]*x[i];
+    }
+    *pico=p;
+    *suma=s;
+}
+
+// acumula sobre lo que ya tiene t (min/max arrancan en +-FLT_MAX)
+static void recorrer_resto(const float *x,uint32_t n,struct audio_tramo *t){
+    for(uint32_t i=0;i<n;++i){
+        const float v=x[i];
+        const float a=fabsf(v);
+        if(!(a<=FLT_MAX)){ ++t->no_finitas; continue; }
+        t->min=v<t->min?v:t->min;
+        t->max=v>t->max?v:t->max;
+        t->suma_cuadrados+=(double)v*v;
+        t->recortadas+=a>=1.0f;
+    }
+}
+
+static void recorrer_cerrar(struct audio_tramo *t,uint32_t n){
+    if(t->no_finitas==n) t->min=t->max=0;
+}
+
+static void recorrer_escalar(const float *x,uint32_t n,struct audio_tramo *t){
+    t->min=FLT_MAX;
+    t->max=-FLT_MAX;
+    t->suma_cuadrados=0;
+    t->no_finitas=t->recortadas=0;
+    recorrer_resto(x,n,t);
+    recorrer_cerrar(t,n);
+}
+
+// la suma de cuadrados se junta en float por tramos cortos y se pasa a double,
+// asi no se pierde precision en pistas largas
+#define TRAMO 4096u
+
+#if defined(AUDIO_DSP_X86)
+
+//nucleos SSE
+
+CON_SSE static float suma_sse(__m128 v){
+    v=_mm_add_ps(v,_mm_movehl_ps(v,v));
+    v=_mm_add_ss(v,_mm_shuffle_ps(v,v,1));
+    return _mm_cvtss_f32(v);
+}
+
+CON_SSE static float punto_sse(const float *c,const float *x){
+    __m128 a0=_mm_setzero_ps(),a1=_mm_setzero_ps(),a2=_mm_setzero_ps(),a3=_mm_setzero_ps();
+    for(int k=0;k<TAPS;k+=16){
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_load_ps(c+k),_mm_loadu_ps(x+k)));
+        a1=_mm_add_ps(a1,_mm_mul_ps(_mm_load_ps(c+k+4),_mm_loadu_ps(x+k+4)));
+        a2=_mm_add_ps(a2,_mm_mul_ps(_mm_load_ps(c+k+8),_mm_loadu_ps(x+k+8)));
+        a3=_mm_add_ps(a3,_mm_mul_ps(_mm_load_ps(c+k+12),_mm_loadu_ps(x+k+12)));
+    }
+    return suma_sse(_mm_add_ps(_mm_add_ps(a0,a1),_mm_add_ps(a2,a3)));
+}
+
+CON_SSE static void ganancia_sse(float *dst,const float *src,uint32_t n,float g){
+    const __m128 vg=_mm_set1_ps(g),uno=_mm_set1_ps(1.0f),menos=_mm_set1_ps(-1.0f);
+    uint32_t i=0;
+    for(;i+4<=n;i+=4){
+        const __m128 v=_mm_mul_ps(_mm_loadu_ps(src+i),vg);
+        _mm_storeu_ps(dst+i,_mm_max_ps(_mm_min_ps(v,uno),menos));
+    }
+    ganancia_escalar(dst+i,src+i,n-i,g);
+}
+
+CON_SSE static void medir_sse(const float *x,uint32_t n,float *pico,double *suma){
+    const __m128 sin_signo=_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 p=_mm_setzero_ps();
+    double s=0;
+    uint32_t i=0;
+    while(i+4<=n){
+        const uint32_t fin=n-i>TRAMO?i+TRAMO:n;
+        __m128 t=_mm_setzero_ps();
+        for(;i+4<=fin;i+=4){
+            const __m128 v=_mm_loadu_ps(x+i);
+            p=_mm_max_ps(p,_mm_and_ps(v,sin_signo));
+            t=_mm_add_ps(t,_mm_mul_ps(v,v));
+        }
+        s+=suma_sse(t);
+    }
+    p=_mm_max_ps(p,_mm_movehl_ps(p,p));
+    p=_mm_max_ss(p,_mm_shuffle_ps(p,p,1));
+    float pr;
+    double sr;
+    medir_escalar(x+i,n-i,&pr,&sr);
+    const float pv=_mm_cvtss_f32(p);
+    *pico=pv>pr?pv:pr;
+    *suma=s+sr;
+}
+
+// las muestras que no son finitas no cuentan para min/max (se cambian por el
+// extremo contrario) ni para la energia (se cambian por 0); las comparaciones
+// dan -1 por carril, restarlas cuenta
+CON_SSE static void recorrer_sse(const float *x,uint32_t n,struct audio_tramo *t){
+    const __m128 sin_signo=_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 tope=_mm_set1_ps(FLT_MAX),piso=_mm_set1_ps(-FLT_MAX),uno=_mm_set1_ps(1.0f);
+    __m128 mn=tope,mx=piso;
+    __m128i nf=_mm_setzero_si128(),rc=_mm_setzero_si128();
+    double s=0;
+    uint32_t i=0;
+    while(i+4<=n){
+        const uint32_t fin=n-i>TRAMO?i+TRAMO:n;
+        __m128 e=_mm_setzero_ps();
+        for(;i+4<=fin;i+=4){
+            const __m128 v=_mm_loadu_ps(x+i);
+            const __m128 a=_mm_and_ps(v,sin_signo);
+            const __m128 malo=_mm_cmpnle_ps(a,tope);
+            const __m128 bueno=_mm_andnot_ps(malo,v);
+            mn=_mm_min_ps(mn,_mm_or_ps(bueno,_mm_and_ps(malo,tope)));
+            mx=_mm_max_ps(mx,_mm_or_ps(bueno,_mm_and_ps(malo,piso)));
+            e=_mm_add_ps(e,_mm_mul_ps(bueno,bueno));
+            nf=_mm_sub_epi32(nf,_mm_castps_si128(malo));
+            rc=_mm_sub_epi32(rc,_mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(a,uno),_mm_cmple_ps(a,tope))));
+        }
+        s+=suma_sse(e);
+    }
+    float vmn[4],vmx[4];
+    uint32_t vnf[4],vrc[4];
+    _mm_storeu_ps(vmn,mn);
+    _mm_storeu_ps(vmx,mx);
+    _mm_storeu_si128((__m128i*)vnf,nf);
+    _mm_storeu_si128((__m128i*)vrc,rc);
+    t->min=FLT_MAX;
+    t->max=-FLT_MAX;
+    t->suma_cuadrados=s;
+    t->no_finitas=t->recortadas=0;
+    for(int k=0;k<4;++k){
+        t->min=vmn[k]<t->min?vmn[k]:t->min;
+        t->max=vmx[k]>t->max?vmx[k]:t->max;
+        t->no_finitas+=vnf[k];
+        t->recortadas+=vrc[k];
+    }
+    recorrer_resto(x+i,n-i,t);
+    recorrer_cerrar(t,n);
+}
+
+//nucleos AVX2+FMA
+
+CON_AVX2 static float suma_avx(__m256 v){
+    __m128 r=_mm_add_ps(_mm256_castps256_ps128(v),_mm256_extractf128_ps(v,1));
+    r=_mm_add_ps(r,_mm_movehl_ps(r,r));
+    r=_mm_add_ss(r,_mm_shuffle_ps(r,r,1));
+    return _mm_cvtss_f32(r);
+}
+
+CON_AVX2 static float punto_avx2(const float *c,const float *x){
+    __m256 a0=_mm256_setzero_ps(),a1=_mm256_setzero_ps(),a2=_mm256_setzero_ps(),a3=_mm256_setzero_ps();
+    for(int k=0;k<TAPS;k+=32){
+        a0=_mm256_fmadd_ps(_mm256_load_ps(c+k),_mm256_loadu_ps(x+k),a0);
+        a1=_mm256_fmadd_ps(_mm256_load_ps(c+k+8),_mm256_loadu_ps(x+k+8),a1);
+        a2=_mm256_fmadd_ps(_mm256_load_ps(c+k+16),_mm256_loadu_ps(x+k+16),a2);
+        a3=_mm256_fmadd_ps(_mm256_load_ps(c+k+24),_mm256_loadu_ps(x+k+24),a3);
+    }
+    return suma_avx(_mm256_add_ps(_mm256_add_ps(a0,a1),_mm256_add_ps(a2,a3)));
+}
+
+CON_AVX2 static void ganancia_avx2(float *dst,const float *src,uint32_t n,float g){
+    const __m256 vg=_mm256_set1_ps(g),uno=_mm256_set1_ps(1.0f),menos=_mm256_set1_ps(-1.0f);
+    uint32_t i=0;
+    for(;i+16<=n;i+=16){
+        const __m256 v0=_mm256_mul_ps(_mm256_loadu_ps(src+i),vg);
+        const __m256 v1=_mm256_mul_ps(_mm256_loadu_ps(src+i+8),vg);
+        _mm256_storeu_ps(dst+i,_mm256_max_ps(_mm256_min_ps(v0,uno),menos));
+        _mm256_storeu_ps(dst+i+8,_mm256_max_ps(_mm256_min_ps(v1,uno),menos));
+    }
+    ganancia_escalar(dst+i,src+i,n-i,g);
+}
+
+CON_AVX2 static void medir_avx2(const float *x,uint32_t n,float *pico,double *suma){
+    const __m256 sin_signo=_mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 p=_mm256_setzero_ps();
+    double s=0;
+    uint32_t i=0;
+    while(i+16<=n){
+        const uint32_t fin=n-i>TRAMO?i+TRAMO:n;
+        __m256 t0=_mm256_setzero_ps(),t1=_mm256_setzero_ps();
+        for(;i+16<=fin;i+=16){
+            const __m256 v0=_mm256_loadu_ps(x+i);
+            const __m256 v1=_mm256_loadu_ps(x+i+8);
+            p=_mm256_max_ps(p,_mm256_max_ps(_mm256_and_ps(v0,sin_signo),_mm256_and_ps(v1,sin_signo)));
+            t0=_mm256_fmadd_ps(v0,v0,t0);
+            t1=_mm256_fmadd_ps(v1,v1,t1);
+        }
+        s+=suma_avx(_mm256_add_ps(t0,t1));
+    }
+    __m128 q=_mm_max_ps(_mm256_castps256_ps128(p),_mm256_extractf128_ps(p,1));
+    q=_mm_max_ps(q,_mm_movehl_ps(q,q));
+    q=_mm_max_ss(q,_mm_shuffle_ps(q,q,1));
+    float pr;
+    double sr;
+    medir_escalar(x+i,n-i,&pr,&sr);
+    const float pv=_mm_cvtss_f32(q);
+    *pico=pv>pr?pv:pr;
+    *suma=s+sr;
+}
+
+CON_AVX2 static void recorrer_avx2(const float *x,uint32_t n,struct audio_tramo *t){
+    const __m256 sin_signo=_mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 tope=_mm256_set1_ps(FLT_MAX),piso=_mm256_set1_ps(-FLT_MAX),uno=_mm256_set1_ps(1.0f);
+    __m256 mn=tope,mx=piso;
+    __m256i nf=_mm256_setzero_si256(),rc=_mm256_setzero_si256();
+    double s=0;
+    uint32_t i=0;
+    while(i+8<=n){
+        const uint32_t fin=n-i>TRAMO?i+TRAMO:n;
+        __m256 e=_mm256_setzero_ps();
+        for(;i+8<=fin;i+=8){
+            const __m256 v=_mm256_loadu_ps(x+i);
+            const __m256 a=_mm256_and_ps(v,sin_signo);
+            const __m256 malo=_mm256_cmp_ps(a,tope,_CMP_NLE_UQ);
+            const __m256 bueno=_mm256_andnot_ps(malo,v);
+            mn=_mm256_min_ps(mn,_mm256_blendv_ps(bueno,tope,malo));
+            mx=_mm256_max_ps(mx,_mm256_blendv_ps(bueno,piso,malo));
+            e=_mm256_fmadd_ps(bueno,bueno,e);
+            nf=_mm256_sub_epi32(nf,_mm256_castps_si256(malo));
+            rc=_mm256_sub_epi32(rc,_mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(a,uno,_CMP_GE_OQ),_mm256_cmp_ps(a,tope,_CMP_LE_OQ))));
+        }
+        s+=suma_avx(e);
+    }
+    float vmn[8],vmx[8];
+    uint32_t vnf[8],vrc[8];
+    _mm256_storeu_ps(vmn,mn);
+    _mm256_storeu_ps(vmx,mx);
+    _mm256_storeu_si256((__m256i*)vnf,nf);
+    _mm256_storeu_si256((__m256i*)vrc,rc);
+    t->min=FLT_MAX;
+    t->max=-FLT_MAX;
+    t->suma_cuadrados=s;
+    t->no_finitas=t->recortadas=0;
+    for(int k=0;k<8;++k){
+        t->min=vmn[k]<t->min?vmn[k]:t->min;
+        t->max=vmx[k]>t->max?vmx[k]:t->max;
+        t->no_finitas+=vnf[k];
+        t->recortadas+=vrc[k];
+    }
+    recorrer_resto(x+i,n-i,t);
+    recorrer_cerrar(t,n);
+}
+
+#endif
+
+//eleccion del nucleo
+
+typedef float (*punto_fn)(const float*,const float*);
+typedef void (*ganancia_fn)(float*,const float*,uint32_t,float);
+typedef void (*medir_fn)(const float*,uint32_t,float*,double*);
+typedef void (*recorrer_fn)(const float*,uint32_t,struct audio_tramo*);
+
+static int nivel=-1;
+static punto_fn punto=punto_escalar;
+static ganancia_fn ganancia=ganancia_escalar;
+static medir_fn medir=medir_escalar;
+static recorrer_fn recorrer=recorrer_escalar;
+
+enum audio_simd audio_simd_detect(void){
+#if defined(AUDIO_DSP_X86)&&defined(_MSC_VER)
+    int r[4];
+    __cpuid(r,1);
+    const int sse=(r[3]>>26)&1;
+    const int avx=((r[2]>>28)&1)&&((r[2]>>27)&1)&&((r[2]>>12)&1)&&(_xgetbv(0)&6)==6;
+    __cpuidex(r,7,0);
+    if(avx&&((r[1]>>5)&1)) return AUDIO_SIMD_AVX2;
+    return sse?AUDIO_SIMD_SSE:AUDIO_SIMD_ESCALAR;
+#elif defined(AUDIO_DSP_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")&&__builtin_cpu_supports("fma")) return AUDIO_SIMD_AVX2;
+    return __builtin_cpu_supports("sse2")?AUDIO_SIMD_SSE:AUDIO_SIMD_ESCALAR;
+#else
+    return AUDIO_SIMD_ESCALAR;
+#endif
+}
+
+enum audio_simd audio_simd_set(enum audio_simd pedido){
+    const enum audio_simd cpu=audio_simd_detect();
+    const enum audio_simd n=pedido<cpu?pedido:cpu;
+    punto=punto_escalar;
+    ganancia=ganancia_escalar;
+    medir=medir_escalar;
+    recorrer=recorrer_escalar;
+#if defined(AUDIO_DSP_X86)
+    if(n==AUDIO_SIMD_SSE){
+        punto=punto_sse;
+        ganancia=ganancia_sse;
+        medir=medir_sse;
+        recorrer=recorrer_sse;
+    }else if(n==AUDIO_SIMD_AVX2){
+        punto=punto_avx2;
+        ganancia=ganancia_avx2;
+        medir=medir_avx2;
+        recorrer=recorrer_avx2;
+    }
+#endif
+    nivel=(int)n;
+    return n;
+}
+
+enum audio_simd audio_simd_level(void){
+    if(nivel<0) audio_simd_set(AUDIO_SIMD_AVX2);
+    return (enum audio_simd)nivel;
+}
+
+const char *audio_simd_name(enum audio_simd n){
+    switch(n){
+    case AUDIO_SIMD_SSE: return "sse";
+    case AUDIO_SIMD_AVX2: return "avx2";
+    default: return "escalar";
+    }
+}
+
+//ganancia
+
+void audio_gain(float *dst,const float *src,uint32_t n,float g){
+    audio_simd_level();
+    ganancia(dst,src,n,g);
+}
+
+void audio_measure(const float *x,uint32_t n,float *pico,double *suma_cuadrados){
+    audio_simd_level();
+    medir(x,n,pico,suma_cuadrados);
+}
+
+void audio_scan(const float *x,uint32_t n,struct audio_tramo *t){
+    audio_simd_level();
+    recorrer(x,n,t);
+}
+
+float audio_normalize_gain(float pico,float objetivo){
+    return pico>0?objetivo/pico:1.0f;
+}
+
+//remuestreo
+
+static uint32_t mcd(uint32_t a,uint32_t b){
+    while(b){ const uint32_t t=a%b; a=b; b=t; }
+    return a;
+}
+
+// Bessel modificada de orden 0, para la ventana de Kaiser
+static double bessel_i0(double x){
+    double s=1,t=1;
+    for(int k=1;k<64;++k){
+        t*=(x/(2*k))*(x/(2*k));
+        s+=t;
+        if(t<1e-12*s) break;
+    }
+    return s;
+}
+
+// prototipo de L*TAPS coeficientes a la frecuencia de entrada por L; la fase p
+// se guarda al reves (coef[p][TAPS-1-k]=h[k*L+p]) para que cada salida sea un
+// producto punto hacia adelante sobre las ultimas TAPS muestras de entrada
+static void disenar(struct audio_resampler *r){
+    const double pi=3.14159265358979323846;
+    const double atenuacion=80.0;
+    const double beta=0.1102*(atenuacion-8.7);
+    const uint32_t n=r->L*TAPS;
+    const double centro=(n-1)/2.0;
+    // transicion de Kaiser para ese largo; el corte queda a media transicion
+    // antes del Nyquist menor (en ciclos por muestra de la tasa interpolada)
+    const double ancho=(atenuacion-7.95)/(2.285*2*pi*n);
+    const uint32_t mayor=r->L>r->M?r->L:r->M;
+    const double corte=0.5/mayor-ancho/2;
+    const double i0beta=bessel_i0(beta);
+    for(uint32_t p=0;p<r->L;++p){
+        float *c=r->coef+(size_t)p*TAPS;
+        double suma=0;
+        double h[TAPS];
+        for(uint32_t k=0;k<TAPS;++k){
+            const double i=(double)k*r->L+p;
+            const double t=i-centro;
+            const double x=2*corte*t;
+            const double sinc=fabs(x)<1e-12?1.0:sin(pi*x)/(pi*x);
+            const double u=n>1?2*i/(n-1)-1:0;
+            const double w=bessel_i0(beta*sqrt(u*u<1?1-u*u:0))/i0beta;
+            h[k]=sinc*w;
+            suma+=h[k];
+        }
+        for(uint32_t k=0;k<TAPS;++k) c[TAPS-1-k]=(float)(h[k]/suma*r->ganancia);
+    }
+}
+
+int audio_resampler_init(struct audio_resampler *r,uint32_t entrada_hz,uint32_t salida_hz,float g){
+    memset(r,0,sizeof(*r));
+    if(entrada_hz==0||salida_hz==0) return -1;
+    const uint32_t d=mcd(entrada_hz,salida_hz);
+    r->entrada_hz=entrada_hz;
+    r->salida_hz=salida_hz;
+    r->L=salida_hz/d;
+    r->M=entrada_hz/d;
+    r->ganancia=g;
+    audio_simd_level();
+    if(r->L==1&&r->M==1) return 0;
+    // alineado a 32 para las cargas de AVX
+    r->coef_mem=malloc((size_t)r->L*TAPS*sizeof(float)+31);
+    if(r->coef_mem==NULL) return -1;
+    r->coef=(float*)(((uintptr_t)r->coef_mem+31)&~(uintptr_t)31);
+    disenar(r);
+    return 0;
+}
+
+void audio_resampler_free(struct audio_resampler *r){
+    free(r->coef_mem);
+    free(r->trabajo);
+    memset(r,0,sizeof(*r));
+}
+
+void audio_resampler_reset(struct audio_resampler *r){
+    memset(r->historia,0,sizeof(r->historia));
+    r->consumidas=0;
+    r->base=0;
+    r->fase=0;
+}
+
+uint32_t audio_resampler_max_out(const struct audio_resampler *r,uint32_t n){
+    return (uint32_t)((uint64_t)n*r->L/r->M+2);
+}
+
+uint32_t audio_resampler_process(struct audio_resampler *r,const float *entrada,uint32_t n,float *salida){
+    if(r->L==1&&r->M==1){
+        for(uint32_t i=0;i<n;++i) salida[i]=entrada[i]*r->ganancia;
+        return n;
+    }
+    if(HIST+n>r->trabajo_cap){
+        float *t=(float*)realloc(r->trabajo,((size_t)HIST+n)*sizeof(float));
+        if(t==NULL) return 0;
+        r->trabajo=t;
+        r->trabajo_cap=HIST+n;
+    }
+    memcpy(r->trabajo,r->historia,sizeof(r->historia));
+    memcpy(r->trabajo+HIST,entrada,(size_t)n*sizeof(float));
+
+    // trabajo[0] es la muestra consumidas-HIST: la salida que termina en base
+    // empieza en trabajo[base-consumidas]
+    const float *coef=r->coef;
+    const uint32_t L=r->L,M=r->M;
+    uint64_t rel=(uint64_t)(r->base-r->consumidas);
+    uint32_t fase=r->fase;
+    uint32_t k=0;
+    while(rel<n){
+        salida[k++]=punto(coef+(size_t)fase*TAPS,r->trabajo+rel);
+        fase+=M;
+        rel+=fase/L;
+        fase%=L;
+    }
+    r->base=r->consumidas+(int64_t)rel;
+    r->fase=fase;
+    r->consumidas+=n;
+    memcpy(r->historia,r->trabajo+n,sizeof(r->historia));
+    return k;
+}
+
+uint32_t audio_resampler_flush(struct audio_resampler *r,float *salida){
+    const float ceros[TAPS/2]={0};
+    if(r->L==1&&r->M==1) return 0;
+    return audio_resampler_process(r,ceros,TAPS/2,salida);
+}
@@ -0,0 +1,89 @@
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Procesamiento de las muestras antes de play_audio: conversion de cualquier
+// pista a una sola frecuencia de salida y ganancia. Los nucleos tienen version
+// escalar, SSE2 y AVX2+FMA; se elige en tiempo de ejecucion segun la CPU (fuera
+// de x86 queda la escalar). audio_simd_set sirve para comparar en el bench.
+
+enum audio_simd{
+    AUDIO_SIMD_ESCALAR,
+    AUDIO_SIMD_SSE,
+    AUDIO_SIMD_AVX2
+};
+
+enum audio_simd audio_simd_detect(void);
+enum audio_simd audio_simd_level(void);
+// no sube de lo que soporta la CPU; devuelve el nivel que queda
+enum audio_simd audio_simd_set(enum audio_simd nivel);
+const char *audio_simd_name(enum audio_simd nivel);
+
+// Remuestreo polifasico racional (salida/entrada = L/M reducido): filtro sinc
+// con ventana de Kaiser (80 dB) de AUDIO_RESAMPLER_TAPS coeficientes por fase,
+// con la banda de rechazo empezando en el Nyquist menor de los dos. Cada fase
+// suma exactamente 1 y la ganancia va dentro de los coeficientes, asi que
+// aplicarla no cuesta nada. Se alimenta por bloques de cualquier tamano y guarda
+// entre llamadas las muestras que necesita; la salida va atrasada
+// AUDIO_RESAMPLER_TAPS/2 muestras de entrada (flush entrega la cola). Con la
+// misma frecuencia de los dos lados solo se copia con la ganancia.
+
+#define AUDIO_RESAMPLER_TAPS 64
+
+struct audio_resampler{
+    uint32_t entrada_hz;
+    uint32_t salida_hz;
+    uint32_t L;
+    uint32_t M;
+    float ganancia;
+    float *coef;            //L fases x TAPS, alineado a 32 bytes
+    void *coef_mem;
+    float *trabajo;         //historia + bloque actual
+    uint32_t trabajo_cap;
+    float historia[AUDIO_RESAMPLER_TAPS-1];
+    int64_t consumidas;     //muestras de entrada ya recibidas
+    int64_t base;           //ultima muestra de entrada que usa la proxima salida
+    uint32_t fase;
+};
+
+// 0 si se pudo; -1 si faltan frecuencias o memoria
+int audio_resampler_init(struct audio_resampler *r,uint32_t entrada_hz,uint32_t salida_hz,float ganancia);
+void audio_resampler_free(struct audio_resampler *r);
+void audio_resampler_reset(struct audio_resampler *r);
+// lugar que tiene que tener "salida" para un bloque de n muestras
+uint32_t audio_resampler_max_out(const struct audio_resampler *r,uint32_t n);
+// devuelve cuantas muestras escribio en salida (0 si no hubo memoria)
+uint32_t audio_resampler_process(struct audio_resampler *r,const float *entrada,uint32_t n,float *salida);
+// cola del filtro al terminar la pista; salida necesita audio_resampler_max_out(r,AUDIO_RESAMPLER_TAPS/2)
+uint32_t audio_resampler_flush(struct audio_resampler *r,float *salida);
+
+// dst=clamp(src*ganancia,-1,1); dst puede ser src
+void audio_gain(float *dst,const float *src,uint32_t n,float ganancia);
+// pico (maximo |x|) y suma de cuadrados en una sola pasada
+void audio_measure(const float *x,uint32_t n,float *pico,double *suma_cuadrados);
+// ganancia para que el pico quede en "objetivo" (1 si la pista es silencio)
+float audio_normalize_gain(float pico,float objetivo);
+
+// Recorrido de validacion de un tramo, en una pasada: extremos y energia de las
+// muestras finitas, cuantas no lo son (NaN o Inf) y cuantas finitas llegan a
+// fondo de escala. Sin muestras finitas min y max quedan en 0.
+struct audio_tramo{
+    float min;
+    float max;
+    double suma_cuadrados;
+    uint32_t no_finitas;
+    uint32_t recortadas;    //|x|>=1
+};
+
+void audio_scan(const float *x,uint32_t n,struct audio_tramo *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_H
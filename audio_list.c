@@ -0,0 +1,253 @@
+// st_mtim y mmap son POSIX; con -std=c99 estricto hay que pedirlos
+#if !defined(_WIN32)&&!defined(__APPLE__)&&!defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "audio_list.h"
+#include "audio_comun.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint32_t audio_samplerate_hz(unsigned codigo){
+    static const uint32_t hz[4]={32000,44100,48000,88200};
+    return codigo<4?hz[codigo]:0;
+}
+
+#if defined(_WIN32)
+
+static int mapear(struct audio_list *l,const char *path){
+    HANDLE f=CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if(f==INVALID_HANDLE_VALUE) return -1;
+    LARGE_INTEGER tam;
+    if(!GetFileSizeEx(f,&tam)){ CloseHandle(f); return -1; }
+    FILETIME escrito;
+    if(!GetFileTime(f,NULL,NULL,&escrito)){ CloseHandle(f); return -1; }
+    l->archivo=f;
+    l->size=(uint64_t)tam.QuadPart;
+    l->mtime=(int64_t)(((uint64_t)escrito.dwHighDateTime<<32)|escrito.dwLowDateTime);
+    if(l->size==0) return 0;
+    HANDLE m=CreateFileMappingA(f,NULL,PAGE_READONLY,0,0,NULL);
+    if(m==NULL) return -1;
+    l->mapeo=m;
+    l->base=(const unsigned char*)MapViewOfFile(m,FILE_MAP_READ,0,0,0);
+    return l->base?0:-1;
+}
+
+static void desmapear(struct audio_list *l){
+    if(l->base) UnmapViewOfFile(l->base);
+    if(l->mapeo) CloseHandle((HANDLE)l->mapeo);
+    if(l->archivo) CloseHandle((HANDLE)l->archivo);
+}
+
+#else
+
+static int mapear(struct audio_list *l,const char *path){
+    int fd=open(path,O_RDONLY);
+    if(fd<0) return -1;
+    struct stat st;
+    if(fstat(fd,&st)!=0){ close(fd); return -1; }
+    l->size=(uint64_t)st.st_size;
+#if defined(__APPLE__)
+    l->mtime=(int64_t)st.st_mtimespec.tv_sec*1000000000+st.st_mtimespec.tv_nsec;
+#else
+    l->mtime=(int64_t)st.st_mtim.tv_sec*1000000000+st.st_mtim.tv_nsec;
+#endif
+    // el mapeo sigue valido despues de cerrar el descriptor
+    void *p=l->size?mmap(NULL,(size_t)l->size,PROT_READ,MAP_SHARED,fd,0):NULL;
+    close(fd);
+    if(p==MAP_FAILED) return -1;
+    l->base=(const unsigned char*)p;
+    return 0;
+}
+
+static void desmapear(struct audio_list *l){
+    if(l->base) munmap((void*)l->base,(size_t)l->size);
+}
+
+#endif
+
+// una sola pasada: se lee cada encabezado y se salta a la pista siguiente sin tocar
+// las muestras (solo se trae del disco la pagina de cada encabezado)
+static int indexar(struct audio_list *l){
+    int cap=0;
+    uint64_t off=0;
+    while(off+sizeof(struct pistas)<=l->size){
+        struct pistas audio;
+        memcpy(&audio,l->base+off,sizeof(audio));
+        const uint64_t bytes=(uint64_t)audio.samplecount*sizeof(float);
+        if(bytes>l->size-off-sizeof(audio)){ l->truncado=1; break; }
+        if(l->n==cap){
+            cap=cap?cap*2:64;
+            struct pista *t=(struct pista*)realloc(l->pistas,(size_t)cap*sizeof(struct pista));
+            if(t==NULL) return -1;
+            l->pistas=t;
+        }
+        struct pista *p=&l->pistas[l->n++];
+        p->audio=audio;
+        p->offset=off+sizeof(audio);
+        // el encabezado mide 4 bytes: las muestras quedan alineadas a float
+        p->muestras=(const float*)(l->base+p->offset);
+        off=p->offset+bytes;
+    }
+    return 0;
+}
+
+//indice en disco
+
+#define IDX_VERSION 1u
+#define IDX_ENCABEZADO 48
+#define IDX_REGISTRO 24
+
+static const char IdxMagic[8]={'A','U','D','I','O','I','D','X'};
+
+uint64_t audio_checksum(const void *datos,uint64_t bytes){
+    const unsigned char *p=(const unsigned char*)datos;
+    uint64_t h=0xcbf29ce484222325ull^bytes;
+    uint64_t k=0;
+    for(;k+8<=bytes;k+=8){
+        uint64_t w;
+        memcpy(&w,p+k,8);
+        h=(h^w)*0x100000001b3ull;
+        h^=h>>29;
+    }
+    for(;k<bytes;++k) h=(h^p[k])*0x100000001b3ull;
+    h^=h>>33;
+    h*=0xff51afd7ed558ccdull;
+    h^=h>>33;
+    return h;
+}
+
+// el indice vale solo si describe exactamente este archivo; no se toca el .raw
+static int leer_indice(struct audio_list *l,const char *idx){
+    FILE *f=fopen(idx,"rb");
+    if(f==NULL) return -1;
+    unsigned char enc[IDX_ENCABEZADO];
+    int ok=fread(enc,1,sizeof(enc),f)==sizeof(enc)
+        &&memcmp(enc,IdxMagic,sizeof(IdxMagic))==0
+        &&get_u32(enc+8)==IDX_VERSION&&get_u32(enc+12)==IDX_REGISTRO
+        &&get_u64(enc+16)==l->size&&(int64_t)get_u64(enc+24)==l->mtime;
+    const uint64_t n=ok?get_u64(enc+32):0;
+    ok=ok&&n<=(l->size/sizeof(struct pistas));
+    unsigned char *regs=NULL;
+    if(ok&&n>0){
+        regs=(unsigned char*)malloc((size_t)n*IDX_REGISTRO);
+        l->pistas=(struct pista*)malloc((size_t)n*sizeof(struct pista));
+        ok=regs&&l->pistas&&fread(regs,IDX_REGISTRO,(size_t)n,f)==(size_t)n;
+    }
+    ok=ok&&fgetc(f)==EOF;
+    fclose(f);
+
+    uint64_t fin=0;
+    for(uint64_t i=0;ok&&i<n;++i){
+        const unsigned char *r=regs+i*IDX_REGISTRO;
+        struct pista *p=&l->pistas[i];
+        p->offset=get_u64(r);
+        p->audio.samplecount=get_u32(r+8)&0x0fffffffu;
+        p->audio.samplerate=r[12]&0x0fu;
+        p->checksum=get_u64(r+16);
+        // los offsets tienen que ir en orden y caer dentro del archivo
+        const uint64_t bytes=(uint64_t)p->audio.samplecount*sizeof(float);
+        ok=p->offset>=fin+sizeof(struct pistas)&&p->offset%sizeof(float)==0&&p->offset<=l->size&&bytes<=l->size-p->offset;
+        fin=p->offset+bytes;
+        p->muestras=(const float*)(l->base+p->offset);
+    }
+    free(regs);
+    if(!ok){
+        free(l->pistas);
+        l->pistas=NULL;
+        return -1;
+    }
+    l->n=(int)n;
+    l->truncado=(get_u32(enc+40)&1u)!=0;
+    l->desde_indice=1;
+    return 0;
+}
+
+// se escribe en un temporal y se renombra: un corte no deja un indice a medias
+static int escribir_indice(const struct audio_list *l,const char *idx){
+    char *tmp=ruta_con(idx,".tmp");
+    if(tmp==NULL) return -1;
+    FILE *f=fopen(tmp,"wb");
+    if(f==NULL){ free(tmp); return -1; }
+    unsigned char enc[IDX_ENCABEZADO];
+    memset(enc,0,sizeof(enc));
+    memcpy(enc,IdxMagic,sizeof(IdxMagic));
+    put_u32(enc+8,IDX_VERSION);
+    put_u32(enc+12,IDX_REGISTRO);
+    put_u64(enc+16,l->size);
+    put_u64(enc+24,(uint64_t)l->mtime);
+    put_u64(enc+32,(uint64_t)l->n);
+    put_u32(enc+40,l->truncado?1u:0u);
+    int ok=fwrite(enc,1,sizeof(enc),f)==sizeof(enc);
+    for(int i=0;ok&&i<l->n;++i){
+        unsigned char r[IDX_REGISTRO];
+        memset(r,0,sizeof(r));
+        put_u64(r,l->pistas[i].offset);
+        put_u32(r+8,l->pistas[i].audio.samplecount);
+        r[12]=(unsigned char)l->pistas[i].audio.samplerate;
+        put_u64(r+16,l->pistas[i].checksum);
+        ok=fwrite(r,1,sizeof(r),f)==sizeof(r);
+    }
+    ok=(fclose(f)==0)&&ok;
+    ok=ok&&reemplazar(tmp,idx)==0;
+    if(!ok) remove(tmp);
+    free(tmp);
+    return ok?0:-1;
+}
+
+int audio_list_open_indexed(struct audio_list *l,const char *path){
+    memset(l,0,sizeof(*l));
+    char *idx=ruta_con(path,".idx");
+    if(idx==NULL||mapear(l,path)!=0){
+        const int e=errno;
+        free(idx);
+        audio_list_close(l);
+        errno=e;
+        return -1;
+    }
+    if(leer_indice(l,idx)==0){
+        free(idx);
+        return 0;
+    }
+    if(indexar(l)!=0){
+        const int e=errno;
+        free(idx);
+        audio_list_close(l);
+        errno=e;
+        return -1;
+    }
+    for(int i=0;i<l->n;++i)
+        l->pistas[i].checksum=audio_checksum(l->pistas[i].muestras,(uint64_t)l->pistas[i].audio.samplecount*sizeof(float));
+    escribir_indice(l,idx);
+    free(idx);
+    return 0;
+}
+
+int audio_list_open(struct audio_list *l,const char *path){
+    memset(l,0,sizeof(*l));
+    if(mapear(l,path)!=0||indexar(l)!=0){
+        const int e=errno;
+        audio_list_close(l);
+        errno=e;
+        return -1;
+    }
+    return 0;
+}
+
+void audio_list_close(struct audio_list *l){
+    desmapear(l);
+    free(l->pistas);
+    memset(l,0,sizeof(*l));
+}
@@ -0,0 +1,73 @@
+#ifndef AUDIO_LIST_H
+#define AUDIO_LIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// audio_list.raw: pistas una detras de otra, cada una con un encabezado de 4
+// bytes (struct pistas) seguido de samplecount floats. El archivo se mapea en
+// memoria y en una sola pasada se arma la tabla de pistas: solo se leen los
+// encabezados y las muestras se usan en el lugar, sin copiarlas.
+//
+// Con audio_list_open_indexed la tabla sale de un indice al lado del archivo
+// (<archivo>.idx) y no hace falta recorrerlo. Todo en little-endian:
+//   0   char[8] "AUDIOIDX"
+//   8   u32     version
+//   12  u32     bytes por registro (24)
+//   16  u64     tamano de audio_list.raw
+//   24  i64     fecha de modificacion (unidad del sistema, ns o 100 ns)
+//   32  u64     cantidad de pistas
+//   40  u32     banderas (bit 0: ultima pista truncada)
+//   44  u32     0
+//   48  registros: u64 offset de las muestras, u32 samplecount, u8 samplerate,
+//       3 bytes en 0, u64 checksum de las muestras (audio_checksum)
+// Si el tamano o la fecha no coinciden el indice se rehace, leyendo todas las
+// muestras una vez para los checksums.
+
+struct pistas{
+    uint32_t samplerate: 4; //bitmap
+    uint32_t samplecount: 28;
+};
+
+struct pista{
+    struct pistas audio;
+    uint64_t offset;        //bytes desde el comienzo del archivo hasta las muestras
+    const float *muestras;  //apunta dentro del mapeo
+    uint64_t checksum;      //solo con indice (0 si no se calculo)
+};
+
+struct audio_list{
+    const unsigned char *base;
+    uint64_t size;
+    int n;
+    struct pista *pistas;
+    int truncado;           //la ultima pista no entra en el archivo y se ignora
+    int desde_indice;       //la tabla se leyo del .idx sin recorrer el archivo
+    int64_t mtime;
+    void *archivo;          //handles del sistema (mmap / MapViewOfFile)
+    void *mapeo;
+};
+
+// 0 si se pudo mapear; -1 con errno (o GetLastError) si no
+int audio_list_open(struct audio_list *l,const char *path);
+void audio_list_close(struct audio_list *l);
+
+// igual que audio_list_open pero usando (o rehaciendo) <path>.idx; si el indice
+// no se puede escribir se sigue sin el
+int audio_list_open_indexed(struct audio_list *l,const char *path);
+
+// hash de 64 bits del contenido (no criptografico), por palabras de 8 bytes
+uint64_t audio_checksum(const void *datos,uint64_t bytes);
+
+// frecuencia del codigo de samplerate (0 si no es valido)
+uint32_t audio_samplerate_hz(unsigned codigo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_LIST_H
@@ -0,0 +1,222 @@
+// madvise no es POSIX estricto
+#if !defined(_WIN32)&&!defined(__APPLE__)&&!defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#include "audio_stream.h"
+#include "audio_comun.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+//cache LRU
+
+struct entrada{
+    int pista;
+    float *datos;
+    uint64_t bytes;
+    uint64_t uso;
+};
+
+struct audio_cache{
+    uint64_t tope;
+    uint64_t usados;
+    uint64_t reloj;
+    int n;
+    int cap;
+    struct entrada *e;
+};
+
+struct audio_cache *audio_cache_new(uint64_t tope_bytes){
+    struct audio_cache *c=(struct audio_cache*)calloc(1,sizeof(struct audio_cache));
+    if(c) c->tope=tope_bytes;
+    return c;
+}
+
+void audio_cache_free(struct audio_cache *c){
+    if(c==NULL) return;
+    for(int i=0;i<c->n;++i) free(c->e[i].datos);
+    free(c->e);
+    free(c);
+}
+
+uint64_t audio_cache_bytes(const struct audio_cache *c){return c?c->usados:0;}
+
+static int buscar(const struct audio_cache *c,int pista){
+    for(int i=0;c&&i<c->n;++i) if(c->e[i].pista==pista) return i;
+    return -1;
+}
+
+int audio_cache_contains(const struct audio_cache *c,int pista){return buscar(c,pista)>=0;}
+
+// saca las menos usadas hasta que entren "bytes" mas
+static void hacer_lugar(struct audio_cache *c,uint64_t bytes){
+    while(c->n>0&&c->usados+bytes>c->tope){
+        int viejo=0;
+        for(int i=1;i<c->n;++i) if(c->e[i].uso<c->e[viejo].uso) viejo=i;
+        c->usados-=c->e[viejo].bytes;
+        free(c->e[viejo].datos);
+        c->e[viejo]=c->e[--c->n];
+    }
+}
+
+static int guardar(struct audio_cache *c,int pista,float *datos,uint64_t bytes){
+    if(c->n==c->cap){
+        const int cap=c->cap?c->cap*2:8;
+        struct entrada *t=(struct entrada*)realloc(c->e,(size_t)cap*sizeof(struct entrada));
+        if(t==NULL) return -1;
+        c->e=t;
+        c->cap=cap;
+    }
+    struct entrada *e=&c->e[c->n++];
+    e->pista=pista;
+    e->datos=datos;
+    e->bytes=bytes;
+    e->uso=++c->reloj;
+    c->usados+=bytes;
+    return 0;
+}
+
+//paginas del mapeo
+
+// pide al sistema que vaya leyendo el bloque siguiente mientras se copia este
+static void anticipar(const unsigned char *p,uint64_t bytes){
+#if defined(_WIN32)
+    (void)p;
+    (void)bytes;
+#else
+    const uintptr_t pagina=(uintptr_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t ini=(uintptr_t)p&~(pagina-1);
+    madvise((void*)ini,(size_t)((uintptr_t)p+bytes-ini),MADV_WILLNEED);
+#endif
+}
+
+// las paginas ya copiadas dejan de contar en la memoria del proceso (siguen en
+// el cache del sistema); solo las completas, los bordes los comparten dos bloques
+static void liberar(const unsigned char *p,uint64_t bytes){
+#if defined(_WIN32)
+    (void)p;
+    (void)bytes;
+#else
+    const uintptr_t pagina=(uintptr_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t ini=((uintptr_t)p+pagina-1)&~(pagina-1);
+    const uintptr_t fin=((uintptr_t)p+bytes)&~(pagina-1);
+    if(fin>ini) madvise((void*)ini,(size_t)(fin-ini),MADV_DONTNEED);
+#endif
+}
+
+//lector
+
+struct lector{
+    const unsigned char *origen;
+    uint32_t muestras;
+    uint32_t bloques;
+    float *destino;         //pista entera (va al cache) o NULL para usar el anillo
+    float *anillo[2];
+    uint32_t listos;
+    uint32_t consumidos;
+    cerrojo_t m;
+    aviso_t a;
+};
+
+static uint32_t muestras_bloque(const struct lector *r,uint32_t k){
+    const uint32_t resto=r->muestras-k*AUDIO_BLOQUE_MUESTRAS;
+    return resto<AUDIO_BLOQUE_MUESTRAS?resto:AUDIO_BLOQUE_MUESTRAS;
+}
+
+static float *bloque(const struct lector *r,uint32_t k){
+    return r->destino?r->destino+(size_t)k*AUDIO_BLOQUE_MUESTRAS:r->anillo[k&1u];
+}
+
+static void leer(struct lector *r){
+    for(uint32_t k=0;k<r->bloques;++k){
+        // con el anillo no se pisa un bloque que el reproductor todavia no solto
+        tomar(&r->m);
+        while(r->destino==NULL&&k>=r->consumidos+2) esperar(&r->a,&r->m);
+        soltar(&r->m);
+
+        const uint64_t bytes=(uint64_t)muestras_bloque(r,k)*sizeof(float);
+        const unsigned char *src=r->origen+(uint64_t)k*AUDIO_BLOQUE_MUESTRAS*sizeof(float);
+        if(k+1<r->bloques) anticipar(src+bytes,(uint64_t)muestras_bloque(r,k+1)*sizeof(float));
+        memcpy(bloque(r,k),src,(size_t)bytes);
+        liberar(src,bytes);
+
+        tomar(&r->m);
+        r->listos=k+1;
+        avisar(&r->a);
+        soltar(&r->m);
+    }
+}
+
+static void lector_main(void *arg){ leer((struct lector*)arg); }
+
+int audio_stream_play(const struct audio_list *l,int pista,struct audio_cache *cache,
+                      audio_sink sink,void *ctx){
+    if(pista<0||pista>=l->n) return -1;
+    const struct pista *p=&l->pistas[pista];
+    const uint32_t hz=audio_samplerate_hz(p->audio.samplerate);
+    const uint32_t muestras=p->audio.samplecount;
+    const uint64_t bytes=(uint64_t)muestras*sizeof(float);
+
+    // en cache: se entrega sin pasar por el lector
+    const int i=buscar(cache,pista);
+    if(i>=0){
+        cache->e[i].uso=++cache->reloj;
+        float *datos=cache->e[i].datos;
+        for(uint32_t k=0;k<muestras;k+=AUDIO_BLOQUE_MUESTRAS){
+            const uint32_t m=muestras-k<AUDIO_BLOQUE_MUESTRAS?muestras-k:AUDIO_BLOQUE_MUESTRAS;
+            sink(hz,m,datos+k,ctx);
+        }
+        return 0;
+    }
+    if(muestras==0) return 0;
+
+    struct lector r;
+    memset(&r,0,sizeof(r));
+    r.origen=l->base+p->offset;
+    r.muestras=muestras;
+    r.bloques=(muestras+AUDIO_BLOQUE_MUESTRAS-1)/AUDIO_BLOQUE_MUESTRAS;
+    if(cache&&bytes<=cache->tope){
+        hacer_lugar(cache,bytes);
+        r.destino=(float*)malloc((size_t)bytes);
+    }
+    if(r.destino==NULL){
+        r.anillo[0]=(float*)malloc(AUDIO_BLOQUE_MUESTRAS*sizeof(float));
+        r.anillo[1]=(float*)malloc(AUDIO_BLOQUE_MUESTRAS*sizeof(float));
+        if(r.anillo[0]==NULL||r.anillo[1]==NULL){
+            free(r.anillo[0]);
+            free(r.anillo[1]);
+            return -1;
+        }
+    }
+    cerrojo_init(&r.m);
+    aviso_init(&r.a);
+
+    hilo_t h;
+    struct tarea t={lector_main,&r};
+    int ok=lanzar(&h,&t)==0;
+    for(uint32_t k=0;ok&&k<r.bloques;++k){
+        tomar(&r.m);
+        while(r.listos<=k) esperar(&r.a,&r.m);
+        soltar(&r.m);
+
+        sink(hz,muestras_bloque(&r,k),bloque(&r,k),ctx);
+
+        tomar(&r.m);
+        r.consumidos=k+1;
+        avisar(&r.a);
+        soltar(&r.m);
+    }
+    if(ok) unir(h);
+
+    aviso_fin(&r.a);
+    cerrojo_fin(&r.m);
+    free(r.anillo[0]);
+    free(r.anillo[1]);
+    if(r.destino&&(!ok||guardar(cache,pista,r.destino,bytes)!=0)) free(r.destino);
+    return ok?0:-1;
+}
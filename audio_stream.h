@@ -0,0 +1,44 @@
+#ifndef AUDIO_STREAM_H
+#define AUDIO_STREAM_H
+
+#include <stdint.h>
+
+#include "audio_list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reproduccion por bloques de una pista de audio_list. Un hilo lector copia la
+// pista del mapeo a dos buffers fijos mientras el que llama le pasa el otro al
+// reproductor; la memoria usada es la de los dos bloques mas el cache, sin
+// importar el tamano del archivo (las paginas del mapeo ya copiadas se sueltan).
+// Lo que se espera antes de la primera muestra es un solo bloque.
+//
+// El cache LRU guarda copias completas de las ultimas pistas reproducidas hasta
+// un tope de bytes: una pista en cache se entrega sin esperar al disco. Una pista
+// que entra en el tope se lee directo a su lugar en el cache (sin los buffers).
+
+#define AUDIO_BLOQUE_MUESTRAS (1u<<16)
+
+// recibe cada bloque en orden; datos vale solo durante la llamada y no se modifica
+// (puede ser la copia del cache)
+typedef void (*audio_sink)(uint32_t samplerate_hz,uint32_t muestras,float *datos,void *ctx);
+
+struct audio_cache;
+
+struct audio_cache *audio_cache_new(uint64_t tope_bytes);
+void audio_cache_free(struct audio_cache *c);
+uint64_t audio_cache_bytes(const struct audio_cache *c);
+int audio_cache_contains(const struct audio_cache *c,int pista);
+
+// 0 si se reprodujo entera; -1 si no se pudo crear el hilo o reservar los buffers
+// (cache puede ser NULL)
+int audio_stream_play(const struct audio_list *l,int pista,struct audio_cache *cache,
+                      audio_sink sink,void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_STREAM_H
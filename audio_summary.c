@@ -0,0 +1,323 @@
+// sysconf(_SC_NPROCESSORS_ONLN) no es POSIX estricto
+#if !defined(_WIN32)&&!defined(__APPLE__)&&!defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#include "audio_summary.h"
+#include "audio_comun.h"
+#include "audio_dsp.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t largo_nivel(int k){
+    uint32_t t=AUDIO_RESUMEN_TRAMO;
+    while(k-->0) t*=AUDIO_RESUMEN_FACTOR;
+    return t;
+}
+
+static uint32_t puntos_nivel(uint32_t muestras,int k){
+    const uint32_t t=largo_nivel(k);
+    return (uint32_t)(((uint64_t)muestras+t-1)/t);
+}
+
+// una sola reserva para los puntos de todas las pistas
+static int reservar(struct audio_resumenes *r){
+    size_t total=0;
+    for(int i=0;i<r->n;++i)
+        for(int k=0;k<AUDIO_RESUMEN_NIVELES;++k) total+=r->pistas[i].puntos[k];
+    r->puntos=malloc(total?total*sizeof(struct audio_punto):1);
+    if(r->puntos==NULL) return -1;
+    struct audio_punto *p=(struct audio_punto*)r->puntos;
+    for(int i=0;i<r->n;++i)
+        for(int k=0;k<AUDIO_RESUMEN_NIVELES;++k){
+            r->pistas[i].nivel[k]=p;
+            p+=r->pistas[i].puntos[k];
+        }
+    return 0;
+}
+
+//una pista
+
+// nivel 0 con audio_scan sobre las muestras; los siguientes juntando los puntos
+// del anterior (la energia de cada uno es rms^2 por sus muestras)
+static void resumir(const struct pista *t,struct audio_resumen *p){
+    const float *x=t->muestras;
+    const uint32_t n=p->muestras;
+    float mn=FLT_MAX,mx=-FLT_MAX;
+    double suma=0;
+    for(uint32_t b=0;b<p->puntos[0];++b){
+        const uint32_t ini=b*AUDIO_RESUMEN_TRAMO;
+        const uint32_t m=n-ini<AUDIO_RESUMEN_TRAMO?n-ini:AUDIO_RESUMEN_TRAMO;
+        struct audio_tramo tr;
+        audio_scan(x+ini,m,&tr);
+        p->nivel[0][b].min=tr.min;
+        p->nivel[0][b].max=tr.max;
+        p->nivel[0][b].rms=(float)sqrt(tr.suma_cuadrados/m);
+        if(tr.no_finitas<m){
+            mn=tr.min<mn?tr.min:mn;
+            mx=tr.max>mx?tr.max:mx;
+        }
+        suma+=tr.suma_cuadrados;
+        p->no_finitas+=tr.no_finitas;
+        p->recortadas+=tr.recortadas;
+    }
+    for(int k=1;k<AUDIO_RESUMEN_NIVELES;++k){
+        const uint32_t largo=largo_nivel(k-1);
+        const struct audio_punto *abajo=p->nivel[k-1];
+        for(uint32_t j=0;j<p->puntos[k];++j){
+            const uint32_t a=j*AUDIO_RESUMEN_FACTOR;
+            const uint32_t b=a+AUDIO_RESUMEN_FACTOR<p->puntos[k-1]?a+AUDIO_RESUMEN_FACTOR:p->puntos[k-1];
+            struct audio_punto q={abajo[a].min,abajo[a].max,0};
+            double e=0;
+            uint32_t cuantas=0;
+            for(uint32_t c=a;c<b;++c){
+                const uint32_t m=n-c*largo<largo?n-c*largo:largo;
+                q.min=abajo[c].min<q.min?abajo[c].min:q.min;
+                q.max=abajo[c].max>q.max?abajo[c].max:q.max;
+                e+=(double)abajo[c].rms*abajo[c].rms*m;
+                cuantas+=m;
+            }
+            q.rms=(float)sqrt(e/cuantas);
+            p->nivel[k][j]=q;
+        }
+    }
+    if(mx<mn) mn=mx=0;
+    p->min=mn;
+    p->max=mx;
+    p->pico=-mn>mx?-mn:mx;
+    p->rms=n?(float)sqrt(suma/n):0.0f;
+    p->checksum=audio_checksum(x,(uint64_t)n*sizeof(float));
+    p->checksum_ok=t->checksum?t->checksum==p->checksum:-1;
+}
+
+//reparto entre hilos
+
+struct reparto{
+    const struct audio_list *l;
+    struct audio_resumenes *r;
+    const int *orden;
+    int siguiente;
+    cerrojo_t m;
+};
+
+static void trabajar(void *arg){
+    struct reparto *w=(struct reparto*)arg;
+    for(;;){
+        tomar(&w->m);
+        const int k=w->siguiente++;
+        soltar(&w->m);
+        if(k>=w->r->n) break;
+        const int i=w->orden[k];
+        resumir(&w->l->pistas[i],&w->r->pistas[i]);
+    }
+}
+
+struct largo{
+    uint32_t muestras;
+    int pista;
+};
+
+static int mas_largo_primero(const void *a,const void *b){
+    const struct largo *x=(const struct largo*)a;
+    const struct largo *y=(const struct largo*)b;
+    if(x->muestras!=y->muestras) return x->muestras<y->muestras?1:-1;
+    return x->pista-y->pista;
+}
+
+int audio_summary_build(const struct audio_list *l,struct audio_resumenes *r,int hilos){
+    memset(r,0,sizeof(*r));
+    r->n=l->n;
+    r->pistas=(struct audio_resumen*)calloc(l->n?(size_t)l->n:1,sizeof(struct audio_resumen));
+    if(r->pistas==NULL) return -1;
+    for(int i=0;i<l->n;++i){
+        struct audio_resumen *p=&r->pistas[i];
+        p->hz=audio_samplerate_hz(l->pistas[i].audio.samplerate);
+        p->muestras=l->pistas[i].audio.samplecount;
+        for(int k=0;k<AUDIO_RESUMEN_NIVELES;++k) p->puntos[k]=puntos_nivel(p->muestras,k);
+    }
+    struct largo *orden=(struct largo*)malloc((l->n?(size_t)l->n:1)*sizeof(struct largo));
+    int *indices=(int*)malloc((l->n?(size_t)l->n:1)*sizeof(int));
+    if(orden==NULL||indices==NULL||reservar(r)!=0){
+        free(orden);
+        free(indices);
+        audio_summary_free(r);
+        return -1;
+    }
+    // las largas primero: al final quedan solo cortas para emparejar los hilos
+    for(int i=0;i<l->n;++i){
+        orden[i].muestras=r->pistas[i].muestras;
+        orden[i].pista=i;
+    }
+    qsort(orden,(size_t)l->n,sizeof(struct largo),mas_largo_primero);
+    for(int i=0;i<l->n;++i) indices[i]=orden[i].pista;
+    free(orden);
+
+    // el nucleo se elige antes de que lo usen los hilos
+    audio_simd_level();
+
+    struct reparto w;
+    w.l=l;
+    w.r=r;
+    w.orden=indices;
+    w.siguiente=0;
+    cerrojo_init(&w.m);
+    if(hilos<=0) hilos=nucleos();
+    if(hilos>l->n) hilos=l->n;
+    hilo_t *h=hilos>1?(hilo_t*)malloc((size_t)(hilos-1)*sizeof(hilo_t)):NULL;
+    struct tarea t={trabajar,&w};
+    int lanzados=0;
+    // el que llama tambien trabaja; si no se pudo lanzar ninguno lo hace todo
+    while(h&&lanzados<hilos-1&&lanzar(&h[lanzados],&t)==0) ++lanzados;
+    trabajar(&w);
+    for(int k=0;k<lanzados;++k) unir(h[k]);
+    free(h);
+    cerrojo_fin(&w.m);
+    free(indices);
+    return 0;
+}
+
+//cache en disco
+
+#define SUM_VERSION 1u
+#define SUM_ENCABEZADO 48
+#define SUM_REGISTRO 64
+
+static const char SumMagic[8]={'A','U','D','I','O','S','U','M'};
+
+// vale solo si describe este archivo y estas pistas
+static int leer_resumen(const struct audio_list *l,const char *ruta,struct audio_resumenes *r){
+    FILE *f=fopen(ruta,"rb");
+    if(f==NULL) return -1;
+    unsigned char enc[SUM_ENCABEZADO];
+    int ok=fread(enc,1,sizeof(enc),f)==sizeof(enc)
+        &&memcmp(enc,SumMagic,sizeof(SumMagic))==0
+        &&get_u32(enc+8)==SUM_VERSION&&get_u32(enc+12)==SUM_REGISTRO
+        &&get_u64(enc+16)==l->size&&(int64_t)get_u64(enc+24)==l->mtime
+        &&get_u64(enc+32)==(uint64_t)l->n
+        &&get_u32(enc+40)==AUDIO_RESUMEN_TRAMO&&get_u32(enc+44)==AUDIO_RESUMEN_FACTOR;
+    memset(r,0,sizeof(*r));
+    r->n=l->n;
+    r->pistas=ok?(struct audio_resumen*)calloc(l->n?(size_t)l->n:1,sizeof(struct audio_resumen)):NULL;
+    ok=ok&&r->pistas;
+    for(int i=0;ok&&i<l->n;++i){
+        unsigned char g[SUM_REGISTRO];
+        struct audio_resumen *p=&r->pistas[i];
+        ok=fread(g,1,sizeof(g),f)==sizeof(g);
+        if(!ok) break;
+        p->hz=get_u32(g);
+        p->muestras=get_u32(g+4);
+        p->min=get_f32(g+8);
+        p->max=get_f32(g+12);
+        p->pico=get_f32(g+16);
+        p->rms=get_f32(g+20);
+        p->no_finitas=get_u32(g+24);
+        p->recortadas=get_u32(g+28);
+        p->checksum=get_u64(g+32);
+        p->checksum_ok=(int)get_u32(g+40);
+        ok=p->muestras==l->pistas[i].audio.samplecount;
+        for(int k=0;ok&&k<AUDIO_RESUMEN_NIVELES;++k){
+            p->puntos[k]=get_u32(g+44+4*k);
+            ok=p->puntos[k]==puntos_nivel(p->muestras,k);
+        }
+        // el indice puede haberse rehecho despues: se vuelve a comparar
+        if(ok&&l->pistas[i].checksum) p->checksum_ok=l->pistas[i].checksum==p->checksum;
+    }
+    ok=ok&&reservar(r)==0;
+    for(int i=0;ok&&i<l->n;++i)
+        for(int k=0;ok&&k<AUDIO_RESUMEN_NIVELES;++k)
+            for(uint32_t j=0;ok&&j<r->pistas[i].puntos[k];++j){
+                unsigned char g[12];
+                ok=fread(g,1,sizeof(g),f)==sizeof(g);
+                r->pistas[i].nivel[k][j].min=get_f32(g);
+                r->pistas[i].nivel[k][j].max=get_f32(g+4);
+                r->pistas[i].nivel[k][j].rms=get_f32(g+8);
+            }
+    ok=ok&&fgetc(f)==EOF;
+    fclose(f);
+    if(!ok){
+        audio_summary_free(r);
+        return -1;
+    }
+    r->desde_cache=1;
+    return 0;
+}
+
+// temporal y renombre, como el .idx
+static int escribir_resumen(const struct audio_list *l,const char *ruta,const struct audio_resumenes *r){
+    char *tmp=ruta_con(ruta,".tmp");
+    if(tmp==NULL) return -1;
+    FILE *f=fopen(tmp,"wb");
+    if(f==NULL){ free(tmp); return -1; }
+    unsigned char enc[SUM_ENCABEZADO];
+    memset(enc,0,sizeof(enc));
+    memcpy(enc,SumMagic,sizeof(SumMagic));
+    put_u32(enc+8,SUM_VERSION);
+    put_u32(enc+12,SUM_REGISTRO);
+    put_u64(enc+16,l->size);
+    put_u64(enc+24,(uint64_t)l->mtime);
+    put_u64(enc+32,(uint64_t)r->n);
+    put_u32(enc+40,AUDIO_RESUMEN_TRAMO);
+    put_u32(enc+44,AUDIO_RESUMEN_FACTOR);
+    int ok=fwrite(enc,1,sizeof(enc),f)==sizeof(enc);
+    for(int i=0;ok&&i<r->n;++i){
+        const struct audio_resumen *p=&r->pistas[i];
+        unsigned char g[SUM_REGISTRO];
+        memset(g,0,sizeof(g));
+        put_u32(g,p->hz);
+        put_u32(g+4,p->muestras);
+        put_f32(g+8,p->min);
+        put_f32(g+12,p->max);
+        put_f32(g+16,p->pico);
+        put_f32(g+20,p->rms);
+        put_u32(g+24,p->no_finitas);
+        put_u32(g+28,p->recortadas);
+        put_u64(g+32,p->checksum);
+        put_u32(g+40,(uint32_t)p->checksum_ok);
+        for(int k=0;k<AUDIO_RESUMEN_NIVELES;++k) put_u32(g+44+4*k,p->puntos[k]);
+        ok=fwrite(g,1,sizeof(g),f)==sizeof(g);
+    }
+    for(int i=0;ok&&i<r->n;++i)
+        for(int k=0;ok&&k<AUDIO_RESUMEN_NIVELES;++k)
+            for(uint32_t j=0;ok&&j<r->pistas[i].puntos[k];++j){
+                const struct audio_punto *q=&r->pistas[i].nivel[k][j];
+                unsigned char g[12];
+                put_f32(g,q->min);
+                put_f32(g+4,q->max);
+                put_f32(g+8,q->rms);
+                ok=fwrite(g,1,sizeof(g),f)==sizeof(g);
+            }
+    ok=(fclose(f)==0)&&ok;
+    ok=ok&&reemplazar(tmp,ruta)==0;
+    if(!ok) remove(tmp);
+    free(tmp);
+    return ok?0:-1;
+}
+
+int audio_summary_open(const struct audio_list *l,const char *path,struct audio_resumenes *r,int hilos){
+    char *ruta=ruta_con(path,".sum");
+    if(ruta&&leer_resumen(l,ruta,r)==0){
+        free(ruta);
+        return 0;
+    }
+    if(audio_summary_build(l,r,hilos)!=0){
+        free(ruta);
+        return -1;
+    }
+    if(ruta) escribir_resumen(l,ruta,r);
+    free(ruta);
+    return 0;
+}
+
+void audio_summary_free(struct audio_resumenes *r){
+    free(r->pistas);
+    free(r->puntos);
+    memset(r,0,sizeof(*r));
+}
+
+double audio_summary_seconds(const struct audio_resumen *p){
+    return p->hz?(double)p->muestras/p->hz:0.0;
+}
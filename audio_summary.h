@@ -0,0 +1,83 @@
+#ifndef AUDIO_SUMMARY_H
+#define AUDIO_SUMMARY_H
+
+#include <stdint.h>
+
+#include "audio_list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Validacion y resumen de cada pista de audio_list: muestras que no son finitas,
+// recortes, checksum contra el indice, pico/RMS/min/max y la forma de onda a
+// varios zooms (min/max/RMS por tramo de AUDIO_RESUMEN_TRAMO muestras en el
+// nivel 0, AUDIO_RESUMEN_FACTOR veces mas largo en cada nivel siguiente).
+//
+// Las pistas se reparten entre varios hilos, de la mas larga a la mas corta; el
+// resultado se guarda al lado del archivo (<archivo>.sum) y mientras el .raw no
+// cambie (tamano y fecha, como el .idx) se lee de ahi sin tocar las muestras.
+// Todo en little-endian:
+//   0   char[8] "AUDIOSUM"
+//   8   u32     version
+//   12  u32     bytes por registro de pista (64)
+//   16  u64     tamano de audio_list.raw
+//   24  i64     fecha de modificacion
+//   32  u64     cantidad de pistas
+//   40  u32     AUDIO_RESUMEN_TRAMO
+//   44  u32     AUDIO_RESUMEN_FACTOR
+//   48  registros: u32 hz, u32 muestras, f32 min, f32 max, f32 pico, f32 rms,
+//       u32 no finitas, u32 recortadas, u64 checksum, i32 checksum_ok,
+//       u32 puntos de cada nivel (4), 4 bytes en 0
+//   despues los puntos de cada pista, nivel por nivel: f32 min, f32 max, f32 rms
+
+#define AUDIO_RESUMEN_NIVELES 4
+#define AUDIO_RESUMEN_TRAMO 1024u
+#define AUDIO_RESUMEN_FACTOR 8u
+
+struct audio_punto{
+    float min;
+    float max;
+    float rms;
+};
+
+struct audio_resumen{
+    uint32_t hz;
+    uint32_t muestras;
+    float min;
+    float max;
+    float pico;
+    float rms;
+    uint32_t no_finitas;    //NaN o Inf (no cuentan para lo demas)
+    uint32_t recortadas;    //|x|>=1
+    uint64_t checksum;
+    int checksum_ok;        //1 coincide con el indice, 0 no, -1 la lista no tenia checksum
+    uint32_t puntos[AUDIO_RESUMEN_NIVELES];
+    struct audio_punto *nivel[AUDIO_RESUMEN_NIVELES];
+};
+
+struct audio_resumenes{
+    int n;
+    struct audio_resumen *pistas;
+    int desde_cache;        //se leyo del .sum
+    void *puntos;           //memoria de todos los niveles
+};
+
+// hilos<=0 usa uno por nucleo; 0 si se pudo, -1 si falta memoria o no se pudo
+// lanzar ningun hilo
+int audio_summary_build(const struct audio_list *l,struct audio_resumenes *r,int hilos);
+
+// lee <path>.sum si describe este archivo o lo arma y lo escribe (si no se
+// puede escribir se sigue sin el)
+int audio_summary_open(const struct audio_list *l,const char *path,struct audio_resumenes *r,int hilos);
+
+void audio_summary_free(struct audio_resumenes *r);
+
+// segundos de la pista (0 si la frecuencia no es valida)
+double audio_summary_seconds(const struct audio_resumen *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_SUMMARY_H
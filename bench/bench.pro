@@ -0,0 +1,29 @@
+# Benchmarks de los caminos calientes del motor (tick, distribucion, JSON) y del
+# cargador y el procesamiento de audio_list.raw. Solo QtCore; correr en release:
+#   qmake bench.pro CONFIG+=release && make && ./aguabench --help
+
+TEMPLATE = app
+TARGET = aguabench
+QT = core
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    benchstats.cpp \
+    ../audio_dsp.c \
+    ../audio_list.c \
+    ../audio_stream.c \
+    ../audio_summary.c
+
+HEADERS += \
+    benchstats.h \
+    ../audio_comun.h \
+    ../audio_dsp.h \
+    ../audio_list.h \
+    ../audio_stream.h \
+    ../audio_summary.h
+
+include(../engine/engine.pri)
@@ -0,0 +1,69 @@
+#include "benchstats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <utility>
+
+BenchStats::BenchStats(std::string name,double workPerSample,std::string workUnit)
+    : m_name(std::move(name)),
+    m_workPerSample(workPerSample),
+    m_workUnit(std::move(workUnit)),
+    m_sorted(true)
+{
+}
+
+void BenchStats::reserve(std::size_t n){ m_ns.reserve(n); }
+
+void BenchStats::add(Clock::duration d){
+    m_ns.push_back(double(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    m_sorted=false;
+}
+
+std::size_t BenchStats::samples()const{return m_ns.size();}
+
+// percentil por rango mas cercano sobre las muestras ordenadas
+double BenchStats::percentileNs(double p){
+    if(m_ns.empty()) return 0.0;
+    if(!m_sorted){
+        std::sort(m_ns.begin(),m_ns.end());
+        m_sorted=true;
+    }
+    std::size_t rank=std::size_t(std::ceil(p/100.0*double(m_ns.size())));
+    rank=std::min(std::max<std::size_t>(rank,1),m_ns.size());
+    return m_ns[rank-1];
+}
+
+double BenchStats::meanNs()const{
+    if(m_ns.empty()) return 0.0;
+    return std::accumulate(m_ns.begin(),m_ns.end(),0.0)/double(m_ns.size());
+}
+
+double BenchStats::throughputPerS()const{
+    double total=std::accumulate(m_ns.begin(),m_ns.end(),0.0);
+    if(total<=0.0) return 0.0;
+    return m_workPerSample*double(m_ns.size())/(total*1e-9);
+}
+
+static void printNs(double ns){
+    if(ns<1e3) std::printf(" %9.0fns",ns);
+    else if(ns<1e6) std::printf(" %9.2fus",ns/1e3);
+    else if(ns<1e9) std::printf(" %9.2fms",ns/1e6);
+    else std::printf(" %9.3fs ",ns/1e9);
+}
+
+void BenchStats::report(){
+    std::printf("%-34s n=%-7zu",m_name.c_str(),m_ns.size());
+    std::printf(" p50"); printNs(percentileNs(50.0));
+    std::printf(" p90"); printNs(percentileNs(90.0));
+    std::printf(" p99"); printNs(percentileNs(99.0));
+    std::printf(" max"); printNs(percentileNs(100.0));
+    std::printf("  %12.4g %s/s\n",throughputPerS(),m_workUnit.c_str());
+    std::fflush(stdout);
+}
+
+void doNotOptimize(double v){
+    static volatile double sink;
+    sink=v;
+}
@@ -0,0 +1,51 @@
+#ifndef BENCHSTATS_H
+#define BENCHSTATS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Junta la duracion de cada muestra y reporta throughput y percentiles de latencia.
+// "work" es cuanto trabajo representa una muestra (tanques x ticks, bytes, ...),
+// con su unidad para el reporte.
+
+class BenchStats {
+public:
+    using Clock=std::chrono::steady_clock;
+
+    BenchStats(std::string name,double workPerSample,std::string workUnit);
+
+    void reserve(std::size_t n);
+    void add(Clock::duration d);
+    std::size_t samples()const;
+
+    double percentileNs(double p);
+    double meanNs()const;
+    double throughputPerS()const;
+
+    void report();
+
+private:
+    std::string m_name;
+    double m_workPerSample;
+    std::string m_workUnit;
+    std::vector<double> m_ns;
+    bool m_sorted;
+};
+
+// mide f() "samples" veces despues de "warmup" corridas sin medir
+template<class F>
+void runSamples(BenchStats& stats,int warmup,int samples,F&& f){
+    for(int k=0;k<warmup;++k) f();
+    stats.reserve(samples);
+    for(int k=0;k<samples;++k){
+        BenchStats::Clock::time_point t0=BenchStats::Clock::now();
+        f();
+        stats.add(BenchStats::Clock::now()-t0);
+    }
+}
+
+// evita que el compilador descarte un resultado que no se usa
+void doNotOptimize(double v);
+
+#endif // BENCHSTATS_H
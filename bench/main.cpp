@@ -0,0 +1,881 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "audio_dsp.h"
+#include "audio_list.h"
+#include "audio_stream.h"
+#include "audio_summary.h"
+#include "benchstats.h"
+#include "fixedplant.h"
+#include "flowallocator.h"
+#include "forecast.h"
+#include "integrator.h"
+#include "recorder.h"
+#include "simengine.h"
+#include "simjson.h"
+#include "snapshotfile.h"
+#include "tankgraph.h"
+#include "tanknetwork.h"
+#include "threadpool.h"
+
+// Benchmarks de los caminos calientes:
+//  - tick de TankNetwork con 1, 1k y 100k tanques (lo que antes era ControlTanque::onTick)
+//  - costo de grabar la serie de tiempo en el tick (Recorder::record)
+//  - reparto por llenado de agua entre 3, 1k y 100k consumidores
+//  - tick del grafo de sitios (cisterna -> torre -> 2 zonas) en un hilo y con pool
+//  - descarga por gravedad: Euler de paso fijo contra Dormand-Prince adaptativo,
+//    con el error contra la solucion exacta
+//  - paso completo de la planta y distribucion a los auxiliares con diales al azar
+//  - planta de 1 principal y K consumidores: SimEngine contra FixedPlant<K>
+//  - pronostico de 24 h despues de mover un dial, con 2 y 1k consumidores
+//  - cambio de un tope en una red de 10k tanques: solo el tanque contra toda la red
+//  - ida y vuelta a JSON y a la foto binaria de estados grandes
+//  - cargador de audio_list.raw de main.c sobre archivos de varios GB (copia
+//    con fread contra mapeo)
+//  - remuestreo a 48 kHz y ganancia de main.c, escalar contra SSE2 y AVX2
+//  - validacion y resumen de todas las pistas (en paralelo y desde el .sum)
+// Todo con semilla fija para que dos corridas sean comparables.
+
+namespace {
+
+struct Options {
+    QString filter;
+    bool quick=false;
+    QString rawPath;
+    qint64 rawMb=256;
+};
+
+bool selected(const Options& opt,const char* name){
+    return opt.filter.isEmpty()||QString::fromLatin1(name).contains(opt.filter);
+}
+
+int scaled(const Options& opt,int samples){
+    return opt.quick?qMax(3,samples/10):samples;
+}
+
+// red con capacidades, niveles y flujos variados para que haya eventos
+void fillNetwork(TankNetwork& net,int n,std::mt19937& rng){
+    std::uniform_real_distribution<double> cap(100.0,1000.0);
+    std::uniform_real_distribution<double> frac(0.05,0.95);
+    std::uniform_real_distribution<double> flow(0.0,2000.0);
+    net.resize(n);
+    for(int i=0;i<n;++i){
+        double c=cap(rng);
+        net.setCapacityL(i,c);
+        net.setLevelL(i,c*frac(rng));
+        net.setInputMaxLph(i,2000.0);
+        net.setOutputMaxLph(i,2000.0);
+        net.applyInputFlowLph(i,flow(rng));
+        net.applyOutputFlowLph(i,flow(rng));
+    }
+}
+
+void benchTick(const Options& opt){
+    const int sizes[]={1,1000,100000};
+    for(int n:sizes){
+        char name[64];
+        std::snprintf(name,sizeof(name),"tick/%d",n);
+        if(!selected(opt,name)) continue;
+
+        std::mt19937 rng(1234);
+        TankNetwork net;
+        fillNetwork(net,n,rng);
+        // con pocos tanques se agrupan ticks para que la muestra no sea ruido del reloj
+        const int batch=qMax(1,4096/n);
+        int events=0;
+        BenchStats stats(name,double(n)*batch,"tank-ticks");
+        runSamples(stats,100,scaled(opt,n>=100000?2000:20000),[&]{
+            for(int k=0;k<batch;++k) events+=net.tick(0.2);
+        });
+        doNotOptimize(events);
+        stats.report();
+    }
+}
+
+// lo que agrega la grabacion al hilo de simulacion: la copia al anillo. Si el
+// escritor no alcanza, el cuadro se descarta (mucho mas barato): por eso se
+// informa cuantos se grabaron de verdad
+void benchRecorder(const Options& opt){
+    const int sizes[]={1000,100000};
+    for(int n:sizes){
+        char name[64];
+        std::snprintf(name,sizeof(name),"record/%d",n);
+        if(!selected(opt,name)) continue;
+
+        QTemporaryFile tmp;
+        if(!tmp.open()){ std::printf("%s: no se pudo crear el archivo temporal\n",name); continue; }
+        const QString path=tmp.fileName();
+        tmp.close();
+
+        std::mt19937 rng(77);
+        TankNetwork net;
+        fillNetwork(net,n,rng);
+        Recorder rec(path);
+        if(!rec.start(n)){ std::printf("%s: %s\n",name,rec.errorString().toLocal8Bit().constData()); continue; }
+        unsigned long long tick=0;
+        BenchStats stats(name,double(n),"tanks");
+        runSamples(stats,10,scaled(opt,n>=100000?500:5000),[&]{
+            ++tick;
+            rec.record(net,tick,tick*0.2);
+        });
+        rec.stop();
+        stats.report();
+        std::printf("%s: %llu cuadros grabados, %llu descartados\n",name,rec.recordedFrames(),rec.droppedFrames());
+    }
+}
+
+// espacio libre y topes al azar; el total queda a mitad de la suma de topes para
+// que haya consumidores saturados y otros repartiendo el resto
+void benchAllocator(const Options& opt){
+    const int sizes[]={3,1000,100000};
+    for(int n:sizes){
+        char name[64];
+        std::snprintf(name,sizeof(name),"alloc/%d",n);
+        if(!selected(opt,name)) continue;
+
+        std::mt19937 rng(4321);
+        std::uniform_real_distribution<double> space(0.0,1000.0);
+        std::uniform_real_distribution<double> capLph(0.0,500.0);
+        std::vector<double> weight(n),cap(n),out(n);
+        double sumCap=0.0;
+        for(int i=0;i<n;++i){
+            weight[i]=space(rng);
+            cap[i]=capLph(rng);
+            sumCap+=cap[i];
+        }
+        FlowAllocator alloc;
+        alloc.reserve(n);
+        const int batch=qMax(1,4096/n);
+        double total=0.0;
+        BenchStats stats(name,double(n)*batch,"consumers");
+        runSamples(stats,50,scaled(opt,n>=100000?500:20000),[&]{
+            for(int k=0;k<batch;++k) total+=alloc.allocate(0.5*sumCap,weight.data(),cap.data(),nullptr,n,out.data());
+        });
+        doNotOptimize(total);
+        stats.report();
+    }
+}
+
+// 10k sitios independientes de 4 tanques: el pool reparte los subgrafos
+void benchGraph(const Options& opt){
+    const bool serial=selected(opt,"graph/step/serial");
+    const bool pooled=selected(opt,"graph/step/pool");
+    if(!serial&&!pooled) return;
+
+    const int sites=10000;
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<double> frac(0.1,0.9);
+    std::uniform_real_distribution<double> demand(0.0,600.0);
+    TankGraph g;
+    for(int s=0;s<sites;++s){
+        const int cistern=g.addTank(20000.0);
+        const int tower=g.addTank(5000.0);
+        const int zone1=g.addTank(1000.0);
+        const int zone2=g.addTank(1000.0);
+        for(int i:{cistern,tower,zone1,zone2}){
+            g.network().setInputMaxLph(i,3000.0);
+            g.network().setOutputMaxLph(i,3000.0);
+            g.network().setLevelL(i,g.network().capacityL(i)*frac(rng));
+        }
+        g.setSupplyLph(cistern,1500.0);
+        g.addPipe(cistern,tower,2000.0);
+        g.addPipe(tower,zone1,800.0);
+        g.addPipe(tower,zone2,800.0);
+        g.setDemandLph(zone1,demand(rng));
+        g.setDemandLph(zone2,demand(rng));
+    }
+    g.build();
+
+    int events=0;
+    if(serial){
+        BenchStats stats("graph/step/serial",double(g.tankCount()),"tank-ticks");
+        runSamples(stats,20,scaled(opt,500),[&]{ events+=g.step(5.0); });
+        stats.report();
+    }
+    if(pooled){
+        ThreadPool pool;
+        BenchStats stats("graph/step/pool",double(g.tankCount()),"tank-ticks");
+        runSamples(stats,20,scaled(opt,500),[&]{ events+=g.step(5.0,&pool); });
+        stats.report();
+    }
+    doNotOptimize(events);
+}
+
+// 1000 tanques descargando por gravedad durante 6 h. Con salida Q a tanque lleno
+// sqrt(L) baja lineal: sqrt(L)=sqrt(L0)-Q/(7200 sqrt(C)) t, asi que se puede
+// medir el error de cada integrador ademas del tiempo
+void benchIntegrator(const Options& opt){
+    const int n=1000;
+    const double horizonS=6*3600.0;
+
+    auto fill=[&](TankNetwork& net){
+        std::mt19937 rng(606);
+        std::uniform_real_distribution<double> cap(1000.0,5000.0);
+        std::uniform_real_distribution<double> frac(0.6,1.0);
+        net.resize(n);
+        for(int i=0;i<n;++i){
+            net.setCapacityL(i,cap(rng));
+            net.setLevelL(i,net.capacityL(i)*frac(rng));
+            net.setOutputMaxLph(i,0.05*net.capacityL(i));
+            net.settle(i);
+            net.applyOutputFlowLph(i,net.outputMaxLph(i));
+            net.setOutflowLaw(i,TankNetwork::OutflowGravity);
+        }
+    };
+    auto maxError=[&](const TankNetwork& start,const TankNetwork& net){
+        double err=0.0;
+        for(int i=0;i<n;++i){
+            const double s=std::sqrt(start.levelL(i))-start.outputFlowLph(i)/(7200.0*std::sqrt(start.capacityL(i)))*horizonS;
+            err=qMax(err,std::fabs(net.levelL(i)-s*s));
+        }
+        return err;
+    };
+
+    struct Case { const char* name; double euler; };
+    const Case cases[]={{"integrate/euler/0.2s",0.2},{"integrate/euler/60s",60.0},{"integrate/adaptive",0.0}};
+    for(const Case& c:cases){
+        if(!selected(opt,c.name)) continue;
+        TankNetwork start;
+        fill(start);
+        EulerIntegrator euler(c.euler>0.0?c.euler:0.2);
+        AdaptiveIntegrator adaptive;
+        Integrator& integrator=c.euler>0.0?static_cast<Integrator&>(euler):adaptive;
+        TankNetwork net;
+        BenchStats stats(c.name,double(n)*horizonS,"tank-s");
+        runSamples(stats,1,scaled(opt,c.euler>0.0&&c.euler<1.0?10:100),[&]{
+            net=start;
+            integrator.resetStats();
+            double t=0.0;
+            while(t<horizonS) t+=integrator.advance(net,horizonS-t);
+        });
+        stats.report();
+        std::printf("%s: error maximo %.3g L, %llu pasos (%llu rechazados)\n",
+                    c.name,maxError(start,net),integrator.steps(),integrator.rejectedSteps());
+    }
+}
+
+// planta de la GUI: 1000 L + 2 x 200 L
+void setupPlant(SimEngine& e){
+    e.setCapacityL(SimEngine::Principal,1000.0);
+    e.setCapacityL(SimEngine::Auxiliar1,200.0);
+    e.setCapacityL(SimEngine::Auxiliar2,200.0);
+    for(int i=0;i<e.tankCount();++i){
+        e.setInputMaxLph(i,500.0);
+        e.setOutputMaxLph(i,500.0);
+    }
+}
+
+void randomizeLevels(SimEngine& e,std::mt19937& rng){
+    std::uniform_real_distribution<double> frac(0.0,1.0);
+    for(int i=0;i<=SimEngine::Auxiliar2;++i) e.setLevelL(i,e.capacityL(i)*frac(rng));
+}
+
+void benchPlant(const Options& opt){
+    std::uniform_int_distribution<int> dial(0,100);
+    std::uniform_int_distribution<int> op(0,3);
+
+    if(selected(opt,"plant/step")){
+        std::mt19937 rng(99);
+        SimEngine e;
+        setupPlant(e);
+        randomizeLevels(e,rng);
+        e.setMainInputDial(80);
+        e.setMainOutputDial(60);
+        unsigned long long k=0;
+        BenchStats stats("plant/step",1.0,"steps");
+        runSamples(stats,1000,scaled(opt,200000),[&]{
+            // cada tanto se mueven los diales para que la planta no quede quieta
+            if((++k&1023)==0){
+                e.setMainInputDial(dial(rng));
+                e.applyDistributionFromDial(dial(rng));
+            }
+            e.step();
+        });
+        doNotOptimize(e.levelL(SimEngine::Principal));
+        stats.report();
+    }
+
+    if(selected(opt,"plant/applyDistributionFromDial")){
+        std::mt19937 rng(7);
+        SimEngine e;
+        setupPlant(e);
+        unsigned long long k=0;
+        BenchStats stats("plant/applyDistributionFromDial",1.0,"calls");
+        runSamples(stats,1000,scaled(opt,200000),[&]{
+            if((++k&255)==0) randomizeLevels(e,rng);
+            e.applyDistributionFromDial(dial(rng));
+        });
+        doNotOptimize(e.currentOutputLph(SimEngine::Principal));
+        stats.report();
+    }
+
+    if(selected(opt,"plant/dial-sweep")){
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<int> aux(SimEngine::Auxiliar1,SimEngine::Auxiliar2);
+        SimEngine e;
+        setupPlant(e);
+        unsigned long long k=0;
+        BenchStats stats("plant/dial-sweep",1.0,"commands");
+        runSamples(stats,1000,scaled(opt,200000),[&]{
+            if((++k&255)==0) randomizeLevels(e,rng);
+            switch(op(rng)){
+            case 0: e.setMainOutputDial(dial(rng)); break;
+            case 1: e.setMainInputDial(dial(rng)); break;
+            case 2: e.setAuxOutputDial(aux(rng),dial(rng)); break;
+            default: e.setAuxInputEnabled(aux(rng),dial(rng)>20); break;
+            }
+        });
+        doNotOptimize(e.currentOutputLph(SimEngine::Principal));
+        stats.report();
+    }
+}
+
+// misma receta para SimEngine y FixedPlant (tienen los mismos comandos)
+template<class Plant>
+void setupTopology(Plant& p,int tanks,std::mt19937& rng){
+    std::uniform_real_distribution<double> frac(0.0,1.0);
+    for(int i=0;i<tanks;++i){
+        p.setCapacityL(i,i==0?1000.0:200.0);
+        p.setInputMaxLph(i,500.0);
+        p.setOutputMaxLph(i,500.0);
+        p.setLevelL(i,p.capacityL(i)*frac(rng));
+    }
+    p.setMainInputDial(80);
+    p.setMainOutputDial(60);
+    for(int i=1;i<tanks;++i) p.setAuxOutputDial(i,30);
+}
+
+// 100 pasos; cada tanto se mueven los diales para que haya eventos
+template<class Plant>
+void runTopology(Plant& p,int tanks,std::mt19937& rng,unsigned long long& k){
+    std::uniform_int_distribution<int> dial(0,100);
+    std::uniform_int_distribution<int> aux(1,tanks-1);
+    for(int s=0;s<100;++s){
+        if((++k&1023)==0){
+            p.setMainInputDial(dial(rng));
+            p.applyDistributionFromDial(dial(rng));
+            p.setAuxOutputDial(aux(rng),dial(rng));
+        }
+        p.step();
+    }
+}
+
+template<int K>
+void benchTopology(const Options& opt){
+    constexpr int tanks=FixedPlant<K>::Tanks;
+    char runtimeName[64];
+    char fixedName[64];
+    std::snprintf(runtimeName,sizeof(runtimeName),"plant/topology/runtime/%d",K);
+    std::snprintf(fixedName,sizeof(fixedName),"plant/topology/fixed/%d",K);
+    const bool runtime=selected(opt,runtimeName);
+    const bool fixed=selected(opt,fixedName);
+    const int samples=scaled(opt,20000);
+
+    SimEngine e;
+    while(e.tankCount()<tanks) e.addTank();
+    std::vector<int> consumers;
+    for(int i=1;i<tanks;++i) consumers.push_back(i);
+    e.setConsumers(consumers);
+    if(runtime){
+        std::mt19937 rng(99);
+        setupTopology(e,tanks,rng);
+        unsigned long long k=0;
+        BenchStats stats(runtimeName,100.0,"steps");
+        runSamples(stats,100,samples,[&]{ runTopology(e,tanks,rng,k); });
+        doNotOptimize(e.levelL(SimEngine::Principal));
+        stats.report();
+    }
+
+    FixedPlant<K> p;
+    if(fixed){
+        std::mt19937 rng(99);
+        setupTopology(p,tanks,rng);
+        unsigned long long k=0;
+        BenchStats stats(fixedName,100.0,"steps");
+        runSamples(stats,100,samples,[&]{ runTopology(p,tanks,rng,k); });
+        doNotOptimize(p.levelL(FixedPlant<K>::Principal));
+        stats.report();
+    }
+
+    // con la misma semilla y los mismos pasos tienen que terminar igual
+    if(runtime&&fixed){
+        double diff=0.0;
+        for(int i=0;i<tanks;++i) diff=std::max(diff,std::fabs(e.levelL(i)-p.levelL(i)));
+        std::printf("plant/topology/%d: diferencia maxima %.3g L contra SimEngine\n",K,diff);
+    }
+}
+
+void benchTopologies(const Options& opt){
+    benchTopology<2>(opt);
+    benchTopology<8>(opt);
+}
+
+// lo que cuesta cada movimiento de dial en la GUI: el worker vuelve a proyectar
+void benchForecast(const Options& opt){
+    for(int consumers:{2,1000}){
+        char name[64];
+        std::snprintf(name,sizeof(name),"forecast/update/%d",consumers);
+        if(!selected(opt,name)) continue;
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> dial(0,100);
+        SimEngine e;
+        while(e.tankCount()<consumers+1) e.addTank();
+        std::vector<int> list;
+        for(int i=1;i<=consumers;++i) list.push_back(i);
+        e.setConsumers(list);
+        setupTopology(e,e.tankCount(),rng);
+        // principal con agua para todos, asi cada proyeccion llena a los consumidores
+        e.setCapacityL(SimEngine::Principal,1000.0*consumers);
+        e.setLevelL(SimEngine::Principal,900.0*consumers);
+        e.setOutputMaxLph(SimEngine::Principal,500.0*consumers);
+        Forecast f;
+        BenchStats stats(name,1.0,"updates");
+        runSamples(stats,3,scaled(opt,consumers>100?30:20000),[&]{
+            e.setMainOutputDial(dial(rng));
+            f.update(e);
+        });
+        doNotOptimize(f.fullAtS(1));
+        stats.report();
+    }
+}
+
+// lo que hacia "Aplicar" antes (cada tanque + reparto completo) contra el cambio
+// de un solo campo; la mitad de los tanques son consumidores del principal
+void benchConfigApply(const Options& opt){
+    const int n=10000;
+    const bool full=selected(opt,"config/full/10000");
+    const bool diff=selected(opt,"config/diff/10000");
+    if(!full&&!diff) return;
+    std::mt19937 rng(21);
+    std::uniform_int_distribution<int> tank(1,n-1);
+    std::uniform_int_distribution<int> lph(100,500);
+    SimEngine e;
+    while(e.tankCount()<n) e.addTank();
+    std::vector<int> consumers;
+    for(int i=1;i<n;i+=2) consumers.push_back(i);
+    e.setConsumers(consumers);
+    setupTopology(e,n,rng);
+    e.setCapacityL(SimEngine::Principal,1e7);
+    e.setLevelL(SimEngine::Principal,5e6);
+    e.setOutputMaxLph(SimEngine::Principal,1e6);
+    e.setMainOutputDial(60);
+
+    if(full){
+        BenchStats stats("config/full/10000",1.0,"applies");
+        runSamples(stats,3,scaled(opt,100),[&]{
+            const int changed=tank(rng);
+            const double v=lph(rng);
+            for(int i=0;i<n;++i) e.setInputMaxLph(i,i==changed?v:e.inputMaxLph(i));
+            for(int i=1;i<n;++i) e.setAuxOutputDial(i,e.auxOutputDial(i));
+            e.applyDistributionFromDial(e.mainOutputDial());
+        });
+        doNotOptimize(e.currentOutputLph(SimEngine::Principal));
+        stats.report();
+    }
+    if(diff){
+        BenchStats stats("config/diff/10000",1.0,"applies");
+        runSamples(stats,3,scaled(opt,1000),[&]{
+            e.updateInputMaxLph(tank(rng),lph(rng));
+        });
+        doNotOptimize(e.currentOutputLph(SimEngine::Principal));
+        stats.report();
+    }
+}
+
+void benchJson(const Options& opt){
+    const int sizes[]={3,1000,100000};
+    for(int n:sizes){
+        char name[64];
+        std::snprintf(name,sizeof(name),"json/roundtrip/%d",n);
+        if(!selected(opt,name)) continue;
+
+        std::mt19937 rng(5);
+        SimEngine src;
+        for(int i=src.tankCount();i<n;++i) src.addTank();
+        fillNetwork(src.network(),n,rng);
+        SimEngine dst;
+
+        const QByteArray probe=QJsonDocument(stateToJson(src)).toJson(QJsonDocument::Compact);
+        BenchStats stats(name,double(probe.size()),"B");
+        bool ok=true;
+        runSamples(stats,2,scaled(opt,n>=100000?20:(n>=1000?500:20000)),[&]{
+            QByteArray bytes=QJsonDocument(stateToJson(src)).toJson(QJsonDocument::Compact);
+            QJsonDocument doc=QJsonDocument::fromJson(bytes);
+            ok=ok&&doc.isObject()&&stateFromJson(dst,doc.object());
+        });
+        if(!ok) std::printf("%s: el JSON no volvio a cargar\n",name);
+        doNotOptimize(dst.levelL(n-1));
+        stats.report();
+    }
+}
+
+// la misma ida y vuelta que json/roundtrip pero con la foto binaria mapeada
+void benchBinarySnapshot(const Options& opt){
+    const int sizes[]={3,1000,100000};
+    for(int n:sizes){
+        char name[64];
+        std::snprintf(name,sizeof(name),"snapshot/roundtrip/%d",n);
+        if(!selected(opt,name)) continue;
+
+        std::mt19937 rng(5);
+        SimEngine src;
+        for(int i=src.tankCount();i<n;++i) src.addTank();
+        fillNetwork(src.network(),n,rng);
+        SimEngine dst;
+
+        QTemporaryFile tmp;
+        if(!tmp.open()){ std::printf("%s: no se pudo crear el archivo temporal\n",name); continue; }
+        const QString path=tmp.fileName();
+        tmp.close();
+        if(!writeSnapshotFile(src,path)){ std::printf("%s: error al escribir\n",name); continue; }
+        const qint64 bytes=QFileInfo(path).size();
+
+        BenchStats stats(name,double(bytes),"B");
+        bool ok=true;
+        runSamples(stats,2,scaled(opt,n>=100000?200:(n>=1000?2000:20000)),[&]{
+            SnapshotFile file;
+            ok=ok&&writeSnapshotFile(src,path)&&file.open(path);
+            file.restore(dst);
+        });
+        if(!ok) std::printf("%s: la foto no volvio a cargar\n",name);
+        doNotOptimize(dst.levelL(n-1));
+        stats.report();
+    }
+}
+
+#if defined(_WIN32)
+#define benchSeek _fseeki64
+#define benchTell _ftelli64
+#else
+#define benchSeek fseeko
+#define benchTell ftello
+#endif
+
+// pistas de 1 a 8 millones de muestras hasta llegar al tamano pedido
+bool writeAudioList(const QString& path,qint64 bytes){
+    FILE* f=std::fopen(path.toLocal8Bit().constData(),"wb");
+    if(!f) return false;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<uint32_t> count(1u<<20,8u<<20);
+    std::vector<float> chunk(1<<16,0.25f);
+    qint64 written=0;
+    while(written<bytes){
+        pistas p;
+        p.samplerate=uint32_t(rng()%4u);
+        p.samplecount=count(rng);
+        std::fwrite(&p,sizeof(p),1,f);
+        uint32_t left=p.samplecount;
+        while(left>0){
+            size_t n=qMin<size_t>(left,chunk.size());
+            std::fwrite(chunk.data(),sizeof(float),n,f);
+            left-=uint32_t(n);
+        }
+        written+=qint64(sizeof(p))+qint64(p.samplecount)*qint64(sizeof(float));
+    }
+    return std::fclose(f)==0;
+}
+
+// lo que hacia main.c antes del mapeo: una pasada para contar pistas y otra que las copia a memoria
+qint64 loadAudioList(const QString& path,int& tracks){
+    FILE* f=std::fopen(path.toLocal8Bit().constData(),"rb");
+    if(!f) return -1;
+    benchSeek(f,0,SEEK_END);
+    const qint64 total=benchTell(f);
+    benchSeek(f,0,SEEK_SET);
+
+    pistas audio;
+    int n=0;
+    while(benchTell(f)<total){
+        if(std::fread(&audio,sizeof(audio),1,f)!=1) break;
+        benchSeek(f,qint64(audio.samplecount)*qint64(sizeof(float)),SEEK_CUR);
+        n++;
+    }
+    benchSeek(f,0,SEEK_SET);
+
+    std::vector<float*> canciones(n,nullptr);
+    for(int i=0;i<n;i++){
+        if(std::fread(&audio,sizeof(audio),1,f)!=1) break;
+        canciones[i]=static_cast<float*>(std::malloc(audio.samplecount*sizeof(float)));
+        if(!canciones[i]) break;
+        if(std::fread(canciones[i],sizeof(float),audio.samplecount,f)!=audio.samplecount) break;
+    }
+    for(float* c:canciones) std::free(c);
+    std::fclose(f);
+    tracks=n;
+    return total;
+}
+
+// hasta la primera muestra que recibe play_audio: leyendo del disco (un bloque)
+// y con la pista ya en el cache
+struct FirstSample {
+    BenchStats::Clock::time_point start;
+    BenchStats::Clock::time_point first;
+    bool seen=false;
+};
+
+void firstSampleSink(uint32_t,uint32_t,float*,void* ctx){
+    FirstSample* f=static_cast<FirstSample*>(ctx);
+    if(!f->seen){ f->first=BenchStats::Clock::now(); f->seen=true; }
+}
+
+void benchAudioStream(const Options& opt,const char* path){
+    const bool cold=selected(opt,"audio/stream/first-sample");
+    const bool cached=selected(opt,"audio/stream/cached");
+    if(!cold&&!cached) return;
+    audio_list l;
+    if(audio_list_open(&l,path)!=0||l.n==0){ std::printf("audio/stream: no hay pistas\n"); return; }
+
+    const int samples=scaled(opt,20);
+    if(cold){
+        BenchStats stats("audio/stream/first-sample",1.0,"tracks");
+        for(int k=0;k<samples;++k){
+            FirstSample f;
+            f.start=BenchStats::Clock::now();
+            audio_stream_play(&l,k%l.n,nullptr,firstSampleSink,&f);
+            stats.add(f.first-f.start);
+        }
+        stats.report();
+    }
+    if(cached){
+        audio_cache* cache=audio_cache_new(~0ull);
+        FirstSample warm;
+        audio_stream_play(&l,0,cache,firstSampleSink,&warm);
+        BenchStats stats("audio/stream/cached",1.0,"tracks");
+        for(int k=0;k<samples;++k){
+            FirstSample f;
+            f.start=BenchStats::Clock::now();
+            audio_stream_play(&l,0,cache,firstSampleSink,&f);
+            stats.add(f.first-f.start);
+        }
+        stats.report();
+        audio_cache_free(cache);
+    }
+    audio_list_close(&l);
+}
+
+// lo que hace main.c al abrir: validar y resumir todas las pistas con un hilo
+// por nucleo, y despues leerlo del .sum sin tocar las muestras
+void benchAudioSummary(const Options& opt,const char* path,qint64 total){
+    audio_list l;
+    if(audio_list_open_indexed(&l,path)!=0){ std::printf("audio/summary: no se pudo abrir\n"); return; }
+    if(selected(opt,"audio/summary/build")){
+        BenchStats stats("audio/summary/build",double(total),"B");
+        uint32_t invalid=0;
+        runSamples(stats,1,opt.quick?2:5,[&]{
+            audio_resumenes r;
+            if(audio_summary_build(&l,&r,0)==0){
+                invalid=0;
+                for(int i=0;i<r.n;++i) invalid+=r.pistas[i].no_finitas;
+                audio_summary_free(&r);
+            }
+        });
+        stats.report();
+        if(invalid) std::printf("audio/summary/build: %u muestras no finitas\n",invalid);
+    }
+    if(selected(opt,"audio/summary/cache")){
+        {
+            audio_resumenes r;
+            if(audio_summary_open(&l,path,&r,0)==0) audio_summary_free(&r);
+        }
+        BenchStats stats("audio/summary/cache",double(total),"B");
+        int fromCache=0;
+        runSamples(stats,1,scaled(opt,50),[&]{
+            audio_resumenes r;
+            if(audio_summary_open(&l,path,&r,0)==0) fromCache=r.desde_cache;
+            audio_summary_free(&r);
+        });
+        stats.report();
+        if(!fromCache) std::printf("audio/summary/cache: el .sum no se uso\n");
+    }
+    audio_list_close(&l);
+}
+
+void benchAudioLoader(const Options& opt){
+    const bool copyLoad=selected(opt,"audio/load/fread");
+    const bool mapLoad=selected(opt,"audio/load/mmap");
+    const bool indexLoad=selected(opt,"audio/load/index");
+    const bool stream=selected(opt,"audio/stream/first-sample")||selected(opt,"audio/stream/cached");
+    const bool summary=selected(opt,"audio/summary/build")||selected(opt,"audio/summary/cache");
+    if(!copyLoad&&!mapLoad&&!indexLoad&&!stream&&!summary) return;
+
+    QTemporaryFile tmp;
+    QString path=opt.rawPath;
+    if(path.isEmpty()){
+        if(!tmp.open()){ std::printf("audio: no se pudo crear el archivo temporal\n"); return; }
+        path=tmp.fileName();
+        tmp.close();
+        std::printf("audio: generando %lld MB en %s\n",opt.rawMb,path.toLocal8Bit().constData());
+        std::fflush(stdout);
+        if(!writeAudioList(path,opt.rawMb<<20)){ std::printf("audio: error al escribir\n"); return; }
+    }
+
+    int tracks=0;
+    const qint64 total=loadAudioList(path,tracks);
+    if(total<0){ std::printf("audio: no se pudo abrir %s\n",path.toLocal8Bit().constData()); return; }
+    std::printf("audio: %d pistas, %lld bytes (cache de paginas caliente)\n",tracks,total);
+
+    if(copyLoad){
+        BenchStats stats("audio/load/fread",double(total),"B");
+        runSamples(stats,1,opt.quick?2:5,[&]{ loadAudioList(path,tracks); });
+        stats.report();
+    }
+
+    // main.c ahora: mapeo y tabla de pistas en una pasada, sin copiar muestras
+    const QByteArray local=path.toLocal8Bit();
+    if(mapLoad){
+        BenchStats stats("audio/load/mmap",double(total),"B");
+        int mapped=0;
+        runSamples(stats,1,scaled(opt,50),[&]{
+            audio_list l;
+            if(audio_list_open(&l,local.constData())==0) mapped=l.n;
+            audio_list_close(&l);
+        });
+        stats.report();
+        if(mapped!=tracks) std::printf("audio/load/mmap: %d pistas en vez de %d\n",mapped,tracks);
+    }
+
+    // con el .idx al dia: no se recorre el archivo (la primera vez lo arma)
+    if(indexLoad){
+        {
+            audio_list l;
+            if(audio_list_open_indexed(&l,local.constData())==0) audio_list_close(&l);
+        }
+        BenchStats stats("audio/load/index",double(total),"B");
+        int fromIndex=0;
+        runSamples(stats,1,scaled(opt,50),[&]{
+            audio_list l;
+            if(audio_list_open_indexed(&l,local.constData())==0) fromIndex=l.desde_indice?l.n:-1;
+            audio_list_close(&l);
+        });
+        stats.report();
+        if(fromIndex!=tracks) std::printf("audio/load/index: el indice no se uso o no coincide\n");
+    }
+
+    if(stream) benchAudioStream(opt,local.constData());
+    if(summary) benchAudioSummary(opt,local.constData(),total);
+    if(opt.rawPath.isEmpty()){
+        QFile::remove(path+".idx");
+        QFile::remove(path+".sum");
+    }
+}
+
+// lo que hace main.c con cada bloque antes de play_audio, sobre un minuto de
+// pista por cada frecuencia del archivo; el trabajo son muestras de entrada, asi
+// que throughput/hz dice cuantas veces mas rapido que tiempo real
+void benchAudioDsp(const Options& opt){
+    const audio_simd levels[]={AUDIO_SIMD_ESCALAR,AUDIO_SIMD_SSE,AUDIO_SIMD_AVX2};
+    const uint32_t rates[]={44100,88200};
+    const audio_simd cpu=audio_simd_detect();
+    std::mt19937 rng(20);
+    std::uniform_real_distribution<float> noise(-0.1f,0.1f);
+
+    for(uint32_t hz:rates){
+        std::vector<float> track(std::size_t(hz)*60);
+        for(std::size_t i=0;i<track.size();++i)
+            track[i]=0.6f*float(std::sin(6.283185307179586*440.0*double(i)/hz))+noise(rng);
+        for(audio_simd level:levels){
+            char name[64];
+            std::snprintf(name,sizeof(name),"audio/resample/%u/%s",hz,audio_simd_name(level));
+            if(!selected(opt,name)||level>cpu) continue;
+            audio_simd_set(level);
+            audio_resampler r;
+            if(audio_resampler_init(&r,hz,48000,0.8f)!=0) continue;
+            std::vector<float> out(audio_resampler_max_out(&r,AUDIO_BLOQUE_MUESTRAS));
+            double produced=0;
+            BenchStats stats(name,double(track.size()),"samples");
+            runSamples(stats,1,scaled(opt,10),[&]{
+                audio_resampler_reset(&r);
+                produced=0;
+                for(std::size_t k=0;k<track.size();k+=AUDIO_BLOQUE_MUESTRAS){
+                    const uint32_t n=uint32_t(qMin<std::size_t>(AUDIO_BLOQUE_MUESTRAS,track.size()-k));
+                    produced+=audio_resampler_process(&r,track.data()+k,n,out.data());
+                }
+                doNotOptimize(out[0]);
+            });
+            stats.report();
+            std::printf("%s: %.0fx tiempo real, %.0f muestras a 48 kHz\n",name,stats.throughputPerS()/hz,produced);
+            audio_resampler_free(&r);
+        }
+    }
+
+    std::vector<float> block(AUDIO_BLOQUE_MUESTRAS);
+    for(float& v:block) v=noise(rng)*10.0f;
+    std::vector<float> out(block.size());
+    for(audio_simd level:levels){
+        char gainName[64];
+        char measureName[64];
+        std::snprintf(gainName,sizeof(gainName),"audio/gain/%s",audio_simd_name(level));
+        std::snprintf(measureName,sizeof(measureName),"audio/measure/%s",audio_simd_name(level));
+        if(level>cpu) continue;
+        audio_simd_set(level);
+        if(selected(opt,gainName)){
+            BenchStats stats(gainName,double(block.size()),"samples");
+            runSamples(stats,100,scaled(opt,5000),[&]{ audio_gain(out.data(),block.data(),uint32_t(block.size()),0.9f); });
+            doNotOptimize(out[1]);
+            stats.report();
+        }
+        if(selected(opt,measureName)){
+            BenchStats stats(measureName,double(block.size()),"samples");
+            float peak=0;
+            double energy=0;
+            runSamples(stats,100,scaled(opt,5000),[&]{ audio_measure(block.data(),uint32_t(block.size()),&peak,&energy); });
+            doNotOptimize(peak+energy);
+            stats.report();
+        }
+    }
+    audio_simd_set(cpu);
+}
+
+}
+
+int main(int argc,char* argv[]){
+    QCoreApplication app(argc,argv);
+    QCoreApplication::setApplicationName("aguabench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks del motor de tanques y del audio");
+    parser.addHelpOption();
+    QCommandLineOption filterOpt(QStringList{"f","filter"},"Solo los benchmarks cuyo nombre contiene <texto>.","texto");
+    QCommandLineOption quickOpt(QStringList{"q","quick"},"Menos muestras (para CI).");
+    QCommandLineOption rawOpt("raw","Usa un audio_list.raw existente en vez de generar uno.","archivo");
+    QCommandLineOption rawMbOpt("raw-mb","Tamano del audio_list.raw generado, en MB (por defecto 256).","mb","256");
+    parser.addOption(filterOpt);
+    parser.addOption(quickOpt);
+    parser.addOption(rawOpt);
+    parser.addOption(rawMbOpt);
+    parser.process(app);
+
+    Options opt;
+    opt.filter=parser.value(filterOpt);
+    opt.quick=parser.isSet(quickOpt);
+    opt.rawPath=parser.value(rawOpt);
+    opt.rawMb=qMax<qint64>(1,parser.value(rawMbOpt).toLongLong());
+
+    benchTick(opt);
+    benchRecorder(opt);
+    benchAllocator(opt);
+    benchGraph(opt);
+    benchIntegrator(opt);
+    benchPlant(opt);
+    benchTopologies(opt);
+    benchForecast(opt);
+    benchConfigApply(opt);
+    benchJson(opt);
+    benchBinarySnapshot(opt);
+    benchAudioLoader(opt);
+    benchAudioDsp(opt);
+    return 0;
+}
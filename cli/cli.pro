@@ -0,0 +1,14 @@
+# Escenarios guionados sin GUI, lo mas rapido posible (CI y corridas nocturnas):
+#   aguacli escenario.json [-o serie.csv] [--state final.json]
+# Solo QtCore y el motor. El formato del escenario esta en engine/simjson.h.
+
+TEMPLATE = app
+TARGET = aguacli
+QT = core
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+SOURCES += \
+    main.cpp
+
+include(../engine/engine.pri)
@@ -0,0 +1,108 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <cstdio>
+
+#include "scenario.h"
+#include "simjson.h"
+
+static QByteArray tankName(int i){
+    if(i==SimEngine::Principal) return "principal";
+    if(i==SimEngine::Auxiliar1) return "aux1";
+    if(i==SimEngine::Auxiliar2) return "aux2";
+    return "extra"+QByteArray::number(i-SimEngine::Auxiliar2-1);
+}
+
+// una fila por muestra: tiempo y, por tanque, nivel y caudales
+static void writeHeader(std::FILE* out,const SimEngine& engine){
+    std::fputs("t_s",out);
+    for(int i=0;i<engine.tankCount();++i){
+        const QByteArray name=tankName(i);
+        std::fprintf(out,",%s_L,%s_in_Lph,%s_out_Lph",name.constData(),name.constData(),name.constData());
+    }
+    std::fputc('\n',out);
+}
+
+static void writeRow(std::FILE* out,const SimEngine& engine){
+    std::fprintf(out,"%.9g",engine.timeS());
+    for(int i=0;i<engine.tankCount();++i)
+        std::fprintf(out,",%.9g,%.9g,%.9g",engine.levelL(i),engine.currentInputLph(i),engine.currentOutputLph(i));
+    std::fputc('\n',out);
+}
+
+int main(int argc,char* argv[]){
+    QElapsedTimer wall;
+    wall.start();
+    QCoreApplication app(argc,argv);
+    QCoreApplication::setApplicationName("aguacli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Corre un escenario guionado de la planta sin GUI");
+    parser.addHelpOption();
+    parser.addPositionalArgument("escenario","Escenario (JSON).");
+    QCommandLineOption outputOpt(QStringList{"o","output"},"CSV con las muestras (por defecto la salida estandar).","archivo");
+    QCommandLineOption stateOpt("state","Estado final en JSON (formato de sim_state.json).","archivo");
+    parser.addOption(outputOpt);
+    parser.addOption(stateOpt);
+    parser.process(app);
+
+    const QStringList args=parser.positionalArguments();
+    if(args.size()!=1) parser.showHelp(1);
+
+    QFile f(args.at(0));
+    if(!f.open(QIODevice::ReadOnly)){
+        std::fprintf(stderr,"no se pudo abrir %s\n",args.at(0).toLocal8Bit().constData());
+        return 1;
+    }
+    const QJsonDocument doc=QJsonDocument::fromJson(f.readAll());
+    Scenario scenario;
+    QString error;
+    if(!doc.isObject()||!scenarioFromJson(doc.object(),scenario,&error)){
+        std::fprintf(stderr,"escenario invalido: %s\n",error.toLocal8Bit().constData());
+        return 1;
+    }
+
+    std::FILE* out=stdout;
+    if(parser.isSet(outputOpt)){
+        out=std::fopen(parser.value(outputOpt).toLocal8Bit().constData(),"w");
+        if(!out){
+            std::fprintf(stderr,"no se pudo escribir %s\n",parser.value(outputOpt).toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    static char buffer[1<<16];
+    std::setvbuf(out,buffer,_IOFBF,sizeof(buffer));
+
+    SimEngine engine;
+    prepareScenario(engine,scenario);
+    writeHeader(out,engine);
+    const double startupMs=wall.nsecsElapsed()/1e6;
+    QElapsedTimer run;
+    run.start();
+    const int applied=playScenario(engine,scenario,[out](const SimEngine& e){ writeRow(out,e); });
+    const double runS=run.nsecsElapsed()/1e9;
+    const bool written=std::fflush(out)==0&&!std::ferror(out);
+    if(out!=stdout) std::fclose(out);
+    if(!written){
+        std::fprintf(stderr,"error al escribir la serie\n");
+        return 1;
+    }
+
+    if(parser.isSet(stateOpt)){
+        QFile state(parser.value(stateOpt));
+        if(!state.open(QIODevice::WriteOnly|QIODevice::Truncate)
+           ||state.write(QJsonDocument(stateToJson(engine)).toJson())<0){
+            std::fprintf(stderr,"no se pudo escribir %s\n",parser.value(stateOpt).toLocal8Bit().constData());
+            return 1;
+        }
+    }
+
+    // el resumen va a stderr para no mezclarse con la serie
+    std::fprintf(stderr,"%llu ticks, %.1f s simulados, %d eventos en %.3f s (%.0fx tiempo real), arranque %.1f ms\n",
+                 engine.tickCount(),engine.timeS(),applied,runS,runS>0.0?engine.timeS()/runS:0.0,startupMs);
+    return 0;
+}
@@ -0,0 +1,66 @@
+# Nucleo de simulacion sin widgets, compartido por la GUI y los demas targets.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/flowallocator.cpp \
+    $$PWD/forecast.cpp \
+    $$PWD/inputlog.cpp \
+    $$PWD/integrator.cpp \
+    $$PWD/journal.cpp \
+    $$PWD/metrics.cpp \
+    $$PWD/recorder.cpp \
+    $$PWD/scenario.cpp \
+    $$PWD/simcommand.cpp \
+    $$PWD/simengine.cpp \
+    $$PWD/simjson.cpp \
+    $$PWD/simsnapshot.cpp \
+    $$PWD/simworker.cpp \
+    $$PWD/snapshotfile.cpp \
+    $$PWD/sweep.cpp \
+    $$PWD/tankgraph.cpp \
+    $$PWD/tanknetwork.cpp \
+    $$PWD/threadpool.cpp \
+    $$PWD/tickscheduler.cpp
+
+HEADERS += \
+    $$PWD/fixedplant.h \
+    $$PWD/flowallocator.h \
+    $$PWD/forecast.h \
+    $$PWD/inputlog.h \
+    $$PWD/integrator.h \
+    $$PWD/journal.h \
+    $$PWD/metrics.h \
+    $$PWD/plantrules.h \
+    $$PWD/recorder.h \
+    $$PWD/scenario.h \
+    $$PWD/simcommand.h \
+    $$PWD/simengine.h \
+    $$PWD/simjson.h \
+    $$PWD/simsnapshot.h \
+    $$PWD/simworker.h \
+    $$PWD/snapshotfile.h \
+    $$PWD/spscqueue.h \
+    $$PWD/sweep.h \
+    $$PWD/tankgraph.h \
+    $$PWD/tankkernel.h \
+    $$PWD/tanknetwork.h \
+    $$PWD/threadpool.h \
+    $$PWD/tickscheduler.h \
+    $$PWD/triplebuffer.h
+
+# El tick de TankNetwork esta escrito sin ramas para que se vectorice. Con gcc/clang
+# hace falta -fno-trapping-math (si no, las comparaciones no se convierten en selects).
+# Con "qmake CONFIG+=simd_native" se compila para la CPU local (AVX2 si esta).
+gcc|clang {
+    QMAKE_CXXFLAGS += -fno-trapping-math
+    QMAKE_CXXFLAGS_RELEASE -= -O2
+    QMAKE_CXXFLAGS_RELEASE += -O3
+    simd_native: QMAKE_CXXFLAGS += -march=native
+}
+msvc: simd_native: QMAKE_CXXFLAGS += /arch:AVX2
+
+# Instrumentacion del lazo (metrics.h): activa salvo con "qmake CONFIG+=no_metrics",
+# que saca todos los puntos de medicion del codigo.
+!no_metrics: DEFINES += AGUA_METRICS
@@ -0,0 +1,8 @@
+# Libreria estatica del motor de simulacion (solo QtCore, sin QtGui ni QtWidgets)
+
+TEMPLATE = lib
+TARGET = aguaengine
+CONFIG += staticlib c++17
+QT -= gui
+
+include(engine.pri)
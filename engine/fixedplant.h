@@ -0,0 +1,193 @@
+#ifndef FIXEDPLANT_H
+#define FIXEDPLANT_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "flowallocator.h"
+#include "plantrules.h"
+#include "simengine.h"
+#include "tankkernel.h"
+
+// La planta de SimEngine con la forma fija en tiempo de compilacion: el principal
+// (tanque 0) y K consumidores (1..K), salida de caudal constante y paso fijo.
+// Todo vive en arreglos de tamano K+1 dentro del objeto, asi que los loops tienen
+// cantidad constante (el compilador los desenrolla) y nada reserva memoria.
+//
+// Las reglas de la planta son las mismas que usa SimEngine (PlantRules: diales,
+// reacciones a los eventos, llenado de agua entre los consumidores) y el tick es
+// el de tankkernel.h, asi que dan el mismo resultado; SimEngine
+// sigue siendo el camino general (tanques agregados, consumidores a eleccion,
+// gravedad, modos Analytic y Adaptive, observador). Con load()/store() se pasa el
+// estado de uno a otro.
+
+template<int K>
+class FixedPlant : public PlantRules<FixedPlant<K>> {
+    using Rules=PlantRules<FixedPlant<K>>;
+    friend Rules;
+    using Rules::m_inDial;
+    using Rules::m_outDial;
+
+public:
+    static_assert(K>=1,"la planta necesita al menos un consumidor");
+
+    static constexpr int Principal=0;
+    static constexpr int Consumers=K;
+    static constexpr int Tanks=K+1;
+
+    explicit FixedPlant(double tickS=0.2)
+        : m_tickS(tickS>0.0?tickS:0.2)
+    {
+        m_capacityL.fill(100.0);
+        m_levelL.fill(0.0);
+        m_inputFlowLph.fill(0.0);
+        m_outputFlowLph.fill(0.0);
+        m_inputMaxLph.fill(100.0);
+        m_outputMaxLph.fill(100.0);
+        m_inputEnabled.fill(1);
+        m_canWithdraw.fill(0);
+        m_events.fill(0);
+        m_auxOutDial.fill(0);
+    }
+
+    // false (sin tocar nada) si el motor no tiene esta forma: K+1 tanques, los
+    // consumidores 1..K en ese orden y ningun caudal que dependa del nivel
+    bool load(const SimEngine& e){
+        if(!fits(e)) return false;
+        const TankNetwork& net=e.network();
+        for(int i=0;i<Tanks;++i){
+            m_capacityL[i]=net.capacityL(i);
+            m_levelL[i]=net.levelL(i);
+            m_inputFlowLph[i]=net.inputFlowLph(i);
+            m_outputFlowLph[i]=net.outputFlowLph(i);
+            m_inputMaxLph[i]=net.inputMaxLph(i);
+            m_outputMaxLph[i]=net.outputMaxLph(i);
+            m_inputEnabled[i]=net.isInputEnabled(i);
+            m_canWithdraw[i]=net.canWithdraw(i);
+            m_events[i]=0;
+            m_auxOutDial[i]=e.auxOutputDial(i);
+        }
+        m_tickS=e.tickS();
+        m_timeS=e.timeS();
+        m_ticks=e.tickCount();
+        m_inDial=e.mainInputDial();
+        m_outDial=e.mainOutputDial();
+        return true;
+    }
+
+    static bool fits(const SimEngine& e){
+        if(e.tankCount()!=Tanks||e.integrator()||e.network().hasLevelDependentFlows()) return false;
+        const std::vector<int>& c=e.consumers();
+        if(int(c.size())!=K) return false;
+        for(int k=0;k<K;++k) if(c[k]!=k+1) return false;
+        return true;
+    }
+
+    // deja el motor con esta planta (cantidad de tanques, consumidores y estado)
+    void store(SimEngine& e)const{
+        e.network().restore(Tanks,m_capacityL.data(),m_levelL.data(),
+                            m_inputFlowLph.data(),m_outputFlowLph.data(),
+                            m_inputMaxLph.data(),m_outputMaxLph.data(),
+                            m_inputEnabled.data(),m_canWithdraw.data());
+        e.setTickS(m_tickS);
+        e.restore(m_timeS,m_ticks,m_inDial,m_outDial,m_auxOutDial.data());
+        std::vector<int> consumers(K);
+        for(int k=0;k<K;++k) consumers[k]=k+1;
+        e.setConsumers(consumers);
+    }
+
+    double tickS()const{return m_tickS;}
+    void setTickS(double s){ if(s>0.0) m_tickS=s; }
+    double timeS()const{return m_timeS;}
+    unsigned long long tickCount()const{return m_ticks;}
+
+    void step(unsigned long long n=1){
+        for(unsigned long long k=0;k<n;++k){
+            if(tickKernel(m_capacityL.data(),m_levelL.data(),m_inputFlowLph.data(),m_outputFlowLph.data(),
+                          m_canWithdraw.data(),m_events.data(),Tanks,m_tickS)>0) dispatchEvents();
+            ++m_ticks;
+            m_timeS+=m_tickS;
+        }
+    }
+
+    //parametros por tanque (mismas reglas que TankNetwork)
+
+    void setCapacityL(int i,double L){
+        const double newCap=L>1.0?L:1.0;
+        if(m_levelL[i]>newCap) m_levelL[i]=newCap;
+        m_capacityL[i]=newCap;
+    }
+    void setLevelL(int i,double L){ m_levelL[i]=L; }
+    void setInputMaxLph(int i,double Lph){ m_inputMaxLph[i]=Lph>0.0?Lph:0.0; }
+    void setOutputMaxLph(int i,double Lph){ m_outputMaxLph[i]=Lph>0.0?Lph:0.0; }
+
+    void setInputEnabled(int i,bool enabled){
+        m_inputEnabled[i]=enabled?1:0;
+        if(!enabled) m_inputFlowLph[i]=0.0;
+    }
+
+    void applyInputFlowLph(int i,double Lph){
+        if(!m_inputEnabled[i]||m_levelL[i]>=m_capacityL[i]){ m_inputFlowLph[i]=0.0; return; }
+        m_inputFlowLph[i]=Lph<m_inputMaxLph[i]?Lph:m_inputMaxLph[i];
+    }
+
+    void applyOutputFlowLph(int i,double Lph){
+        if(m_levelL[i]<=0.1*m_capacityL[i]){ m_outputFlowLph[i]=0.0; return; }
+        m_outputFlowLph[i]=Lph<m_outputMaxLph[i]?Lph:m_outputMaxLph[i];
+    }
+
+    double capacityL(int i)const{return m_capacityL[i];}
+    double levelL(int i)const{return m_levelL[i];}
+    double inputMaxLph(int i)const{return m_inputMaxLph[i];}
+    double outputMaxLph(int i)const{return m_outputMaxLph[i];}
+    double currentInputLph(int i)const{return m_inputFlowLph[i];}
+    double currentOutputLph(int i)const{return m_outputFlowLph[i];}
+    bool isInputEnabled(int i)const{return m_inputEnabled[i]!=0;}
+    bool canWithdraw(int i)const{return m_canWithdraw[i]!=0;}
+
+    // comandos de la planta: los de PlantRules (setMainInputDial, setMainOutputDial,
+    // setAuxOutputDial, setAuxInputEnabled, applyDistributionFromDial)
+    int auxOutputDial(int i)const{return m_auxOutDial[i];}
+
+private:
+    std::array<double,Tanks> m_capacityL;
+    std::array<double,Tanks> m_levelL;
+    std::array<double,Tanks> m_inputFlowLph;
+    std::array<double,Tanks> m_outputFlowLph;
+    std::array<double,Tanks> m_inputMaxLph;
+    std::array<double,Tanks> m_outputMaxLph;
+    std::array<std::uint8_t,Tanks> m_inputEnabled;
+    std::array<std::uint8_t,Tanks> m_canWithdraw;
+    std::array<std::uint8_t,Tanks> m_events;
+    std::array<int,Tanks> m_auxOutDial;
+    double m_tickS;
+    double m_timeS=0.0;
+    unsigned long long m_ticks=0;
+
+    // reparto de la salida del principal
+    std::array<double,K> m_allocWeight;
+    std::array<double,K> m_allocCap;
+    std::array<double,K> m_allocOut;
+    std::array<int,K> m_allocOrder;
+
+    // en orden de indice, igual que SimEngine::dispatchEvents
+    void dispatchEvents(){
+        for(int i=0;i<Tanks;++i) if(m_events[i]) this->react(i,m_events[i]);
+    }
+
+    // lo que usa PlantRules
+    static constexpr int consumerCount(){return K;}
+    static constexpr int consumer(int k){return k+1;}
+    static constexpr bool isConsumer(int i){return i>=1&&i<Tanks;}
+    int& auxDial(int i){return m_auxOutDial[i];}
+    double* allocWeight(){return m_allocWeight.data();}
+    double* allocCap(){return m_allocCap.data();}
+    double* allocOut(){return m_allocOut.data();}
+    void allocate(double totalLph,int n){
+        FlowAllocator::allocate(totalLph,m_allocWeight.data(),m_allocCap.data(),nullptr,n,
+                                m_allocOut.data(),m_allocOrder.data());
+    }
+};
+
+#endif // FIXEDPLANT_H
@@ -0,0 +1,58 @@
+#include "flowallocator.h"
+
+#include <algorithm>
+
+void FlowAllocator::reserve(int n){
+    if(n>int(m_order.size())) m_order.resize(n);
+}
+
+double FlowAllocator::allocate(double totalLph,const double* weight,const double* cap,
+                               const std::uint8_t* enabled,int n,double* out){
+    reserve(n);
+    return allocate(totalLph,weight,cap,enabled,n,out,m_order.data());
+}
+
+double FlowAllocator::allocate(double totalLph,const double* weight,const double* cap,
+                               const std::uint8_t* enabled,int n,double* out,int* order){
+    int active=0;
+    double sumCap=0.0;
+    double sumWeight=0.0;
+    for(int i=0;i<n;++i){
+        out[i]=0.0;
+        const bool on=(!enabled||enabled[i])&&weight[i]>0.0&&cap[i]>0.0;
+        if(!on) continue;
+        order[active++]=i;
+        sumCap+=cap[i];
+        sumWeight+=weight[i];
+    }
+    if(active==0||totalLph<=0.0) return 0.0;
+
+    // alcanza para todos: cada uno a su tope
+    if(totalLph>=sumCap){
+        for(int k=0;k<active;++k) out[order[k]]=cap[order[k]];
+        return sumCap;
+    }
+
+    // se saturan primero los de menor cap/weight; cuando el siguiente ya no se
+    // satura, el resto comparte lo que queda en proporcion al peso
+    std::sort(order,order+active,[weight,cap](int a,int b){
+        return cap[a]*weight[b]<cap[b]*weight[a];
+    });
+    double left=totalLph;
+    int k=0;
+    for(;k<active;++k){
+        const int i=order[k];
+        if(cap[i]*sumWeight>left*weight[i]) break;
+        out[i]=cap[i];
+        left-=cap[i];
+        sumWeight-=weight[i];
+    }
+    if(k<active&&sumWeight>0.0){
+        const double lambda=left/sumWeight;
+        for(;k<active;++k){
+            const int i=order[k];
+            out[i]=std::min(cap[i],lambda*weight[i]);
+        }
+    }
+    return totalLph;
+}
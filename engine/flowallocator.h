@@ -0,0 +1,37 @@
+#ifndef FLOWALLOCATOR_H
+#define FLOWALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+
+// Reparto de un caudal entre N consumidores por llenado de agua (water-filling):
+// cada uno recibe lambda*weight[i] sin pasar su tope cap[i], con lambda elegido
+// para repartir todo lo posible. Lo que un consumidor no puede tomar por su tope
+// se redistribuye entre los demas en proporcion a sus pesos.
+//
+// O(N log N) por el orden de los cocientes cap/weight. No reserva memoria
+// mientras N no crezca (el indice de orden se reutiliza entre llamadas), asi
+// que se puede llamar en cada tick.
+
+class FlowAllocator {
+public:
+    FlowAllocator()=default;
+
+    void reserve(int n);
+
+    // enabled puede ser nullptr (todos habilitados). Los deshabilitados y los de
+    // peso o tope <= 0 reciben 0. Devuelve el total asignado:
+    // min(totalLph, suma de topes de los que participan).
+    double allocate(double totalLph,const double* weight,const double* cap,
+                    const std::uint8_t* enabled,int n,double* out);
+
+    // lo mismo con el indice de orden del llamador (al menos n enteros), para
+    // quien ya tiene la memoria fija (FixedPlant)
+    static double allocate(double totalLph,const double* weight,const double* cap,
+                           const std::uint8_t* enabled,int n,double* out,int* order);
+
+private:
+    std::vector<int> m_order;
+};
+
+#endif // FLOWALLOCATOR_H
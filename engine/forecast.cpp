@@ -0,0 +1,111 @@
+#include "forecast.h"
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <limits>
+
+Forecast::Forecast(double horizonS)
+    : m_horizonS(horizonS>0.0?horizonS:24*3600.0),
+    m_computedAtS(0.0),
+    m_valid(false)
+{
+}
+
+void Forecast::setHorizonS(double s){
+    if(s<=0.0||s==m_horizonS) return;
+    m_horizonS=s;
+    m_valid=false;
+}
+
+double Forecast::horizonS()const{return m_horizonS;}
+void Forecast::invalidate(){ m_valid=false; }
+double Forecast::computedAtS()const{return m_computedAtS;}
+int Forecast::tankCount()const{return int(m_fullAt.size());}
+const std::vector<double>& Forecast::fullAt()const{return m_fullAt;}
+const std::vector<double>& Forecast::minAt()const{return m_minAt;}
+
+double Forecast::fullAtS(int i)const{
+    return i>=0&&i<tankCount()?m_fullAt[i]:std::numeric_limits<double>::infinity();
+}
+
+double Forecast::minAtS(int i)const{
+    return i>=0&&i<tankCount()?m_minAt[i]:std::numeric_limits<double>::infinity();
+}
+
+bool Forecast::update(const SimEngine& engine){
+    setpoints(engine,m_scratch);
+    const double t=engine.timeS();
+    const bool stale=t<m_computedAtS||t>m_computedAtS+0.25*m_horizonS;
+    if(m_valid&&!stale&&m_scratch==m_key) return false;
+    AGUA_METRIC_SCOPE(ForecastUs);
+    m_key.swap(m_scratch);
+    project(engine);
+    m_valid=true;
+    return true;
+}
+
+// lo que decide hacia donde va la red; los niveles y caudales no, esos ya los
+// sigue la proyeccion
+void Forecast::setpoints(const SimEngine& e,std::vector<double>& key)const{
+    const int n=e.tankCount();
+    key.clear();
+    key.push_back(n);
+    key.push_back(e.mainInputDial());
+    key.push_back(e.mainOutputDial());
+    for(int c:e.consumers()) key.push_back(c);
+    key.push_back(-1.0);
+    for(int i=0;i<n;++i){
+        key.push_back(e.capacityL(i));
+        key.push_back(e.inputMaxLph(i));
+        key.push_back(e.outputMaxLph(i));
+        key.push_back(e.isInputEnabled(i));
+        key.push_back(e.auxOutputDial(i));
+        key.push_back(e.outflowLaw(i));
+    }
+}
+
+void Forecast::project(const SimEngine& e){
+    m_engine=e;
+    m_engine.setTickObserver(nullptr);
+    m_engine.setIntegrator(nullptr);
+
+    const int n=m_engine.tankCount();
+    const double inf=std::numeric_limits<double>::infinity();
+    m_computedAtS=e.timeS();
+    m_fullAt.assign(n,inf);
+    m_minAt.assign(n,inf);
+    for(int i=0;i<n;++i){
+        m_engine.takeEvents(i);
+        const double c=m_engine.capacityL(i);
+        const double L=m_engine.levelL(i);
+        if(L>=c-1e-6) m_fullAt[i]=m_computedAtS;
+        if(L<=0.1*c) m_minAt[i]=m_computedAtS;
+    }
+
+    // de evento en evento: ninguno ocurre antes del primero que calcula la red
+    const TankNetwork& net=m_engine.network();
+    const bool linear=!net.hasLevelDependentFlows();
+    const SimEngine::StepMode mode=linear?SimEngine::Analytic:SimEngine::Adaptive;
+    const double end=m_computedAtS+m_horizonS;
+    for(int k=0;k<MaxEvents&&m_engine.timeS()<end;++k){
+        const double now=m_engine.timeS();
+        double t=linear?end:std::min(end,now+m_horizonS/GravitySteps);
+        if(linear) for(int i=0;i<n;++i) t=std::min(t,now+net.timeToNextEventS(i));
+        // un estado inconsistente (se resuelve en el acto) no deja avanzar
+        if(t<=now) t=std::min(end,now+1e-9*m_horizonS);
+        m_engine.runUntil(t,mode);
+        collect();
+    }
+}
+
+void Forecast::collect(){
+    const double t=m_engine.timeS();
+    const int n=m_engine.tankCount();
+    for(int i=0;i<n;++i){
+        const unsigned ev=m_engine.takeEvents(i);
+        if(!ev) continue;
+        if((ev&SimEngine::EventFull)&&t<m_fullAt[i]) m_fullAt[i]=t;
+        if((ev&SimEngine::EventCanWithdrawChanged)&&!m_engine.canWithdraw(i)&&t<m_minAt[i]) m_minAt[i]=t;
+    }
+}
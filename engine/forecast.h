@@ -0,0 +1,61 @@
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <vector>
+
+#include "simengine.h"
+
+// Pronostico de la red: proyecta una copia del motor hacia adelante con los
+// diales y parametros actuales (mismas reglas y reacciones que SimEngine) y anota
+// cuando cada tanque se llena y cuando baja al 10% por primera vez dentro del
+// horizonte.
+//
+// Con caudales constantes la proyeccion salta de evento en evento (modo
+// Analytic), asi que cuesta O(eventos) y no depende del largo del horizonte; con
+// descarga por gravedad integra en pasos de horizonte/GravitySteps y los
+// instantes quedan redondeados a ese paso.
+//
+// update() solo recalcula si cambio algun comando (invalidate()), algun dial,
+// casilla o parametro del motor, o si ya paso un cuarto del horizonte desde la
+// ultima proyeccion; entre medio los instantes calculados siguen valiendo porque
+// la proyeccion ya incluye las reacciones de la planta. Se reutiliza la memoria.
+
+class Forecast {
+public:
+    static constexpr int GravitySteps=1440;
+    static constexpr int MaxEvents=10000;
+
+    explicit Forecast(double horizonS=24*3600.0);
+
+    void setHorizonS(double s);
+    double horizonS()const;
+
+    // true si recalculo
+    bool update(const SimEngine& engine);
+    void invalidate();
+
+    // instante de simulacion en que el tanque se llena / baja al 10%; infinito si
+    // no pasa dentro del horizonte, computedAtS() si ya estaba asi
+    double fullAtS(int i)const;
+    double minAtS(int i)const;
+    const std::vector<double>& fullAt()const;
+    const std::vector<double>& minAt()const;
+    double computedAtS()const;
+    int tankCount()const;
+
+private:
+    SimEngine m_engine;     // copia de trabajo
+    double m_horizonS;
+    double m_computedAtS;
+    bool m_valid;
+    std::vector<double> m_key;
+    std::vector<double> m_scratch;
+    std::vector<double> m_fullAt;
+    std::vector<double> m_minAt;
+
+    void setpoints(const SimEngine& e,std::vector<double>& key)const;
+    void project(const SimEngine& e);
+    void collect();
+};
+
+#endif // FORECAST_H
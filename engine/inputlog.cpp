@@ -0,0 +1,188 @@
+#include "inputlog.h"
+
+#include <QDir>
+#include <QtEndian>
+#include <cstring>
+
+#include "snapshotfile.h"
+
+namespace {
+
+const char Magic[8]={'A','G','U','A','I','N','P','T'};
+const quint32 Version=1;
+const int HeaderBytes=32;
+const int RecordBytes=24;
+
+QString startPath(const QString& dir){return QDir(dir).filePath("start.bin");}
+QString logPath(const QString& dir){return QDir(dir).filePath("inputs.log");}
+QString endPath(const QString& dir){return QDir(dir).filePath("end.bin");}
+
+// igualdad bit a bit (distingue -0.0 de 0.0 y compara NaN)
+bool sameBits(double a,double b){return std::memcmp(&a,&b,sizeof(double))==0;}
+
+}
+
+InputLog::InputLog(const QString& dir)
+    : m_dir(dir)
+{
+}
+
+InputLog::~InputLog(){
+    m_log.close();
+}
+
+QString InputLog::directory()const{return m_dir;}
+QString InputLog::errorString()const{return m_error;}
+bool InputLog::isRecording()const{return m_log.isOpen();}
+
+bool InputLog::start(const SimEngine& engine){
+    if(m_log.isOpen()) return true;
+    if(!QDir().mkpath(m_dir)){
+        m_error=QString("no se pudo crear %1").arg(m_dir);
+        return false;
+    }
+    QFile::remove(endPath(m_dir));
+    if(!writeSnapshotFile(engine,startPath(m_dir),&m_error)) return false;
+
+    uchar header[HeaderBytes];
+    std::memset(header,0,sizeof(header));
+    std::memcpy(header,Magic,sizeof(Magic));
+    qToLittleEndian<quint32>(Version,header+8);
+    qToLittleEndian<quint32>(RecordBytes,header+12);
+    qToLittleEndian<quint64>(engine.tickCount(),header+16);
+
+    m_log.setFileName(logPath(m_dir));
+    if(!m_log.open(QIODevice::WriteOnly|QIODevice::Truncate)){
+        m_error=m_log.errorString();
+        return false;
+    }
+    m_log.write(reinterpret_cast<const char*>(header),HeaderBytes);
+    for(int i:engine.consumers()){
+        SimCommand c;
+        c.tank=i;
+        writeRecord(engine.tickCount(),Consumer,c);
+    }
+    m_log.flush();
+    return true;
+}
+
+void InputLog::stop(const SimEngine& engine){
+    if(!m_log.isOpen()) return;
+    writeRecord(engine.tickCount(),End,SimCommand());
+    m_log.close();
+    writeSnapshotFile(engine,endPath(m_dir),&m_error);
+}
+
+void InputLog::record(const SimEngine& engine,const SimCommand& c){
+    if(m_log.isOpen()) writeRecord(engine.tickCount(),Command,c);
+}
+
+bool InputLog::writeRecord(unsigned long long tick,Kind kind,const SimCommand& c){
+    uchar rec[RecordBytes];
+    std::memset(rec,0,sizeof(rec));
+    qToLittleEndian<quint64>(tick,rec);
+    rec[8]=kind;
+    rec[9]=c.type;
+    qToLittleEndian<qint32>(c.tank,rec+12);
+    qToLittleEndian<double>(c.value,rec+16);
+    const bool ok=m_log.write(reinterpret_cast<const char*>(rec),RecordBytes)==RecordBytes;
+    m_log.flush();
+    return ok;
+}
+
+//lectura y replay
+
+bool InputLog::load(const QString& dir,SimEngine& engine,std::vector<Entry>& entries,
+                    unsigned long long* endTick,QString* error){
+    auto fail=[error](const QString& message){
+        if(error) *error=message;
+        return false;
+    };
+
+    SnapshotFile start;
+    if(!start.open(startPath(dir))) return fail(start.errorString());
+    start.restore(engine);
+
+    QFile f(logPath(dir));
+    if(!f.open(QIODevice::ReadOnly)) return fail(f.errorString());
+    const QByteArray bytes=f.readAll();
+    const uchar* p=reinterpret_cast<const uchar*>(bytes.constData());
+    if(bytes.size()<HeaderBytes||std::memcmp(p,Magic,sizeof(Magic))!=0) return fail("inputs.log no es una grabacion");
+    if(qFromLittleEndian<quint32>(p+8)!=Version||qFromLittleEndian<quint32>(p+12)!=quint32(RecordBytes))
+        return fail("version de inputs.log no soportada");
+    if(qFromLittleEndian<quint64>(p+16)!=engine.tickCount()) return fail("start.bin no corresponde a inputs.log");
+
+    // sin registro End (sesion cortada) el final es el ultimo comando
+    entries.clear();
+    std::vector<int> consumers;
+    unsigned long long last=engine.tickCount();
+    bool ended=false;
+    const int count=int((bytes.size()-HeaderBytes)/RecordBytes);
+    for(int k=0;k<count&&!ended;++k){
+        const uchar* rec=p+HeaderBytes+k*RecordBytes;
+        const unsigned long long tick=qFromLittleEndian<quint64>(rec);
+        if(tick<last) return fail(QString("registro %1 fuera de orden").arg(k));
+        last=tick;
+        if(rec[8]==End){ ended=true; continue; }
+        if(rec[8]==Consumer){ consumers.push_back(qFromLittleEndian<qint32>(rec+12)); continue; }
+        Entry e;
+        e.tick=tick;
+        e.command.type=SimCommand::Type(rec[9]);
+        e.command.tank=qFromLittleEndian<qint32>(rec+12);
+        e.command.value=qFromLittleEndian<double>(rec+16);
+        entries.push_back(e);
+    }
+    engine.setConsumers(consumers);
+    if(endTick) *endTick=last;
+    return true;
+}
+
+// mismo orden que SimWorker: los comandos de un tick se aplican antes de su paso
+bool InputLog::replay(const QString& dir,SimEngine& engine,unsigned long long untilTick,QString* error){
+    std::vector<Entry> entries;
+    unsigned long long endTick=0;
+    if(!load(dir,engine,entries,&endTick,error)) return false;
+    if(untilTick>endTick) untilTick=endTick;
+
+    for(const Entry& e:entries){
+        if(e.tick>untilTick) break;
+        if(e.tick>engine.tickCount()) engine.step(e.tick-engine.tickCount());
+        if(e.command.tank<0||e.command.tank>=engine.tankCount()) continue;
+        applySimCommand(engine,e.command);
+    }
+    if(untilTick>engine.tickCount()) engine.step(untilTick-engine.tickCount());
+    return true;
+}
+
+bool InputLog::matchesEnd(const QString& dir,const SimEngine& engine,QString* report){
+    auto differ=[report](const QString& message){
+        if(report) *report=message;
+        return false;
+    };
+
+    SnapshotFile end;
+    if(!end.open(endPath(dir))) return differ(end.errorString());
+    const int n=end.tankCount();
+    if(n!=engine.tankCount()) return differ(QString("tanques: %1 en end.bin, %2 en el replay").arg(n).arg(engine.tankCount()));
+    if(end.ticks()!=engine.tickCount()) return differ(QString("tick: %1 en end.bin, %2 en el replay").arg(end.ticks()).arg(engine.tickCount()));
+    if(!sameBits(end.timeS(),engine.timeS())) return differ("timeS distinto");
+    if(end.mainInputDial()!=engine.mainInputDial()||end.mainOutputDial()!=engine.mainOutputDial())
+        return differ("diales de la principal distintos");
+
+    const TankNetwork& net=engine.network();
+    for(int i=0;i<n;++i){
+        const char* field=nullptr;
+        if(!sameBits(end.capacityL(i),net.capacityL(i))) field="capacityL";
+        else if(!sameBits(end.levelL(i),net.levelL(i))) field="levelL";
+        else if(!sameBits(end.inputFlowLph(i),net.inputFlowLph(i))) field="inputFlowLph";
+        else if(!sameBits(end.outputFlowLph(i),net.outputFlowLph(i))) field="outputFlowLph";
+        else if(!sameBits(end.inputMaxLph(i),net.inputMaxLph(i))) field="inputMaxLph";
+        else if(!sameBits(end.outputMaxLph(i),net.outputMaxLph(i))) field="outputMaxLph";
+        else if(end.isInputEnabled(i)!=net.isInputEnabled(i)) field="inputEnabled";
+        else if(end.canWithdraw(i)!=net.canWithdraw(i)) field="canWithdraw";
+        else if(end.auxOutputDial(i)!=engine.auxOutputDial(i)) field="auxOutputDial";
+        if(field) return differ(QString("tanque %1: %2 distinto").arg(i).arg(field));
+    }
+    if(report) *report="identico";
+    return true;
+}
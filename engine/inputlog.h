@@ -0,0 +1,78 @@
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <QFile>
+#include <QString>
+#include <vector>
+
+#include "simcommand.h"
+#include "simengine.h"
+
+// Grabacion de una sesion del operador para reproducirla sin GUI. A diferencia
+// del Journal no se compacta: queda la foto del arranque y todos los comandos
+// con el tick en que se aplicaron, asi el replay pasa exactamente por los mismos
+// pasos y termina en un estado identico bit a bit.
+//
+// Directorio:
+//   start.bin   foto del motor al empezar (snapshotfile.h)
+//   inputs.log  encabezado de 32 bytes "AGUAINPT", u32 version, u32 bytes por
+//               registro, u64 tick inicial, u64 0; despues registros de 24 bytes
+//               (u64 tick, u8 clase, u8 tipo de comando, u16 0, i32 tanque, f64 valor).
+//               Antes de los comandos va un registro Consumer por cada tanque que
+//               recibe la salida del principal (la foto no los guarda) y la
+//               clase End marca el tick final de la sesion.
+//   end.bin     foto al cerrar, para comparar el resultado del replay
+//
+// Los comandos del operador son pocos: se escriben en el mismo hilo de
+// simulacion y se vacian al disco en cada uno, asi un corte no pierde nada.
+
+class InputLog {
+public:
+    enum Kind : unsigned char {
+        Command,
+        End,
+        Consumer
+    };
+
+    struct Entry {
+        unsigned long long tick=0;
+        SimCommand command;
+    };
+
+    explicit InputLog(const QString& dir);
+    ~InputLog();
+    InputLog(const InputLog&)=delete;
+    InputLog& operator=(const InputLog&)=delete;
+
+    QString directory()const;
+    QString errorString()const;
+
+    // borra una grabacion anterior del mismo directorio
+    bool start(const SimEngine& engine);
+    void stop(const SimEngine& engine);
+    bool isRecording()const;
+
+    // hilo de simulacion
+    void record(const SimEngine& engine,const SimCommand& c);
+
+    // lectura: foto inicial en el motor y la lista de comandos
+    static bool load(const QString& dir,SimEngine& engine,std::vector<Entry>& entries,
+                     unsigned long long* endTick=nullptr,QString* error=nullptr);
+
+    // reproduce la sesion hasta el final (o hasta untilTick si es menor) lo mas
+    // rapido posible; con un TickObserver en el motor se graba la serie de tiempo
+    static bool replay(const QString& dir,SimEngine& engine,unsigned long long untilTick=~0ull,
+                       QString* error=nullptr);
+
+    // compara el motor con end.bin; describe la primera diferencia en report
+    static bool matchesEnd(const QString& dir,const SimEngine& engine,QString* report=nullptr);
+
+private:
+    QString m_dir;
+    QString m_error;
+    QFile m_log;
+
+    bool writeRecord(unsigned long long tick,Kind kind,const SimCommand& c);
+};
+
+#endif // INPUTLOG_H
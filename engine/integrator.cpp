@@ -0,0 +1,228 @@
+#include "integrator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double Inf=std::numeric_limits<double>::infinity();
+// por debajo de esto el paso se acepta aunque no cumpla la tolerancia
+const double MinStepS=1e-9;
+
+// tabla de Butcher de Dormand-Prince; la fila 7 es tambien la solucion de orden 5
+const double A[7][6]={
+    {0,0,0,0,0,0},
+    {1.0/5,0,0,0,0,0},
+    {3.0/40,9.0/40,0,0,0,0},
+    {44.0/45,-56.0/15,32.0/9,0,0,0},
+    {19372.0/6561,-25360.0/2187,64448.0/6561,-212.0/729,0,0},
+    {9017.0/3168,-355.0/33,46732.0/5247,49.0/176,-5103.0/18656,0},
+    {35.0/384,0,500.0/1113,125.0/192,-2187.0/6784,11.0/84}
+};
+// orden 5 menos orden 4: estimacion del error local
+const double E[7]={71.0/57600,0,-71.0/16695,71.0/1920,-17253.0/339200,22.0/525,-1.0/40};
+
+// interpolacion cubica de Hermite dentro del paso (theta en [0,1])
+double hermite(double y0,double f0,double y1,double f1,double h,double theta){
+    const double t2=theta*theta;
+    const double t3=t2*theta;
+    return (2*t3-3*t2+1)*y0+(t3-2*t2+theta)*h*f0+(-2*t3+3*t2)*y1+(t3-t2)*h*f1;
+}
+
+}
+
+//umbrales
+
+void Integrator::watch(const TankNetwork& net,const double* levelL){
+    const int n=net.size();
+    m_upL.resize(n);
+    m_downL.resize(n);
+    for(int i=0;i<n;++i){
+        const double c=net.capacityL(i);
+        const double minAllowed=0.1*c;
+        const double tol=1e-9*c;
+        double up=Inf;
+        double down=-Inf;
+        if(net.inputFlowLph(i)>0.0) up=c-tol;
+        if(!net.canWithdraw(i)) up=std::min(up,minAllowed+tol);
+        if(net.canWithdraw(i)&&net.outputFlowLph(i)>0.0) down=minAllowed+tol;
+        m_upL[i]=levelL[i]<up?up:Inf;
+        m_downL[i]=levelL[i]>down?down:-Inf;
+    }
+}
+
+int Integrator::crossing(int i,double a,double b)const{
+    if(b>=m_upL[i]&&a<m_upL[i]) return 1;
+    if(b<=m_downL[i]&&a>m_downL[i]) return -1;
+    return 0;
+}
+
+double Integrator::trigger(int i,int side)const{return side>0?m_upL[i]:m_downL[i];}
+
+double Integrator::landing(const TankNetwork& net,int i,int side)const{
+    const double c=net.capacityL(i);
+    return (side>0&&m_upL[i]>0.5*c)?c:0.1*c;
+}
+
+void Integrator::store(TankNetwork& net,const double* levelL)const{
+    const int n=net.size();
+    for(int i=0;i<n;++i) net.setLevelL(i,levelL[i]);
+}
+
+//Euler
+
+EulerIntegrator::EulerIntegrator(double stepS)
+    : m_stepS(stepS>0.0?stepS:0.2)
+{
+}
+
+void EulerIntegrator::setStepS(double s){ if(s>0.0) m_stepS=s; }
+double EulerIntegrator::stepS()const{return m_stepS;}
+
+double EulerIntegrator::advance(TankNetwork& net,double dtS){
+    const int n=net.size();
+    if(dtS<=0.0) return 0.0;
+    m_y0.assign(net.levels(),net.levels()+n);
+    m_f0.resize(n);
+    watch(net,m_y0.data());
+
+    double t=0.0;
+    while(t<dtS){
+        const double left=dtS-t;
+        const double h=std::min(m_stepS,left);
+        net.rates(m_y0.data(),m_f0.data());
+
+        // dentro del subpaso el nivel es lineal: el cruce se ubica directo
+        int hit=-1;
+        int hitSide=0;
+        double theta=1.0;
+        for(int i=0;i<n;++i){
+            const double y1=m_y0[i]+h*m_f0[i];
+            const int side=crossing(i,m_y0[i],y1);
+            if(!side) continue;
+            const double th=(trigger(i,side)-m_y0[i])/(y1-m_y0[i]);
+            if(hit<0||th<theta){ hit=i; hitSide=side; theta=th; }
+        }
+        if(hit>=0){
+            const double hc=theta*h;
+            for(int i=0;i<n;++i) m_y0[i]+=hc*m_f0[i];
+            m_y0[hit]=landing(net,hit,hitSide);
+            store(net,m_y0.data());
+            ++m_steps;
+            ++m_crossings;
+            return t+hc;
+        }
+
+        for(int i=0;i<n;++i) m_y0[i]+=h*m_f0[i];
+        t=(h>=left)?dtS:t+h;
+        ++m_steps;
+    }
+    store(net,m_y0.data());
+    return dtS;
+}
+
+//Dormand-Prince
+
+AdaptiveIntegrator::AdaptiveIntegrator()
+    : m_relTol(1e-6),
+    m_absTolL(1e-6),
+    m_maxStepS(3600.0),
+    m_h(0.0)
+{
+}
+
+void AdaptiveIntegrator::setTolerance(double relTol,double absTolL){
+    if(relTol>0.0) m_relTol=relTol;
+    if(absTolL>0.0) m_absTolL=absTolL;
+}
+
+void AdaptiveIntegrator::setMaxStepS(double s){ if(s>0.0) m_maxStepS=s; }
+double AdaptiveIntegrator::relTol()const{return m_relTol;}
+double AdaptiveIntegrator::absTolL()const{return m_absTolL;}
+double AdaptiveIntegrator::maxStepS()const{return m_maxStepS;}
+
+// un paso de h desde m_y0 con m_k[0]=f(m_y0): deja la solucion en m_y1, f(m_y1)
+// en m_k[6] y devuelve el error local relativo a la tolerancia (<=1 se acepta)
+double AdaptiveIntegrator::tryStep(const TankNetwork& net,double h){
+    const int n=net.size();
+    for(int s=1;s<7;++s){
+        for(int i=0;i<n;++i){
+            double acc=0.0;
+            for(int j=0;j<s;++j) acc+=A[s][j]*m_k[j][i];
+            m_tmp[i]=m_y0[i]+h*acc;
+        }
+        net.rates(m_tmp.data(),m_k[s].data());
+    }
+    m_y1.swap(m_tmp);
+
+    double err=0.0;
+    for(int i=0;i<n;++i){
+        double e=0.0;
+        for(int s=0;s<7;++s) e+=E[s]*m_k[s][i];
+        const double scale=m_absTolL+m_relTol*std::max(std::fabs(m_y0[i]),std::fabs(m_y1[i]));
+        err=std::max(err,std::fabs(h*e)/scale);
+    }
+    return err;
+}
+
+double AdaptiveIntegrator::advance(TankNetwork& net,double dtS){
+    const int n=net.size();
+    if(dtS<=0.0) return 0.0;
+    m_y0.assign(net.levels(),net.levels()+n);
+    m_y1.resize(n);
+    m_tmp.resize(n);
+    for(std::vector<double>& k:m_k) k.resize(n);
+    watch(net,m_y0.data());
+    net.rates(m_y0.data(),m_k[0].data());
+    if(m_h<=0.0) m_h=std::min(dtS,m_maxStepS);
+
+    double t=0.0;
+    while(t<dtS){
+        const double left=dtS-t;
+        const double h=std::min({m_h,m_maxStepS,left});
+        const double err=tryStep(net,h);
+        const double factor=err>0.0?0.9*std::pow(err,-0.2):5.0;
+        if(err>1.0&&h>MinStepS){
+            m_h=h*std::max(0.2,factor);
+            ++m_rejected;
+            continue;
+        }
+        // un paso recortado por el final del intervalo no achica el siguiente
+        const double grow=std::min(5.0,std::max(0.2,factor));
+        if(!(h<m_h&&grow>=1.0)) m_h=h*grow;
+        ++m_steps;
+
+        int hit=-1;
+        int hitSide=0;
+        double theta=1.0;
+        for(int i=0;i<n;++i){
+            const int side=crossing(i,m_y0[i],m_y1[i]);
+            if(!side) continue;
+            // biseccion sobre la interpolacion: lo no cruzo, hi si
+            const double target=trigger(i,side);
+            double lo=0.0;
+            double hi=1.0;
+            for(int it=0;it<60&&hi-lo>1e-15;++it){
+                const double mid=0.5*(lo+hi);
+                const double y=hermite(m_y0[i],m_k[0][i],m_y1[i],m_k[6][i],h,mid);
+                if((side>0)==(y>=target)) hi=mid; else lo=mid;
+            }
+            if(hit<0||hi<theta){ hit=i; hitSide=side; theta=hi; }
+        }
+        if(hit>=0){
+            const double hc=theta*h;
+            if(theta<1.0) tryStep(net,hc);
+            m_y1[hit]=landing(net,hit,hitSide);
+            store(net,m_y1.data());
+            ++m_crossings;
+            return t+hc;
+        }
+
+        t=(h>=left)?dtS:t+h;
+        m_y0.swap(m_y1);
+        m_k[0].swap(m_k[6]);
+    }
+    store(net,m_y0.data());
+    return dtS;
+}
@@ -0,0 +1,96 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include <vector>
+
+#include "tanknetwork.h"
+
+// Integracion de los niveles de una TankNetwork cuando los caudales dependen del
+// nivel (TankNetwork::rates, p. ej. descarga por gravedad). Los caudales fijados
+// no cambian durante advance(): el integrador se detiene justo en el primer
+// cruce de umbral (lleno o 10%) con el nivel de ese tanque exactamente en el
+// umbral, y SimEngine aplica las reglas (TankNetwork::settle) y reacciona antes
+// de seguir. Asi no hace falta achicar el tick para no pasarse del umbral.
+
+class Integrator {
+public:
+    virtual ~Integrator()=default;
+
+    // avanza los niveles de net como mucho dtS segundos; devuelve el tiempo
+    // avanzado, menor que dtS si algun tanque cruzo un umbral
+    virtual double advance(TankNetwork& net,double dtS)=0;
+
+    unsigned long long steps()const{return m_steps;}
+    unsigned long long rejectedSteps()const{return m_rejected;}
+    unsigned long long crossings()const{return m_crossings;}
+    void resetStats(){ m_steps=0; m_rejected=0; m_crossings=0; }
+
+protected:
+    unsigned long long m_steps=0;
+    unsigned long long m_rejected=0;
+    unsigned long long m_crossings=0;
+
+    // umbrales vigilados de cada tanque, con la misma tolerancia que settle(); un
+    // tanque que ya arranca sobre un umbral no lo vuelve a disparar
+    void watch(const TankNetwork& net,const double* levelL);
+    // +1 si el nivel cruza hacia arriba yendo de a a b, -1 hacia abajo, 0 si no cruza
+    int crossing(int i,double a,double b)const;
+    double trigger(int i,int side)const;
+    // donde queda el nivel despues del cruce: el umbral exacto
+    double landing(const TankNetwork& net,int i,int side)const;
+    void store(TankNetwork& net,const double* levelL)const;
+
+private:
+    std::vector<double> m_upL;
+    std::vector<double> m_downL;
+};
+
+// Euler explicito con subpaso fijo, como el tick clasico pero ubicando el cruce
+// dentro del subpaso en vez de recortar despues. Error proporcional al subpaso:
+// queda como referencia para comparar.
+class EulerIntegrator:public Integrator {
+public:
+    explicit EulerIntegrator(double stepS=0.2);
+
+    void setStepS(double s);
+    double stepS()const;
+
+    double advance(TankNetwork& net,double dtS)override;
+
+private:
+    double m_stepS;
+    std::vector<double> m_y0;
+    std::vector<double> m_f0;
+};
+
+// Dormand-Prince 5(4) con control de paso: el error local de cada paso queda bajo
+// absTolL+relTol*nivel y el paso crece mientras los caudales son suaves, hasta
+// maxStepS. Los cruces se buscan sobre la interpolacion de Hermite del paso
+// aceptado y despues se integra de nuevo hasta el instante encontrado.
+class AdaptiveIntegrator:public Integrator {
+public:
+    AdaptiveIntegrator();
+
+    void setTolerance(double relTol,double absTolL);
+    void setMaxStepS(double s);
+    double relTol()const;
+    double absTolL()const;
+    double maxStepS()const;
+
+    double advance(TankNetwork& net,double dtS)override;
+
+private:
+    double m_relTol;
+    double m_absTolL;
+    double m_maxStepS;
+    double m_h;     // paso propuesto por el control, se conserva entre llamadas
+
+    std::vector<double> m_y0;
+    std::vector<double> m_y1;
+    std::vector<double> m_tmp;
+    std::vector<double> m_k[7];
+
+    double tryStep(const TankNetwork& net,double h);
+};
+
+#endif // INTEGRATOR_H
@@ -0,0 +1,349 @@
+#include "journal.h"
+
+#include <QDir>
+#include <QThread>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "metrics.h"
+#include "snapshotfile.h"
+
+namespace {
+
+const char Magic[8]={'A','G','U','A','J','R','N','L'};
+const quint32 Version=1;
+const int HeaderBytes=32;
+const int RecordBytes=24;
+
+// ids de los archivos "<prefijo><id><sufijo>" del directorio, de menor a mayor
+std::vector<unsigned long long> listIds(const QString& dir,const QString& prefix,const QString& suffix){
+    std::vector<unsigned long long> ids;
+    const QStringList names=QDir(dir).entryList(QStringList{prefix+"*"+suffix},QDir::Files);
+    for(const QString& name:names){
+        bool ok=false;
+        unsigned long long id=name.mid(prefix.size(),name.size()-prefix.size()-suffix.size()).toULongLong(&ok);
+        if(ok) ids.push_back(id);
+    }
+    std::sort(ids.begin(),ids.end());
+    return ids;
+}
+
+QString idPath(const QString& dir,const char* prefix,unsigned long long id,const char* suffix){
+    return QDir(dir).filePath(QString("%1%2%3").arg(prefix).arg(id,8,10,QChar('0')).arg(suffix));
+}
+
+}
+
+Journal::Journal(const QString& dir)
+    : m_dir(dir),
+    m_checkpointIntervalS(60.0),
+    m_checkpointEveryRecords(4096),
+    m_levelSampleIntervalS(10.0),
+    m_nextCheckpointS(0.0),
+    m_nextSampleS(0.0),
+    m_recordsSinceCheckpoint(0),
+    m_checkpointRequested(false),
+    m_requestedSeq(0),
+    m_servedSeq(0),
+    m_writer(nullptr),
+    m_stopWriter(false),
+    m_id(0),
+    m_retryPending(false),
+    m_gap(false),
+    m_writtenSeq(0),
+    m_completedSeq(0)
+{
+}
+
+Journal::~Journal(){
+    if(!m_writer) return;
+    m_stopWriter.store(true,std::memory_order_release);
+    m_writer->wait();
+    delete m_writer;
+}
+
+QString Journal::directory()const{return m_dir;}
+
+QString Journal::errorString()const{
+    QMutexLocker lock(&m_errorLock);
+    return m_error;
+}
+void Journal::setCheckpointIntervalS(double s){ m_checkpointIntervalS=qMax(0.0,s); }
+void Journal::setCheckpointEveryRecords(int n){ m_checkpointEveryRecords=qMax(0,n); }
+void Journal::setLevelSampleIntervalS(double s){ m_levelSampleIntervalS=qMax(0.0,s); }
+bool Journal::isRunning()const{return m_writer!=nullptr;}
+
+QString Journal::checkpointPath(unsigned long long id)const{return idPath(m_dir,"checkpoint-",id,".bin");}
+QString Journal::segmentPath(unsigned long long id)const{return idPath(m_dir,"journal-",id,".log");}
+
+bool Journal::start(const SimEngine& engine){
+    if(m_writer) return true;
+    if(!QDir().mkpath(m_dir)) return false;
+
+    // se sigue numerando despues de lo que haya quedado de la corrida anterior
+    std::vector<unsigned long long> ids=listIds(m_dir,"checkpoint-",".bin");
+    std::vector<unsigned long long> segs=listIds(m_dir,"journal-",".log");
+    m_id=0;
+    if(!ids.empty()) m_id=std::max(m_id,ids.back());
+    if(!segs.empty()) m_id=std::max(m_id,segs.back());
+
+    m_stopWriter.store(false,std::memory_order_release);
+    m_writer=QThread::create([this]{ writerLoop(); });
+    m_writer->setObjectName("Journal");
+    m_writer->start();
+    checkpoint(engine);
+    return true;
+}
+
+void Journal::stop(const SimEngine& engine){
+    if(!m_writer) return;
+    checkpoint(engine);
+    m_stopWriter.store(true,std::memory_order_release);
+    m_writer->wait();
+    delete m_writer;
+    m_writer=nullptr;
+}
+
+unsigned long long Journal::requestCheckpoint(){
+    return m_requestedSeq.fetch_add(1,std::memory_order_acq_rel)+1;
+}
+
+unsigned long long Journal::completedCheckpoint(QString* error)const{
+    QMutexLocker lock(&m_errorLock);
+    if(error) *error=m_completedError;
+    return m_completedSeq;
+}
+
+// los comandos no se pueden perder (romperian el replay): si la cola esta llena se espera
+void Journal::push(const Entry& e){
+    AGUA_METRIC_GAUGE(JournalQueueDepth,m_queue.size());
+    while(!m_queue.push(e)) QThread::yieldCurrentThread();
+}
+
+void Journal::record(const SimEngine& engine,const SimCommand& c){
+    if(!m_writer) return;
+    Entry e;
+    e.kind=Command;
+    e.tick=engine.tickCount();
+    e.command=c;
+    push(e);
+    ++m_recordsSinceCheckpoint;
+}
+
+void Journal::checkpoint(const SimEngine& engine){
+    Entry e;
+    e.kind=Checkpoint;
+    e.tick=engine.tickCount();
+    // la foto cubre todos los pedidos hechos hasta aca
+    e.request=m_servedSeq=m_requestedSeq.load(std::memory_order_acquire);
+    e.capturedAt=std::chrono::steady_clock::now();
+    e.snapshot=new SimSnapshot;
+    e.snapshot->capture(engine);
+    push(e);
+    m_recordsSinceCheckpoint=0;
+    m_nextCheckpointS=engine.timeS()+m_checkpointIntervalS;
+}
+
+void Journal::stepped(const SimEngine& engine){
+    if(!m_writer) return;
+    const double t=engine.timeS();
+
+    // las muestras de nivel son opcionales: si el escritor va atrasado se descartan
+    if(m_levelSampleIntervalS>0.0&&t>=m_nextSampleS){
+        m_nextSampleS=t+m_levelSampleIntervalS;
+        Entry e;
+        e.kind=LevelSample;
+        e.tick=engine.tickCount();
+        e.command.type=SimCommand::SetLevel;
+        for(int i=0;i<engine.tankCount();++i){
+            e.command.tank=i;
+            e.command.value=engine.levelL(i);
+            if(!m_queue.push(e)) break;
+            ++m_recordsSinceCheckpoint;
+        }
+    }
+
+    bool due=m_checkpointRequested.exchange(false,std::memory_order_acq_rel);
+    due=due||m_requestedSeq.load(std::memory_order_acquire)!=m_servedSeq;
+    due=due||(m_checkpointIntervalS>0.0&&t>=m_nextCheckpointS);
+    due=due||(m_checkpointEveryRecords>0&&m_recordsSinceCheckpoint>=m_checkpointEveryRecords);
+    if(due) checkpoint(engine);
+}
+
+//hilo escritor
+
+void Journal::writerLoop(){
+    for(;;){
+        const bool stopping=m_stopWriter.load(std::memory_order_acquire);
+        Entry e;
+        bool wrote=false;
+        while(m_queue.pop(e)){
+            write(e);
+            wrote=true;
+        }
+        if(wrote&&m_segment.isOpen()&&!m_segment.flush()) cutSegment(m_segment.errorString());
+        // despues de un error se pide otra foto, a lo sumo una por segundo
+        if(m_retryPending&&m_sinceFailure.elapsed()>=1000){
+            m_retryPending=false;
+            m_checkpointRequested.store(true,std::memory_order_release);
+        }
+        if(stopping) break;
+        QThread::msleep(10);
+    }
+    m_segment.close();
+}
+
+void Journal::write(const Entry& e){
+    if(e.kind==Checkpoint){
+        const bool ok=writeCheckpoint(e.snapshot);
+        if(e.request==m_writtenSeq) return;
+        // primera foto de un pedido nuevo: Guardar tarda desde que se saca la foto
+        // hasta que quedo escrita
+        m_writtenSeq=e.request;
+        const auto us=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-e.capturedAt);
+        AGUA_METRIC_SAMPLE(SaveStateUs,us.count());
+        QMutexLocker lock(&m_errorLock);
+        m_completedSeq=e.request;
+        m_completedError=ok?QString():m_error;
+        return;
+    }
+    if(!m_segment.isOpen()) return;
+
+    uchar rec[RecordBytes];
+    std::memset(rec,0,sizeof(rec));
+    qToLittleEndian<quint64>(e.tick,rec);
+    rec[8]=e.kind;
+    rec[9]=e.command.type;
+    qToLittleEndian<qint32>(e.command.tank,rec+12);
+    qToLittleEndian<double>(e.command.value,rec+16);
+    if(m_segment.write(reinterpret_cast<const char*>(rec),RecordBytes)!=RecordBytes) cutSegment(m_segment.errorString());
+}
+
+// un registro a medias queda al final y recover() lo ignora; lo que siga no se
+// puede agregar detras, el segmento queda cerrado hasta la proxima foto
+void Journal::cutSegment(const QString& message){
+    fail(message);
+    m_segment.close();
+    m_gap=true;
+}
+
+// hilo escritor
+void Journal::fail(const QString& message){
+    AGUA_METRIC_COUNT(JournalWriteErrors);
+    {
+        QMutexLocker lock(&m_errorLock);
+        m_error=message;
+    }
+    m_retryPending=true;
+    m_sinceFailure.start();
+}
+
+// primero el segmento nuevo y despues la foto; lo viejo se borra solo si la foto quedo bien.
+// Si el segmento nuevo no se puede crear no se usa esta foto: se sigue en el anterior.
+bool Journal::writeCheckpoint(SimSnapshot* snap){
+    AGUA_METRIC_SCOPE(CheckpointWriteUs);
+    const unsigned long long id=m_id+1;
+
+    uchar header[HeaderBytes];
+    std::memset(header,0,sizeof(header));
+    std::memcpy(header,Magic,sizeof(Magic));
+    qToLittleEndian<quint32>(Version,header+8);
+    qToLittleEndian<quint32>(RecordBytes,header+12);
+    qToLittleEndian<quint64>(id,header+16);
+    qToLittleEndian<quint64>(snap->tick,header+24);
+
+    QFile segment(segmentPath(id));
+    if(!segment.open(QIODevice::WriteOnly|QIODevice::Truncate)
+       ||segment.write(reinterpret_cast<const char*>(header),HeaderBytes)!=HeaderBytes
+       ||!segment.flush()){
+        fail(QString("no se pudo crear %1: %2").arg(segment.fileName()).arg(segment.errorString()));
+        segment.remove();
+        delete snap;
+        return false;
+    }
+    m_segment.close();
+    m_segment.setFileName(segment.fileName());
+    segment.close();
+    m_id=id;
+    if(!m_segment.open(QIODevice::WriteOnly|QIODevice::Append)){
+        fail(QString("no se pudo abrir %1: %2").arg(m_segment.fileName()).arg(m_segment.errorString()));
+        delete snap;
+        return false;
+    }
+
+    QString error;
+    const bool ok=writeSnapshotFile(*snap,checkpointPath(id),&error);
+    delete snap;
+    if(!ok){
+        // el segmento nuevo sigue al anterior y recover() los encadena, salvo que
+        // al anterior le falten registros: entonces se recupera hasta el hueco
+        fail(error);
+        if(m_gap) m_segment.remove();
+        return false;
+    }
+    m_gap=false;
+    removeBefore(id);
+    QMutexLocker lock(&m_errorLock);
+    m_error.clear();
+    return true;
+}
+
+void Journal::removeBefore(unsigned long long id){
+    for(unsigned long long old:listIds(m_dir,"checkpoint-",".bin")) if(old<id) QFile::remove(checkpointPath(old));
+    for(unsigned long long old:listIds(m_dir,"journal-",".log")) if(old<id) QFile::remove(segmentPath(old));
+}
+
+//recuperacion
+
+bool Journal::openLatestCheckpoint(const QString& dir,SnapshotFile& file,unsigned long long* id,QString* error){
+    const std::vector<unsigned long long> ids=listIds(dir,"checkpoint-",".bin");
+    QString lastError="no hay checkpoints";
+    for(auto it=ids.rbegin();it!=ids.rend();++it){
+        if(!file.open(idPath(dir,"checkpoint-",*it,".bin"))){ lastError=file.errorString(); continue; }
+        if(id) *id=*it;
+        return true;
+    }
+    if(error) *error=lastError;
+    return false;
+}
+
+bool Journal::recover(const QString& dir,SimEngine& engine,QString* error){
+    const std::vector<unsigned long long> segs=listIds(dir,"journal-",".log");
+
+    // la foto valida mas nueva
+    unsigned long long base=0;
+    {
+        SnapshotFile snap;
+        if(!openLatestCheckpoint(dir,snap,&base,error)) return false;
+        snap.restore(engine);
+    }
+
+    // cada segmento continua al anterior; un registro cortado al final se ignora
+    for(unsigned long long id:segs){
+        if(id<base) continue;
+        QFile f(idPath(dir,"journal-",id,".log"));
+        if(!f.open(QIODevice::ReadOnly)) break;
+        const QByteArray bytes=f.readAll();
+        const uchar* p=reinterpret_cast<const uchar*>(bytes.constData());
+        if(bytes.size()<HeaderBytes||std::memcmp(p,Magic,sizeof(Magic))!=0) break;
+        if(qFromLittleEndian<quint32>(p+8)!=Version||qFromLittleEndian<quint32>(p+12)!=quint32(RecordBytes)) break;
+
+        const int count=int((bytes.size()-HeaderBytes)/RecordBytes);
+        for(int k=0;k<count;++k){
+            const uchar* rec=p+HeaderBytes+k*RecordBytes;
+            const unsigned long long tick=qFromLittleEndian<quint64>(rec);
+            if(tick>engine.tickCount()) engine.step(tick-engine.tickCount());
+
+            SimCommand c;
+            c.type=SimCommand::Type(rec[9]);
+            c.tank=qFromLittleEndian<qint32>(rec+12);
+            c.value=qFromLittleEndian<double>(rec+16);
+            if(c.tank<0||c.tank>=engine.tankCount()) continue;
+            if(rec[8]==LevelSample) engine.setLevelL(c.tank,c.value);
+            else if(rec[8]==Command) applySimCommand(engine,c);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <chrono>
+
+#include "simcommand.h"
+#include "simengine.h"
+#include "simsnapshot.h"
+#include "snapshotfile.h"
+#include "spscqueue.h"
+
+class QThread;
+
+// Diario de escritura anticipada del motor. El hilo de simulacion anota cada
+// comando aplicado (diales, capacidades, flujos) y muestras de nivel en una cola
+// lock-free; un hilo escritor los agrega al final del segmento actual. Cada
+// tanto se compacta: el escritor guarda una foto binaria (checkpoint) y abre un
+// segmento nuevo, asi guardar cuesta O(cambios) y recuperar es foto + replay.
+//
+// En el directorio quedan checkpoint-<id>.bin (snapshotfile.h) y journal-<id>.log
+// con lo que paso despues de esa foto. El segmento se crea antes que la foto: si
+// se corta en el medio, recover() usa la foto anterior y encadena los segmentos.
+// Si no se puede abrir el segmento nuevo se sigue escribiendo en el anterior; si
+// falla una escritura el segmento se cierra donde quedo bien. En los dos casos
+// queda el error en errorString() (y en la metrica journal.write_errors) y se
+// pide otra foto, que vuelve a intentar y deja la historia completa de nuevo.
+//
+// Segmento (little-endian): encabezado "AGUAJRNL", u32 version, u32 bytes por
+// registro, u64 id, u64 tick de la foto; despues registros de 24 bytes
+// (u64 tick, u8 clase, u8 tipo de comando, u16 0, i32 tanque, f64 valor).
+
+class Journal {
+public:
+    explicit Journal(const QString& dir);
+    ~Journal();
+    Journal(const Journal&)=delete;
+    Journal& operator=(const Journal&)=delete;
+
+    QString directory()const;
+    // ultimo error del escritor; vacio despues de una foto que quedo bien
+    QString errorString()const;
+    void setCheckpointIntervalS(double s);
+    void setCheckpointEveryRecords(int n);
+    void setLevelSampleIntervalS(double s);
+
+    // arranca el escritor con una primera foto del motor
+    bool start(const SimEngine& engine);
+    // ultima foto y espera a que el escritor termine
+    void stop(const SimEngine& engine);
+    bool isRunning()const;
+
+    // hilo de simulacion
+    void record(const SimEngine& engine,const SimCommand& c);
+    void stepped(const SimEngine& engine);
+
+    // cualquier hilo: pide una foto en el proximo paso y devuelve el numero del
+    // pedido. La foto queda en disco (o fallo) cuando completedCheckpoint() llega
+    // a ese numero; error queda vacio si la ultima foto pedida se escribio bien.
+    unsigned long long requestCheckpoint();
+    unsigned long long completedCheckpoint(QString* error=nullptr)const;
+
+    // foto mas nueva + replay de los segmentos que le siguen
+    static bool recover(const QString& dir,SimEngine& engine,QString* error=nullptr);
+    // abre la foto valida mas nueva del directorio (sin los segmentos)
+    static bool openLatestCheckpoint(const QString& dir,SnapshotFile& file,
+                                     unsigned long long* id=nullptr,QString* error=nullptr);
+
+private:
+    enum Kind : unsigned char {
+        Command,
+        LevelSample,
+        Checkpoint
+    };
+
+    struct Entry {
+        Kind kind=Command;
+        unsigned long long tick=0;
+        SimCommand command;
+        SimSnapshot* snapshot=nullptr;
+        unsigned long long request=0;   // pedidos que cubre la foto
+        std::chrono::steady_clock::time_point capturedAt;
+    };
+
+    QString m_dir;
+    double m_checkpointIntervalS;
+    int m_checkpointEveryRecords;
+    double m_levelSampleIntervalS;
+
+    // lado del hilo de simulacion
+    double m_nextCheckpointS;
+    double m_nextSampleS;
+    int m_recordsSinceCheckpoint;
+    std::atomic<bool> m_checkpointRequested;    // reintento del escritor
+    std::atomic<unsigned long long> m_requestedSeq;
+    unsigned long long m_servedSeq;
+
+    SpscQueue<Entry,4096> m_queue;
+    QThread* m_writer;
+    std::atomic<bool> m_stopWriter;
+
+    // lado del escritor
+    QFile m_segment;
+    unsigned long long m_id;
+    bool m_retryPending;
+    bool m_gap;             // se perdieron registros del segmento actual
+    QElapsedTimer m_sinceFailure;
+
+    unsigned long long m_writtenSeq;        // ultimo pedido cuya foto ya se escribio
+
+    mutable QMutex m_errorLock;
+    QString m_error;
+    unsigned long long m_completedSeq;
+    QString m_completedError;
+
+    void push(const Entry& e);
+    void checkpoint(const SimEngine& engine);
+
+    void writerLoop();
+    void write(const Entry& e);
+    bool writeCheckpoint(SimSnapshot* snap);
+    void removeBefore(unsigned long long id);
+    void fail(const QString& message);
+    void cutSegment(const QString& message);
+
+    QString checkpointPath(unsigned long long id)const;
+    QString segmentPath(unsigned long long id)const;
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,214 @@
+#include "metrics.h"
+
+namespace {
+
+const char* const HistogramNames[Metrics::HistogramCount]={
+    "tick.step_ns",
+    "plant.distribution_ns",
+    "timer.jitter_us",
+    "worker.publish_ns",
+    "presenter.frame_ns",
+    "journal.checkpoint_us",
+    "gui.save_us",
+    "gui.load_us",
+    "forecast.project_us"
+};
+
+// histogramas en microsegundos; el resto en nanosegundos
+const bool HistogramInMicros[Metrics::HistogramCount]={
+    false,false,true,false,false,true,true,true,true
+};
+
+const char* const CounterNames[Metrics::CounterCount]={
+    "ticks",
+    "commands",
+    "snapshots",
+    "signal.networkStepped",
+    "signal.snapshotChanged",
+    "event.full",
+    "event.empty",
+    "event.canWithdraw",
+    "journal.write_errors",
+    "commands.dropped"
+};
+
+const char* const GaugeNames[Metrics::GaugeCount]={
+    "queue.commands",
+    "queue.journal",
+    "queue.recorder"
+};
+
+// bucket b guarda los valores con b bits significativos: 0, 1, 2-3, 4-7, ...
+int bucketOf(std::uint64_t v){
+    int b=0;
+    while(v){ ++b; v>>=1; }
+    return b;
+}
+
+std::uint64_t bucketUpper(int b){
+    if(b==0) return 0;
+    if(b>=64) return ~std::uint64_t(0);
+    return (std::uint64_t(1)<<b)-1;
+}
+
+void atomicMax(std::atomic<std::uint64_t>& a,std::uint64_t v){
+    std::uint64_t cur=a.load(std::memory_order_relaxed);
+    while(v>cur&&!a.compare_exchange_weak(cur,v,std::memory_order_relaxed)){}
+}
+
+void atomicMax(std::atomic<std::int64_t>& a,std::int64_t v){
+    std::int64_t cur=a.load(std::memory_order_relaxed);
+    while(v>cur&&!a.compare_exchange_weak(cur,v,std::memory_order_relaxed)){}
+}
+
+}
+
+Metrics::Metrics(){
+    reset();
+}
+
+Metrics& Metrics::instance(){
+    static Metrics metrics;
+    return metrics;
+}
+
+bool Metrics::enabled(){
+#ifdef AGUA_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* Metrics::name(Histogram h){return HistogramNames[h];}
+const char* Metrics::name(Counter c){return CounterNames[c];}
+const char* Metrics::name(Gauge g){return GaugeNames[g];}
+
+void Metrics::sample(Histogram h,std::uint64_t v){
+    Hist& s=m_hist[h];
+    s.buckets[bucketOf(v)].fetch_add(1,std::memory_order_relaxed);
+    s.count.fetch_add(1,std::memory_order_relaxed);
+    s.sum.fetch_add(v,std::memory_order_relaxed);
+    atomicMax(s.max,v);
+}
+
+void Metrics::count(Counter c,std::uint64_t n){ m_counters[c].fetch_add(n,std::memory_order_relaxed); }
+
+void Metrics::gauge(Gauge g,std::int64_t v){
+    m_gauges[g].last.store(v,std::memory_order_relaxed);
+    atomicMax(m_gauges[g].max,v);
+}
+
+void Metrics::reset(){
+    for(Hist& s:m_hist){
+        for(std::atomic<std::uint64_t>& b:s.buckets) b.store(0,std::memory_order_relaxed);
+        s.count.store(0,std::memory_order_relaxed);
+        s.sum.store(0,std::memory_order_relaxed);
+        s.max.store(0,std::memory_order_relaxed);
+    }
+    for(std::atomic<std::uint64_t>& c:m_counters) c.store(0,std::memory_order_relaxed);
+    for(GaugeValue& g:m_gauges){
+        g.last.store(0,std::memory_order_relaxed);
+        g.max.store(0,std::memory_order_relaxed);
+    }
+}
+
+//lectura
+
+Metrics::HistogramStats Metrics::histogram(Histogram h)const{
+    const Hist& s=m_hist[h];
+    std::uint64_t counts[Buckets];
+    std::uint64_t total=0;
+    for(int b=0;b<Buckets;++b){
+        counts[b]=s.buckets[b].load(std::memory_order_relaxed);
+        total+=counts[b];
+    }
+
+    HistogramStats out;
+    out.count=total;
+    out.max=s.max.load(std::memory_order_relaxed);
+    if(total==0) return out;
+    out.mean=double(s.sum.load(std::memory_order_relaxed))/double(total);
+
+    // el bucket donde la cuenta acumulada pasa el percentil
+    const double q[3]={0.50,0.90,0.99};
+    std::uint64_t* dst[3]={&out.p50,&out.p90,&out.p99};
+    std::uint64_t acc=0;
+    int k=0;
+    for(int b=0;b<Buckets&&k<3;++b){
+        acc+=counts[b];
+        while(k<3&&double(acc)>=q[k]*double(total)){
+            *dst[k]=qMin(bucketUpper(b),out.max);
+            ++k;
+        }
+    }
+    return out;
+}
+
+std::uint64_t Metrics::counter(Counter c)const{return m_counters[c].load(std::memory_order_relaxed);}
+std::int64_t Metrics::gaugeLast(Gauge g)const{return m_gauges[g].last.load(std::memory_order_relaxed);}
+std::int64_t Metrics::gaugeMax(Gauge g)const{return m_gauges[g].max.load(std::memory_order_relaxed);}
+
+QString Metrics::dump()const{
+    if(!enabled()) return "metricas deshabilitadas (compilado con CONFIG+=no_metrics)\n";
+    QString out;
+    for(int h=0;h<HistogramCount;++h){
+        const HistogramStats s=histogram(Histogram(h));
+        out+=QString("%1  n=%2  media=%3  p50<=%4  p90<=%5  p99<=%6  max=%7\n")
+                .arg(name(Histogram(h)),-24)
+                .arg(s.count)
+                .arg(s.mean,0,'f',1)
+                .arg(s.p50)
+                .arg(s.p90)
+                .arg(s.p99)
+                .arg(s.max);
+    }
+    for(int c=0;c<CounterCount;++c)
+        out+=QString("%1  %2\n").arg(name(Counter(c)),-24).arg(counter(Counter(c)));
+    for(int g=0;g<GaugeCount;++g)
+        out+=QString("%1  actual=%2  max=%3\n").arg(name(Gauge(g)),-24).arg(gaugeLast(Gauge(g))).arg(gaugeMax(Gauge(g)));
+    return out;
+}
+
+QJsonObject Metrics::toJson()const{
+    QJsonObject root;
+    root["enabled"]=enabled();
+    QJsonObject hists;
+    for(int h=0;h<HistogramCount;++h){
+        const HistogramStats s=histogram(Histogram(h));
+        QJsonObject o;
+        o["count"]=double(s.count);
+        o["mean"]=s.mean;
+        o["p50"]=double(s.p50);
+        o["p90"]=double(s.p90);
+        o["p99"]=double(s.p99);
+        o["max"]=double(s.max);
+        hists[name(Histogram(h))]=o;
+    }
+    root["histograms"]=hists;
+    QJsonObject counters;
+    for(int c=0;c<CounterCount;++c) counters[name(Counter(c))]=double(counter(Counter(c)));
+    root["counters"]=counters;
+    QJsonObject gauges;
+    for(int g=0;g<GaugeCount;++g){
+        QJsonObject o;
+        o["last"]=double(gaugeLast(Gauge(g)));
+        o["max"]=double(gaugeMax(Gauge(g)));
+        gauges[name(Gauge(g))]=o;
+    }
+    root["gauges"]=gauges;
+    return root;
+}
+
+//medicion de bloques
+
+MetricTimer::MetricTimer(Metrics::Histogram h)
+    : m_hist(h),
+    m_start(std::chrono::steady_clock::now())
+{
+}
+
+MetricTimer::~MetricTimer(){
+    const auto ns=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-m_start).count();
+    Metrics::instance().sample(m_hist,std::uint64_t(HistogramInMicros[m_hist]?ns/1000:ns));
+}
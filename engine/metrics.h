@@ -0,0 +1,134 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QJsonObject>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Instrumentacion del lazo de simulacion: histogramas de duracion (buckets en
+// potencias de 2), contadores y profundidad de colas. Todo con atomicos
+// relajados, se puede anotar desde cualquier hilo sin bloquear.
+//
+// Los puntos de medicion usan las macros AGUA_METRIC_*: sin AGUA_METRICS
+// ("qmake CONFIG+=no_metrics", ver engine.pri) no generan codigo. La clase sigue
+// existiendo para que el panel y el volcado compilen igual (quedan en cero).
+
+class Metrics {
+public:
+    enum Histogram {
+        TickStepNs,         // un disparo del TickScheduler (todos sus pasos)
+        DistributionNs,     // SimEngine::updateAuxiliaryInputs
+        TimerJitterUs,      // |intervalo real - intervalo pedido| del reloj de simulacion
+        PublishNs,          // foto para la GUI
+        PresenterFrameNs,   // refresco de widgets
+        CheckpointWriteUs,  // foto binaria del diario
+        SaveStateUs,        // Guardar: foto pedida, desde que se saca hasta que queda en disco
+        LoadStateUs,
+        ForecastUs,         // Forecast::update cuando recalcula
+        HistogramCount
+    };
+
+    enum Counter {
+        TicksStepped,
+        CommandsApplied,
+        SnapshotsPublished,
+        NetworkSteppedSignals,
+        SnapshotChangedSignals,
+        EventsFull,
+        EventsEmpty,
+        EventsCanWithdraw,
+        JournalWriteErrors,     // segmento o foto del diario que no se pudo escribir
+        CommandsDropped,        // SimWorker::post con la cola llena
+        CounterCount
+    };
+
+    enum Gauge {
+        CommandQueueDepth,
+        JournalQueueDepth,
+        RecorderQueueDepth,
+        GaugeCount
+    };
+
+    struct HistogramStats {
+        std::uint64_t count=0;
+        std::uint64_t max=0;
+        double mean=0.0;
+        // cota superior del bucket (potencias de 2)
+        std::uint64_t p50=0;
+        std::uint64_t p90=0;
+        std::uint64_t p99=0;
+    };
+
+    static Metrics& instance();
+    static bool enabled();
+    static const char* name(Histogram h);
+    static const char* name(Counter c);
+    static const char* name(Gauge g);
+
+    void sample(Histogram h,std::uint64_t v);
+    void count(Counter c,std::uint64_t n=1);
+    void gauge(Gauge g,std::int64_t v);
+    void reset();
+
+    HistogramStats histogram(Histogram h)const;
+    std::uint64_t counter(Counter c)const;
+    std::int64_t gaugeLast(Gauge g)const;
+    std::int64_t gaugeMax(Gauge g)const;
+
+    QString dump()const;
+    QJsonObject toJson()const;
+
+private:
+    static constexpr int Buckets=65;
+
+    struct Hist {
+        std::atomic<std::uint64_t> buckets[Buckets];
+        std::atomic<std::uint64_t> count;
+        std::atomic<std::uint64_t> sum;
+        std::atomic<std::uint64_t> max;
+    };
+    struct GaugeValue {
+        std::atomic<std::int64_t> last;
+        std::atomic<std::int64_t> max;
+    };
+
+    Metrics();
+
+    Hist m_hist[HistogramCount];
+    std::atomic<std::uint64_t> m_counters[CounterCount];
+    GaugeValue m_gauges[GaugeCount];
+};
+
+// mide el bloque donde vive; la unidad sale del nombre del histograma (Ns / Us)
+class MetricTimer {
+public:
+    explicit MetricTimer(Metrics::Histogram h);
+    ~MetricTimer();
+    MetricTimer(const MetricTimer&)=delete;
+    MetricTimer& operator=(const MetricTimer&)=delete;
+
+private:
+    Metrics::Histogram m_hist;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#define AGUA_METRIC_CONCAT2(a,b) a##b
+#define AGUA_METRIC_CONCAT(a,b) AGUA_METRIC_CONCAT2(a,b)
+
+#ifdef AGUA_METRICS
+#define AGUA_METRIC_SCOPE(h) MetricTimer AGUA_METRIC_CONCAT(aguaMetricTimer,__LINE__)(Metrics::h)
+#define AGUA_METRIC_SAMPLE(h,v) Metrics::instance().sample(Metrics::h,std::uint64_t(v))
+#define AGUA_METRIC_COUNT(c) Metrics::instance().count(Metrics::c)
+#define AGUA_METRIC_ADD(c,n) Metrics::instance().count(Metrics::c,std::uint64_t(n))
+#define AGUA_METRIC_GAUGE(g,v) Metrics::instance().gauge(Metrics::g,std::int64_t(v))
+#else
+#define AGUA_METRIC_SCOPE(h) do{}while(0)
+#define AGUA_METRIC_SAMPLE(h,v) do{}while(0)
+#define AGUA_METRIC_COUNT(c) do{}while(0)
+#define AGUA_METRIC_ADD(c,n) do{}while(0)
+#define AGUA_METRIC_GAUGE(g,v) do{}while(0)
+#endif
+
+#endif // METRICS_H
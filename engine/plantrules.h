@@ -0,0 +1,178 @@
+#ifndef PLANTRULES_H
+#define PLANTRULES_H
+
+#include "tanknetwork.h"
+
+// Reglas de la planta (principal -> consumidores): diales, reparto de la salida
+// del principal por llenado de agua y reacciones a los eventos. Las comparten
+// SimEngine (red de tamano variable) y FixedPlant<K> (forma fija) como base CRTP,
+// asi las dos aplican exactamente la misma logica y cada una pone su almacenamiento.
+//
+// Lo que tiene que dar Derived (puede ser privado con friend PlantRules<Derived>):
+//   capacityL(i), levelL(i), inputMaxLph(i), outputMaxLph(i), currentInputLph(i),
+//   currentOutputLph(i), isInputEnabled(i), canWithdraw(i), setInputEnabled(i,b),
+//   applyInputFlowLph(i,Lph), applyOutputFlowLph(i,Lph)   reglas de cada tanque
+//   consumerCount(), consumer(k), isConsumer(i)           quienes reciben del principal
+//   auxDial(i)                                            dial de salida (int&)
+//   allocWeight(), allocCap(), allocOut()                 memoria del reparto (consumerCount())
+//   allocate(totalLph,n)                                  FlowAllocator sobre esa memoria
+//   updateAuxiliaryInputs(totalLph)                       si quiere envolver el reparto
+//                                                         (si no, se usa el de aca)
+
+template<class Derived>
+class PlantRules {
+public:
+    static constexpr int Principal=0;
+
+    int mainInputDial()const{return m_inDial;}
+    int mainOutputDial()const{return m_outDial;}
+
+    double mapDialToLph(int dialValue)const{
+        double maxLph=self().outputMaxLph(Principal);
+        if(maxLph<=0.0) maxLph=self().capacityL(Principal)*2.0;
+        return (dialValue/100.0)*maxLph;
+    }
+
+    double mainInputRequestedLph()const{
+        return (m_inDial/100.0)*self().inputMaxLph(Principal);
+    }
+
+    // comandos de la planta (lo que antes hacian los diales y checkboxes)
+
+    void setMainInputDial(int v){
+        Derived& d=self();
+        m_inDial=v;
+        if(d.levelL(Principal)<d.capacityL(Principal)-1e-6) d.setInputEnabled(Principal,true);
+        d.applyInputFlowLph(Principal,mainInputRequestedLph());
+    }
+
+    void setMainOutputDial(int v){
+        Derived& d=self();
+        m_outDial=v;
+        d.applyOutputFlowLph(Principal,mapDialToLph(v));
+        d.updateAuxiliaryInputs(d.currentOutputLph(Principal));
+    }
+
+    void setAuxOutputDial(int i,int v){
+        Derived& d=self();
+        d.auxDial(i)=v;
+        d.applyOutputFlowLph(i,(v/100.0)*d.outputMaxLph(i));
+    }
+
+    void setAuxInputEnabled(int i,bool enabled){
+        self().setInputEnabled(i,enabled);
+        applyDistributionFromDial(m_outDial);
+    }
+
+    void applyDistributionFromDial(int dialValue){
+        Derived& d=self();
+        m_outDial=dialValue;
+        d.applyOutputFlowLph(Principal,mapDialToLph(dialValue));
+        d.updateAuxiliaryInputs(d.currentOutputLph(Principal));
+
+        if(d.capacityL(Principal)-d.levelL(Principal)>1e-6) d.setInputEnabled(Principal,true);
+        d.applyInputFlowLph(Principal,mainInputRequestedLph());
+
+        const int n=d.consumerCount();
+        bool allFull=n>0;
+        for(int k=0;k<n;++k){
+            const int c=d.consumer(k);
+            const bool full=d.levelL(c)>=d.capacityL(c)-1e-6;
+            if(full) zeroAuxOutputDial(c);
+            allFull=allFull&&full;
+        }
+
+        if(allFull){
+            zeroMainOutputDial();
+            d.applyOutputFlowLph(Principal,0.0);
+        }
+    }
+
+protected:
+    int m_inDial=0;
+    int m_outDial=0;
+
+    // reacciones de la planta a los eventos de un tanque (antes estaban en los
+    // lambdas de MainWindow); se llaman en orden de indice
+    void react(int i,unsigned ev){
+        if(i==Principal){
+            if(ev&TankNetwork::EventFull){
+                zeroMainInputDial();
+                self().setInputEnabled(Principal,false);
+            }
+            if((ev&TankNetwork::EventCanWithdrawChanged)&&!self().canWithdraw(Principal)) zeroMainOutputDial();
+            return;
+        }
+        if(!self().isConsumer(i)) return;
+        if(ev&TankNetwork::EventFull){
+            zeroAuxOutputDial(i);
+            applyDistributionFromDial(m_outDial);
+        }
+    }
+
+    // los diales solo disparan su logica si cambian de valor, igual que QDial::valueChanged
+    void zeroMainInputDial(){ if(m_inDial!=0) setMainInputDial(0); }
+    void zeroMainOutputDial(){ if(m_outDial!=0) setMainOutputDial(0); }
+    void zeroAuxOutputDial(int i){ if(self().auxDial(i)!=0) setAuxOutputDial(i,0); }
+
+    void cutDistribution(){
+        Derived& d=self();
+        d.applyOutputFlowLph(Principal,0.0);
+        zeroMainOutputDial();
+        const int n=d.consumerCount();
+        for(int k=0;k<n;++k) d.applyInputFlowLph(d.consumer(k),0.0);
+    }
+
+    // Distribucion para los consumidores: llenado de agua pesado por el espacio
+    // libre de cada uno y limitado por su entrada maxima. Lo que uno no puede
+    // tomar pasa a los demas; el principal solo entrega lo que se reparte.
+    void updateAuxiliaryInputs(double totalOutLph){
+        Derived& d=self();
+        if(d.levelL(Principal)<=0.1*d.capacityL(Principal)){
+            cutDistribution();
+            return;
+        }
+
+        const int n=d.consumerCount();
+        double* weight=d.allocWeight();
+        double* cap=d.allocCap();
+        bool anyCan=false;
+        for(int k=0;k<n;++k){
+            const int c=d.consumer(k);
+            const bool can=d.isInputEnabled(c)&&(d.levelL(c)<d.capacityL(c));
+            weight[k]=can?(d.capacityL(c)-d.levelL(c)):0.0;
+            cap[k]=can?d.inputMaxLph(c):0.0;
+            anyCan=anyCan||can;
+        }
+        if(!anyCan){
+            cutDistribution();
+            return;
+        }
+
+        d.allocate(totalOutLph,n);
+        const double* out=d.allocOut();
+        double totalApplied=0.0;
+        for(int k=0;k<n;++k){
+            const int c=d.consumer(k);
+            d.applyInputFlowLph(c,out[k]);
+            totalApplied+=d.currentInputLph(c);
+        }
+        d.applyOutputFlowLph(Principal,totalApplied);
+
+        if(d.levelL(Principal)>=d.capacityL(Principal)-1e-6){
+            d.setInputEnabled(Principal,false);
+            zeroMainInputDial();
+        }
+
+        if(d.levelL(Principal)<=0.1*d.capacityL(Principal)){
+            d.applyOutputFlowLph(Principal,0.0);
+            zeroMainOutputDial();
+        }
+    }
+
+private:
+    Derived& self(){return static_cast<Derived&>(*this);}
+    const Derived& self()const{return static_cast<const Derived&>(*this);}
+};
+
+#endif // PLANTRULES_H
@@ -0,0 +1,202 @@
+#include "recorder.h"
+
+#include <QThread>
+#include <QtEndian>
+#include <cstdio>
+#include <cstring>
+
+#include "metrics.h"
+
+namespace {
+
+const char Magic[8]={'A','G','U','A','T','S','E','R'};
+const quint32 Version=1;
+const int HeaderBytes=32;
+const int Columns=3;
+const qint64 DefaultRingBytes=64ll*1024*1024;
+
+// en little-endian es una copia directa; si no, se convierte por partes
+bool writeDoubles(QFile& out,const double* data,int n){
+#if Q_BYTE_ORDER==Q_LITTLE_ENDIAN
+    const qint64 bytes=qint64(n)*qint64(sizeof(double));
+    return out.write(reinterpret_cast<const char*>(data),bytes)==bytes;
+#else
+    double chunk[1024];
+    for(int k=0;k<n;k+=1024){
+        const int m=qMin(1024,n-k);
+        qToLittleEndian<double>(data+k,m,chunk);
+        const qint64 bytes=qint64(m)*qint64(sizeof(double));
+        if(out.write(reinterpret_cast<const char*>(chunk),bytes)!=bytes) return false;
+    }
+    return true;
+#endif
+}
+
+}
+
+Recorder::Recorder(const QString& path,Format format)
+    : m_path(path),
+    m_format(format),
+    m_ringFrames(0),
+    m_everyTicks(1),
+    m_lossless(false),
+    m_tanks(0),
+    m_sinceFrame(0),
+    m_recorded(0),
+    m_dropped(0),
+    m_writer(nullptr),
+    m_stopWriter(false)
+{
+}
+
+Recorder::~Recorder(){
+    stop();
+}
+
+QString Recorder::path()const{return m_path;}
+Recorder::Format Recorder::format()const{return m_format;}
+QString Recorder::errorString()const{return m_error;}
+void Recorder::setRingFrames(int frames){ if(!m_writer) m_ringFrames=qBound(0,frames,QueueSize-1); }
+void Recorder::setEveryTicks(int ticks){ if(!m_writer) m_everyTicks=qMax(1,ticks); }
+void Recorder::setLossless(bool lossless){ if(!m_writer) m_lossless=lossless; }
+bool Recorder::isRunning()const{return m_writer!=nullptr;}
+unsigned long long Recorder::recordedFrames()const{return m_recorded.load(std::memory_order_relaxed);}
+unsigned long long Recorder::droppedFrames()const{return m_dropped.load(std::memory_order_relaxed);}
+
+bool Recorder::start(int tankCount){
+    if(m_writer) return true;
+    m_tanks=qMax(0,tankCount);
+    m_file.setFileName(m_path);
+    if(!m_file.open(QIODevice::WriteOnly|QIODevice::Truncate)){
+        m_error=m_file.errorString();
+        return false;
+    }
+
+    if(m_format==Binary){
+        uchar header[HeaderBytes];
+        std::memset(header,0,sizeof(header));
+        std::memcpy(header,Magic,sizeof(Magic));
+        qToLittleEndian<quint32>(Version,header+8);
+        qToLittleEndian<quint32>(HeaderBytes,header+12);
+        qToLittleEndian<quint32>(quint32(m_tanks),header+16);
+        qToLittleEndian<quint32>(Columns,header+20);
+        m_file.write(reinterpret_cast<const char*>(header),HeaderBytes);
+    }else{
+        m_file.write("tick,timeS,tank,levelL,inputLph,outputLph\n");
+    }
+
+    // el anillo se reserva una sola vez; con muchos tanques se achica para no pasar de ~64 MB
+    int frames=m_ringFrames;
+    if(frames<=0){
+        const qint64 frameBytes=qMax<qint64>(1,qint64(m_tanks)*Columns*qint64(sizeof(double)));
+        frames=int(qBound<qint64>(4,DefaultRingBytes/frameBytes,QueueSize-1));
+    }
+    m_ring.assign(size_t(frames)*size_t(Columns)*size_t(m_tanks),0.0);
+    m_frameTick.assign(frames,0);
+    m_frameTimeS.assign(frames,0.0);
+    int k=0;
+    while(m_free.pop(k)){}
+    while(m_filled.pop(k)){}
+    for(k=0;k<frames;++k) m_free.push(k);
+
+    m_sinceFrame=0;
+    m_recorded.store(0,std::memory_order_relaxed);
+    m_dropped.store(0,std::memory_order_relaxed);
+    m_stopWriter.store(false,std::memory_order_release);
+    m_writer=QThread::create([this]{ writerLoop(); });
+    m_writer->setObjectName("Recorder");
+    m_writer->start();
+    return true;
+}
+
+void Recorder::stop(){
+    if(!m_writer) return;
+    m_stopWriter.store(true,std::memory_order_release);
+    m_writer->wait();
+    delete m_writer;
+    m_writer=nullptr;
+    m_file.close();
+}
+
+//hilo de simulacion
+
+void Recorder::ticked(const SimEngine& engine){
+    if(++m_sinceFrame<m_everyTicks) return;
+    m_sinceFrame=0;
+    record(engine.network(),engine.tickCount(),engine.timeS());
+}
+
+void Recorder::record(const TankNetwork& net,unsigned long long tick,double timeS){
+    if(!m_writer) return;
+    int k=0;
+    bool got=net.size()>=m_tanks&&m_free.pop(k);
+    if(!got&&m_lossless&&net.size()>=m_tanks){
+        while(!m_free.pop(k)) QThread::yieldCurrentThread();
+        got=true;
+    }
+    if(!got){
+        m_dropped.fetch_add(1,std::memory_order_relaxed);
+        return;
+    }
+    const size_t n=size_t(m_tanks);
+    double* frame=m_ring.data()+size_t(k)*Columns*n;
+    std::memcpy(frame,net.levels(),n*sizeof(double));
+    std::memcpy(frame+n,net.inputFlows(),n*sizeof(double));
+    std::memcpy(frame+2*n,net.outputFlows(),n*sizeof(double));
+    m_frameTick[k]=tick;
+    m_frameTimeS[k]=timeS;
+    m_filled.push(k);
+    AGUA_METRIC_GAUGE(RecorderQueueDepth,m_filled.size());
+    m_recorded.fetch_add(1,std::memory_order_relaxed);
+}
+
+//hilo escritor
+
+void Recorder::writerLoop(){
+    for(;;){
+        const bool stopping=m_stopWriter.load(std::memory_order_acquire);
+        int k=0;
+        bool wrote=false;
+        while(m_filled.pop(k)){
+            writeFrame(k);
+            m_free.push(k);
+            wrote=true;
+        }
+        if(wrote) m_file.flush();
+        if(stopping) break;
+        QThread::msleep(5);
+    }
+}
+
+void Recorder::writeFrame(int k){
+    if(m_format==Binary) writeBinary(k);
+    else writeCsv(k);
+}
+
+void Recorder::writeBinary(int k){
+    uchar head[16];
+    qToLittleEndian<quint64>(m_frameTick[k],head);
+    qToLittleEndian<double>(m_frameTimeS[k],head+8);
+    m_file.write(reinterpret_cast<const char*>(head),sizeof(head));
+    writeDoubles(m_file,m_ring.data()+size_t(k)*Columns*size_t(m_tanks),Columns*m_tanks);
+}
+
+// se arma en un buffer propio y se escribe por bloques; QTextStream es mucho mas lento
+void Recorder::writeCsv(int k){
+    const int n=m_tanks;
+    const double* frame=m_ring.data()+size_t(k)*Columns*size_t(n);
+    const size_t rowMax=160;
+    const size_t block=4096;
+    m_text.resize(block*rowMax);
+    size_t used=0;
+    for(int i=0;i<n;++i){
+        const int w=std::snprintf(m_text.data()+used,rowMax,"%llu,%.3f,%d,%.9g,%.9g,%.9g\n",
+                                  m_frameTick[k],m_frameTimeS[k],i,frame[i],frame[n+i],frame[2*n+i]);
+        used+=size_t(qBound(0,w,int(rowMax)-1));
+        if(used+rowMax>m_text.size()){
+            m_file.write(m_text.data(),qint64(used));
+            used=0;
+        }
+    }
+    if(used>0) m_file.write(m_text.data(),qint64(used));
+}
@@ -0,0 +1,97 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <vector>
+
+#include "simengine.h"
+#include "spscqueue.h"
+#include "tanknetwork.h"
+
+class QThread;
+
+// Serie de tiempo de todos los tanques: nivel, entrada y salida en cada tick.
+// El hilo de simulacion copia las tres columnas de TankNetwork a un cuadro de un
+// anillo reservado de antemano (tres memcpy, sin reservar memoria ni bloquear) y
+// pasa el indice del cuadro a un hilo escritor por una cola lock-free. Si el
+// escritor va atrasado y no hay cuadros libres, el tick se descarta y se cuenta
+// (salvo con setLossless, para corridas sin reloj donde conviene esperar).
+//
+// Binario (little-endian): encabezado de 32 bytes "AGUATSER", u32 version,
+// u32 bytes del encabezado, u32 cantidad de tanques (n), u32 columnas (3), u64 0;
+// despues cuadros de tamano fijo: u64 tick, f64 timeS, f64[n] nivel,
+// f64[n] entrada, f64[n] salida.
+// CSV: una fila por tanque y tick (tick,timeS,tank,levelL,inputLph,outputLph).
+
+class Recorder:public TickObserver {
+public:
+    enum Format {
+        Binary,
+        Csv
+    };
+
+    explicit Recorder(const QString& path,Format format=Binary);
+    ~Recorder()override;
+    Recorder(const Recorder&)=delete;
+    Recorder& operator=(const Recorder&)=delete;
+
+    QString path()const;
+    Format format()const;
+    QString errorString()const;
+
+    // antes de start(): cuadros del anillo (0 = segun la cantidad de tanques,
+    // unos 64 MB) y cada cuantos ticks se guarda uno
+    void setRingFrames(int frames);
+    void setEveryTicks(int ticks);
+    void setLossless(bool lossless);
+
+    bool start(int tankCount);
+    // escribe lo que quede en el anillo y cierra el archivo
+    void stop();
+    bool isRunning()const;
+
+    // hilo de simulacion
+    void ticked(const SimEngine& engine)override;
+    void record(const TankNetwork& net,unsigned long long tick,double timeS);
+
+    unsigned long long recordedFrames()const;
+    unsigned long long droppedFrames()const;
+
+private:
+    static constexpr int QueueSize=256;
+
+    QString m_path;
+    Format m_format;
+    QString m_error;
+    int m_ringFrames;
+    int m_everyTicks;
+    bool m_lossless;
+    int m_tanks;
+
+    // cuadro k: columnas en m_ring[k*3*n ...], tick y tiempo aparte
+    std::vector<double> m_ring;
+    std::vector<unsigned long long> m_frameTick;
+    std::vector<double> m_frameTimeS;
+    SpscQueue<int,QueueSize> m_free;
+    SpscQueue<int,QueueSize> m_filled;
+
+    // lado del hilo de simulacion
+    int m_sinceFrame;
+    std::atomic<unsigned long long> m_recorded;
+    std::atomic<unsigned long long> m_dropped;
+
+    // lado del escritor
+    QThread* m_writer;
+    std::atomic<bool> m_stopWriter;
+    QFile m_file;
+    std::vector<char> m_text;
+
+    void writerLoop();
+    void writeFrame(int k);
+    void writeBinary(int k);
+    void writeCsv(int k);
+};
+
+#endif // RECORDER_H
@@ -0,0 +1,47 @@
+#include "scenario.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "simjson.h"
+
+void prepareScenario(SimEngine& engine,const Scenario& scenario){
+    engine.setTickS(scenario.tickS);
+    stateFromJson(engine,scenario.state);
+    if(scenario.hasConsumers) engine.setConsumers(scenario.consumers);
+}
+
+// se avanza de parada en parada (evento o muestra, lo que venga antes); entre
+// paradas el motor usa el modo pedido sin saber nada del guion
+int playScenario(SimEngine& engine,const Scenario& scenario,const ScenarioSample& sample){
+    const double startS=engine.timeS();
+    const std::vector<ScenarioEvent>& events=scenario.events;
+    std::size_t next=0;
+    int applied=0;
+    auto applyDue=[&](double tS){
+        for(;next<events.size()&&events[next].timeS<=tS;++next){
+            const SimCommand& c=events[next].command;
+            if(c.tank<0||c.tank>=engine.tankCount()) continue;
+            applySimCommand(engine,c);
+            ++applied;
+        }
+    };
+
+    applyDue(0.0);
+    if(sample) sample(engine);
+    double tS=0.0;
+    long long k=1;
+    while(tS<scenario.durationS){
+        const double sampleAtS=scenario.sampleS>0.0?std::min(double(k)*scenario.sampleS,scenario.durationS):scenario.durationS;
+        const double eventAtS=next<events.size()?events[next].timeS:std::numeric_limits<double>::infinity();
+        const double stopS=std::min(sampleAtS,eventAtS);
+        engine.runUntil(startS+stopS,scenario.mode);
+        tS=stopS;
+        applyDue(tS);
+        if(tS>=sampleAtS){
+            if(sample) sample(engine);
+            ++k;
+        }
+    }
+    return applied;
+}
@@ -0,0 +1,42 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <QJsonObject>
+
+#include <functional>
+#include <vector>
+
+#include "simcommand.h"
+#include "simengine.h"
+
+// Escenario guionado para correr sin GUI (aguacli): estado inicial con el formato
+// de sim_state.json, modo de paso y los comandos del operador (diales, casillas,
+// capacidades, topes) con el instante en que se aplican. El formato JSON esta en
+// simjson.h.
+
+struct ScenarioEvent {
+    double timeS=0.0;
+    SimCommand command;
+};
+
+struct Scenario {
+    double tickS=0.2;
+    double durationS=3600.0;
+    double sampleS=0.0;     // cada cuanto se toma una muestra (0: solo al final)
+    SimEngine::StepMode mode=SimEngine::Ticked;
+    QJsonObject state;
+    bool hasConsumers=false;
+    std::vector<int> consumers;
+    std::vector<ScenarioEvent> events;  // ordenados por tiempo
+};
+
+// deja el motor en el instante 0 del escenario (tick, estado, consumidores)
+void prepareScenario(SimEngine& engine,const Scenario& scenario);
+
+// corre hasta durationS aplicando cada evento al llegar a su instante; sample se
+// llama en t=0, cada sampleS y al final, despues de los eventos de ese instante.
+// Devuelve cuantos eventos se aplicaron.
+using ScenarioSample=std::function<void(const SimEngine&)>;
+int playScenario(SimEngine& engine,const Scenario& scenario,const ScenarioSample& sample);
+
+#endif // SCENARIO_H
@@ -0,0 +1,26 @@
+#include "simcommand.h"
+
+void applySimCommand(SimEngine& engine,const SimCommand& c){
+    const int v=int(c.value);
+    switch(c.type){
+    case SimCommand::SetMainInputDial: engine.setMainInputDial(v); break;
+    case SimCommand::SetMainOutputDial: engine.setMainOutputDial(v); break;
+    case SimCommand::SetAuxOutputDial: engine.setAuxOutputDial(c.tank,v); break;
+    case SimCommand::SetAuxInputEnabled: engine.setAuxInputEnabled(c.tank,c.value!=0.0); break;
+    case SimCommand::ApplyDistribution: engine.applyDistributionFromDial(v); break;
+    case SimCommand::ReapplyAuxOutputDials:
+        engine.setAuxOutputDial(SimEngine::Auxiliar1,engine.auxOutputDial(SimEngine::Auxiliar1));
+        engine.setAuxOutputDial(SimEngine::Auxiliar2,engine.auxOutputDial(SimEngine::Auxiliar2));
+        break;
+    case SimCommand::SetCapacity: engine.setCapacityL(c.tank,c.value); break;
+    case SimCommand::SetLevel: engine.setLevelL(c.tank,c.value); break;
+    case SimCommand::SetInputMax: engine.setInputMaxLph(c.tank,c.value); break;
+    case SimCommand::SetOutputMax: engine.setOutputMaxLph(c.tank,c.value); break;
+    case SimCommand::SetInputEnabled: engine.setInputEnabled(c.tank,c.value!=0.0); break;
+    case SimCommand::ApplyInputFlow: engine.applyInputFlowLph(c.tank,c.value); break;
+    case SimCommand::ApplyOutputFlow: engine.applyOutputFlowLph(c.tank,c.value); break;
+    case SimCommand::UpdateCapacity: engine.updateCapacityL(c.tank,c.value); break;
+    case SimCommand::UpdateInputMax: engine.updateInputMaxLph(c.tank,c.value); break;
+    case SimCommand::UpdateOutputMax: engine.updateOutputMaxLph(c.tank,c.value); break;
+    }
+}
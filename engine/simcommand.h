@@ -0,0 +1,37 @@
+#ifndef SIMCOMMAND_H
+#define SIMCOMMAND_H
+
+#include "simengine.h"
+
+// Comando del operador hacia el motor. Es un valor chico y copiable para poder
+// pasarlo por colas entre hilos sin reservar memoria.
+
+struct SimCommand {
+    enum Type : unsigned char {
+        SetMainInputDial,
+        SetMainOutputDial,
+        SetAuxOutputDial,
+        SetAuxInputEnabled,
+        ApplyDistribution,
+        ReapplyAuxOutputDials,
+        SetCapacity,
+        SetLevel,
+        SetInputMax,
+        SetOutputMax,
+        SetInputEnabled,
+        ApplyInputFlow,
+        ApplyOutputFlow,
+        // cambios de configuracion que recalculan solo lo afectado (SimEngine::update*)
+        UpdateCapacity,
+        UpdateInputMax,
+        UpdateOutputMax
+    };
+
+    Type type=ApplyDistribution;
+    int tank=0;
+    double value=0.0;
+};
+
+void applySimCommand(SimEngine& engine,const SimCommand& c);
+
+#endif // SIMCOMMAND_H
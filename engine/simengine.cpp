@@ -0,0 +1,273 @@
+#include "simengine.h"
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+SimEngine::SimEngine(double tickS)
+    : m_net(),
+    m_pending(3,0u),
+    m_auxOutDial(3,0),
+    m_tickS(tickS>0.0?tickS:0.2),
+    m_timeS(0.0),
+    m_ticks(0),
+    m_observer(nullptr),
+    m_integrator(nullptr),
+    m_plantEnd(Auxiliar2+1)
+{
+    m_net.resize(3);
+    setConsumers({Auxiliar1,Auxiliar2});
+}
+
+int SimEngine::tankCount()const{return m_net.size();}
+
+int SimEngine::addTank(double capacityL){
+    m_pending.push_back(0u);
+    m_auxOutDial.push_back(0);
+    m_isConsumer.push_back(0);
+    return m_net.addTank(capacityL);
+}
+
+TankNetwork& SimEngine::network(){return m_net;}
+const TankNetwork& SimEngine::network()const{return m_net;}
+double SimEngine::tickS()const{return m_tickS;}
+void SimEngine::setTickS(double s){ if(s>0.0) m_tickS=s; }
+double SimEngine::timeS()const{return m_timeS;}
+unsigned long long SimEngine::tickCount()const{return m_ticks;}
+
+//avance de la simulacion
+
+void SimEngine::step(unsigned long long n){
+    Integrator* integrator=activeIntegrator();
+    for(unsigned long long k=0;k<n;++k){
+        if(integrator) integrate(*integrator,m_tickS);
+        else if(m_net.tick(m_tickS)>0) dispatchEvents(0,tankCount());
+        ++m_ticks;
+        m_timeS+=m_tickS;
+        if(m_observer) m_observer->ticked(*this);
+    }
+}
+
+void SimEngine::runUntil(double tS,StepMode mode){
+    if(tS<=m_timeS) return;
+    // con caudales que dependen del nivel no hay solucion cerrada entre eventos
+    if(mode==Analytic&&m_net.hasLevelDependentFlows()) mode=Adaptive;
+    if(mode==Analytic){ runAnalytic(tS); return; }
+    if(mode==Adaptive){
+        integrate(m_integrator?*m_integrator:m_adaptive,tS-m_timeS);
+        m_ticks+=(unsigned long long)((tS-m_timeS)/m_tickS+0.5);
+        m_timeS=tS;
+        return;
+    }
+    unsigned long long n=(unsigned long long)((tS-m_timeS)/m_tickS+0.5);
+    if(n>0) step(n);
+}
+
+// Entre eventos los flujos son constantes: cada tanque calcula cuando ocurre su
+// proximo evento, se guardan en una cola de prioridad y se salta al primero.
+// Cuesta O(eventos log N) en vez de O(ticks x N).
+namespace {
+struct QueuedEvent {
+    double timeS;
+    int tank;
+    unsigned version;
+    bool operator>(const QueuedEvent& o)const{ return timeS>o.timeS||(timeS==o.timeS&&tank>o.tank); }
+};
+}
+
+void SimEngine::runAnalytic(double tS){
+    const int n=tankCount();
+    const int plantEnd=std::min(n,m_plantEnd);
+    std::vector<double> tankTime(n,m_timeS);
+    std::vector<unsigned> version(n,0u);
+    std::priority_queue<QueuedEvent,std::vector<QueuedEvent>,std::greater<QueuedEvent>> queue;
+
+    auto schedule=[&](int i){
+        ++version[i];
+        double t=tankTime[i]+m_net.timeToNextEventS(i);
+        if(t<=tS) queue.push({t,i,version[i]});
+    };
+    auto advance=[&](int i,double t){
+        unsigned ev=m_net.advanceLinear(i,t-tankTime[i]);
+        tankTime[i]=t;
+        return ev;
+    };
+    // la planta (principal y consumidores) reacciona con todos sus tanques parados
+    // en el mismo instante
+    auto settle=[&](int begin,int end,double t){
+        for(int i=begin;i<end;++i) advance(i,t);
+        for(int i=begin;i<end;++i){
+            unsigned ev=m_net.events(i);
+            if(!ev) continue;
+            m_pending[i]|=ev;
+            react(i,ev);
+        }
+        for(int i=begin;i<end;++i) schedule(i);
+    };
+
+    for(int i=0;i<n;++i) schedule(i);
+
+    while(!queue.empty()){
+        QueuedEvent e=queue.top();
+        queue.pop();
+        if(e.version!=version[e.tank]) continue;
+        if(e.tank<plantEnd) settle(0,plantEnd,e.timeS);
+        else settle(e.tank,e.tank+1,e.timeS);
+    }
+
+    for(int i=0;i<n;++i){
+        unsigned ev=advance(i,tS);
+        m_pending[i]|=ev;
+    }
+    m_ticks+=(unsigned long long)((tS-m_timeS)/m_tickS+0.5);
+    m_timeS=tS;
+}
+
+Integrator* SimEngine::activeIntegrator(){
+    if(m_integrator) return m_integrator;
+    return m_net.hasLevelDependentFlows()?&m_adaptive:nullptr;
+}
+
+// el integrador para en cada cruce; ahi se aplican las reglas de umbral a todos
+// los tanques y se reacciona en orden de indice, igual que en un tick
+void SimEngine::integrate(Integrator& integrator,double dtS){
+    double left=dtS;
+    settleAll();
+    while(left>0.0){
+        const double h=integrator.advance(m_net,left);
+        left=(h>=left)?0.0:left-h;
+        settleAll();
+    }
+}
+
+void SimEngine::settleAll(){
+    const int n=tankCount();
+    int withEvents=0;
+    for(int i=0;i<n;++i) withEvents+=(m_net.settle(i)!=0);
+    if(withEvents>0) dispatchEvents(0,n);
+}
+
+void SimEngine::setTickObserver(TickObserver* observer){ m_observer=observer; }
+void SimEngine::setIntegrator(Integrator* integrator){ m_integrator=integrator; }
+Integrator* SimEngine::integrator()const{return m_integrator;}
+void SimEngine::setOutflowLaw(int i,TankNetwork::OutflowLaw law){ m_net.setOutflowLaw(i,law); }
+TankNetwork::OutflowLaw SimEngine::outflowLaw(int i)const{return m_net.outflowLaw(i);}
+
+unsigned SimEngine::takeEvents(int i){
+    unsigned ev=m_pending[i];
+    m_pending[i]=0u;
+    return ev;
+}
+
+void SimEngine::restore(double timeS,unsigned long long ticks,int inDial,int outDial,const int* auxOutDial){
+    const int n=tankCount();
+    m_pending.assign(n,0u);
+    m_auxOutDial.assign(auxOutDial,auxOutDial+n);
+    m_timeS=timeS;
+    m_ticks=ticks;
+    m_inDial=inDial;
+    m_outDial=outDial;
+    std::vector<int> consumers=m_consumers;
+    setConsumers(consumers);
+}
+
+// en orden de indice, asi el resultado no depende de quien llega primero
+void SimEngine::dispatchEvents(int begin,int end){
+    const std::uint8_t* evs=m_net.eventFlags();
+    for(int i=begin;i<end;++i){
+        unsigned ev=evs[i];
+        if(!ev) continue;
+        m_pending[i]|=ev;
+        react(i,ev);
+    }
+}
+
+//parametros por tanque
+
+void SimEngine::setCapacityL(int i,double L){ m_net.setCapacityL(i,L); }
+void SimEngine::setLevelL(int i,double L){ m_net.setLevelL(i,L); }
+void SimEngine::setInputMaxLph(int i,double Lph){ m_net.setInputMaxLph(i,Lph); }
+void SimEngine::setOutputMaxLph(int i,double Lph){ m_net.setOutputMaxLph(i,Lph); }
+void SimEngine::setInputEnabled(int i,bool enabled){ m_net.setInputEnabled(i,enabled); }
+void SimEngine::applyInputFlowLph(int i,double Lph){ m_net.applyInputFlowLph(i,Lph); }
+void SimEngine::applyOutputFlowLph(int i,double Lph){ m_net.applyOutputFlowLph(i,Lph); }
+
+bool SimEngine::updateCapacityL(int i,double L){
+    if(std::max(1.0,L)==capacityL(i)) return false;
+    setCapacityL(i,L);
+    // el 10% y el lleno del principal se mueven con la capacidad; en un
+    // consumidor cambia el espacio libre que pesa en el reparto (volver a poner
+    // el dial de salida reparte de nuevo sin tocar la entrada del principal)
+    if(i==Principal) applyDistributionFromDial(m_outDial);
+    else if(m_isConsumer[i]) setMainOutputDial(m_outDial);
+    return true;
+}
+
+bool SimEngine::updateInputMaxLph(int i,double Lph){
+    if(std::max(0.0,Lph)==inputMaxLph(i)) return false;
+    setInputMaxLph(i,Lph);
+    if(i==Principal) applyInputFlowLph(Principal,mainInputRequestedLph());
+    else if(m_isConsumer[i]) setMainOutputDial(m_outDial);
+    else applyInputFlowLph(i,currentInputLph(i));
+    return true;
+}
+
+bool SimEngine::updateOutputMaxLph(int i,double Lph){
+    if(std::max(0.0,Lph)==outputMaxLph(i)) return false;
+    setOutputMaxLph(i,Lph);
+    if(i==Principal) setMainOutputDial(m_outDial);
+    else if(m_isConsumer[i]) setAuxOutputDial(i,m_auxOutDial[i]);
+    else applyOutputFlowLph(i,currentOutputLph(i));
+    return true;
+}
+
+double SimEngine::capacityL(int i)const{return m_net.capacityL(i);}
+double SimEngine::levelL(int i)const{return m_net.levelL(i);}
+double SimEngine::inputMaxLph(int i)const{return m_net.inputMaxLph(i);}
+double SimEngine::outputMaxLph(int i)const{return m_net.outputMaxLph(i);}
+double SimEngine::currentInputLph(int i)const{return m_net.inputFlowLph(i);}
+double SimEngine::currentOutputLph(int i)const{return m_net.outputFlowLph(i);}
+bool SimEngine::isInputEnabled(int i)const{return m_net.isInputEnabled(i);}
+bool SimEngine::canWithdraw(int i)const{return m_net.canWithdraw(i);}
+
+//consumidores del principal
+
+void SimEngine::setConsumers(const std::vector<int>& tanks){
+    const int n=tankCount();
+    for(int c:m_consumers) if(c<n) m_net.setInputSource(c,-1);
+    m_isConsumer.assign(n,0);
+    m_consumers.clear();
+    m_plantEnd=Auxiliar2+1;
+    for(int i:tanks){
+        if(i<=Principal||i>=n||m_isConsumer[i]) continue;
+        m_isConsumer[i]=1;
+        m_consumers.push_back(i);
+        // lo que recibe baja con la salida del principal si descarga por gravedad
+        m_net.setInputSource(i,Principal);
+        m_plantEnd=std::max(m_plantEnd,i+1);
+    }
+    const int c=int(m_consumers.size());
+    m_alloc.reserve(c);
+    m_allocWeight.assign(c,0.0);
+    m_allocCap.assign(c,0.0);
+    m_allocOut.assign(c,0.0);
+}
+
+const std::vector<int>& SimEngine::consumers()const{return m_consumers;}
+bool SimEngine::isConsumer(int i)const{return i>=0&&i<int(m_isConsumer.size())&&m_isConsumer[i];}
+
+//comandos de la planta
+
+int SimEngine::auxOutputDial(int i)const{return m_auxOutDial[i];}
+
+void SimEngine::allocate(double totalLph,int n){
+    m_alloc.allocate(totalLph,m_allocWeight.data(),m_allocCap.data(),nullptr,n,m_allocOut.data());
+}
+
+// el reparto de PlantRules, medido
+void SimEngine::updateAuxiliaryInputs(double totalOutLph){
+    AGUA_METRIC_SCOPE(DistributionNs);
+    PlantRules<SimEngine>::updateAuxiliaryInputs(totalOutLph);
+}
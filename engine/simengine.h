@@ -0,0 +1,150 @@
+#ifndef SIMENGINE_H
+#define SIMENGINE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "flowallocator.h"
+#include "integrator.h"
+#include "plantrules.h"
+#include "tanknetwork.h"
+
+// Motor de simulacion sin widgets: guarda el estado de los tanques (TankNetwork)
+// y la logica de la planta (principal -> auxiliares). La GUI solo observa y
+// manda comandos. Los tanques agregados con addTank() despues de los tres de la
+// planta se integran en el mismo tick pero no participan de la distribucion
+// salvo que se agreguen como consumidores del principal con setConsumers().
+// Las reglas de la planta (diales, reparto, reacciones) estan en plantrules.h.
+
+class SimEngine;
+
+// se llama en el hilo de simulacion despues de cada paso de step() (no en el
+// modo analitico, que no tiene ticks); tiene que ser barato
+class TickObserver {
+public:
+    virtual ~TickObserver()=default;
+    virtual void ticked(const SimEngine& engine)=0;
+};
+
+class SimEngine : public PlantRules<SimEngine> {
+public:
+    enum Event : unsigned {
+        EventFull=TankNetwork::EventFull,
+        EventEmpty=TankNetwork::EventEmpty,
+        EventCanWithdrawChanged=TankNetwork::EventCanWithdrawChanged
+    };
+
+    enum StepMode {
+        Ticked,     // paso fijo de tickS, igual que el reloj de la GUI
+        Analytic,   // salta de evento en evento (lleno / cruce del 10%)
+        Adaptive    // integra de cruce en cruce con paso adaptativo (sin ticks)
+    };
+
+    static constexpr int Principal=0;
+    static constexpr int Auxiliar1=1;
+    static constexpr int Auxiliar2=2;
+
+    explicit SimEngine(double tickS=0.2);
+
+    int tankCount()const;
+    int addTank(double capacityL=100.0);
+    TankNetwork& network();
+    const TankNetwork& network()const;
+    double tickS()const;
+    void setTickS(double s);
+    double timeS()const;
+    unsigned long long tickCount()const;
+
+    // avance sin reloj de pared
+    void step(unsigned long long n=1);
+    void runUntil(double tS,StepMode mode=Ticked);
+    unsigned takeEvents(int i);
+    void setTickObserver(TickObserver* observer);
+
+    // como avanza cada tick: sin integrador (por defecto) es el paso explicito
+    // fijo de siempre mientras todos los caudales sean constantes; con descarga
+    // por gravedad, o con uno puesto aca, los ticks y el modo Adaptive integran
+    // con paso propio y se detienen en cada cruce. No pasa a ser del motor.
+    void setIntegrator(Integrator* integrator);
+    Integrator* integrator()const;
+    void setOutflowLaw(int i,TankNetwork::OutflowLaw law);
+    TankNetwork::OutflowLaw outflowLaw(int i)const;
+
+    // vuelve a un estado guardado sin pasar por la logica de los diales; la red
+    // (network().restore) ya tiene que tener la cantidad final de tanques
+    void restore(double timeS,unsigned long long ticks,int inDial,int outDial,const int* auxOutDial);
+
+    // parametros y flujos de cada tanque
+    void setCapacityL(int i,double L);
+    void setLevelL(int i,double L);
+    void setInputMaxLph(int i,double Lph);
+    void setOutputMaxLph(int i,double Lph);
+    void setInputEnabled(int i,bool enabled);
+    void applyInputFlowLph(int i,double Lph);
+    void applyOutputFlowLph(int i,double Lph);
+    // cambios de configuracion con la simulacion andando: no hacen nada si el
+    // valor no cambia y recalculan solo lo que depende de ese tanque (la entrada
+    // o el reparto del principal, el dial de un consumidor) en vez de volver a
+    // pasar por toda la planta. Devuelven si cambio algo.
+    bool updateCapacityL(int i,double L);
+    bool updateInputMaxLph(int i,double Lph);
+    bool updateOutputMaxLph(int i,double Lph);
+    double capacityL(int i)const;
+    double levelL(int i)const;
+    double inputMaxLph(int i)const;
+    double outputMaxLph(int i)const;
+    double currentInputLph(int i)const;
+    double currentOutputLph(int i)const;
+    bool isInputEnabled(int i)const;
+    bool canWithdraw(int i)const;
+
+    // comandos de la planta: setMainInputDial, setMainOutputDial, setAuxOutputDial,
+    // setAuxInputEnabled y applyDistributionFromDial vienen de PlantRules
+    int auxOutputDial(int i)const;
+
+    // tanques que reciben la salida del principal (por defecto los dos auxiliares);
+    // se ignoran los indices invalidos y el principal
+    void setConsumers(const std::vector<int>& tanks);
+    const std::vector<int>& consumers()const;
+    bool isConsumer(int i)const;
+
+private:
+    friend class PlantRules<SimEngine>;
+
+    TankNetwork m_net;
+    std::vector<unsigned> m_pending;
+    std::vector<int> m_auxOutDial;
+    double m_tickS;
+    double m_timeS;
+    unsigned long long m_ticks;
+    TickObserver* m_observer;
+    Integrator* m_integrator;
+    AdaptiveIntegrator m_adaptive;
+    std::vector<int> m_consumers;
+    std::vector<std::uint8_t> m_isConsumer;
+    int m_plantEnd;
+
+    // reparto de la salida del principal, sin reservar memoria en cada tick
+    FlowAllocator m_alloc;
+    std::vector<double> m_allocWeight;
+    std::vector<double> m_allocCap;
+    std::vector<double> m_allocOut;
+
+    void dispatchEvents(int begin,int end);
+    void runAnalytic(double tS);
+    Integrator* activeIntegrator();
+    void integrate(Integrator& integrator,double dtS);
+    void settleAll();
+
+    // lo que usa PlantRules
+    int consumerCount()const{return int(m_consumers.size());}
+    int consumer(int k)const{return m_consumers[k];}
+    int& auxDial(int i){return m_auxOutDial[i];}
+    double* allocWeight(){return m_allocWeight.data();}
+    double* allocCap(){return m_allocCap.data();}
+    double* allocOut(){return m_allocOut.data();}
+    void allocate(double totalLph,int n);
+    void updateAuxiliaryInputs(double totalOutLph);
+};
+
+#endif // SIMENGINE_H
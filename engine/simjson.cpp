@@ -0,0 +1,341 @@
+#include "simjson.h"
+
+#include <QHash>
+#include <QJsonArray>
+
+#include <algorithm>
+
+QJsonObject tankToJson(const SimEngine& engine,int i){
+    QJsonObject obj;
+    obj["capacityL"]=engine.capacityL(i);
+    obj["levelL"]=engine.levelL(i);
+    obj["inputMaxLph"]=engine.inputMaxLph(i);
+    obj["outputMaxLph"]=engine.outputMaxLph(i);
+    obj["inputEnabled"]=engine.isInputEnabled(i);
+    if(engine.outflowLaw(i)==TankNetwork::OutflowGravity) obj["outflow"]="gravity";
+    return obj;
+}
+
+void tankFromJson(SimEngine& engine,int i,const QJsonObject& obj){
+    if(obj.contains("capacityL")) engine.setCapacityL(i,obj["capacityL"].toDouble());
+    if(obj.contains("levelL")) engine.setLevelL(i,obj["levelL"].toDouble());
+    if(obj.contains("inputMaxLph")) engine.setInputMaxLph(i,obj["inputMaxLph"].toDouble());
+    if(obj.contains("outputMaxLph")) engine.setOutputMaxLph(i,obj["outputMaxLph"].toDouble());
+    if(obj.contains("inputEnabled")) engine.setInputEnabled(i,obj["inputEnabled"].toBool());
+    if(obj.contains("outflow"))
+        engine.setOutflowLaw(i,obj["outflow"].toString()=="gravity"?TankNetwork::OutflowGravity:TankNetwork::OutflowConstant);
+}
+
+QJsonObject stateToJson(const SimEngine& engine){
+    QJsonObject root;
+    root["principal"]=tankToJson(engine,SimEngine::Principal);
+    root["aux1"]=tankToJson(engine,SimEngine::Auxiliar1);
+    root["aux2"]=tankToJson(engine,SimEngine::Auxiliar2);
+
+    const int n=engine.tankCount();
+    if(n>SimEngine::Auxiliar2+1){
+        QJsonArray extra;
+        for(int i=SimEngine::Auxiliar2+1;i<n;++i) extra.append(tankToJson(engine,i));
+        root["extra"]=extra;
+    }
+    return root;
+}
+
+// los tanques extra que falten se crean; los que sobren en el motor quedan como estan
+bool stateFromJson(SimEngine& engine,const QJsonObject& root){
+    if(root.contains("principal")) tankFromJson(engine,SimEngine::Principal,root["principal"].toObject());
+    if(root.contains("aux1")) tankFromJson(engine,SimEngine::Auxiliar1,root["aux1"].toObject());
+    if(root.contains("aux2")) tankFromJson(engine,SimEngine::Auxiliar2,root["aux2"].toObject());
+
+    if(!root.contains("extra")) return true;
+    if(!root["extra"].isArray()) return false;
+    const QJsonArray extra=root["extra"].toArray();
+    for(int k=0;k<int(extra.size());++k){
+        int i=SimEngine::Auxiliar2+1+k;
+        if(i>=engine.tankCount()) engine.addTank();
+        tankFromJson(engine,i,extra[k].toObject());
+    }
+    return true;
+}
+
+static bool paramFromJson(const QJsonValue& v,ParamSpec& p,const QString& name,QString* error){
+    if(v.isDouble()){ p=ParamSpec::fixed(v.toDouble()); return true; }
+    const QJsonObject o=v.toObject();
+    const QJsonArray grid=o["grid"].toArray();
+    const QJsonArray uniform=o["uniform"].toArray();
+    const QJsonArray normal=o["normal"].toArray();
+    QString why;
+    if(grid.size()==3){
+        p=ParamSpec::grid(grid[0].toDouble(),grid[1].toDouble(),grid[2].toInt());
+        if(grid[2].toInt()>0) return true;
+        why="la grilla necesita al menos un paso";
+    }else if(uniform.size()==2){
+        p=ParamSpec::uniform(uniform[0].toDouble(),uniform[1].toDouble());
+        if(p.a<=p.b) return true;
+        why="uniforme con a > b";
+    }else if(normal.size()==2){
+        p=ParamSpec::normal(normal[0].toDouble(),normal[1].toDouble());
+        if(p.b>0.0) return true;
+        why="normal con desvio <= 0";
+    }else{
+        why="se espera un numero, grid, uniform o normal";
+    }
+    if(error) *error=QString("parametro invalido: %1 (%2)").arg(name).arg(why);
+    return false;
+}
+
+static bool tankParamsFromJson(const QJsonObject& root,const char* key,ParamSpec* params,QString* error){
+    if(!root.contains(key)) return true;
+    const QJsonObject o=root[key].toObject();
+    const char* tanks[3]={"principal","aux1","aux2"};
+    for(int t=0;t<3;++t){
+        if(!o.contains(tanks[t])) continue;
+        if(!paramFromJson(o[tanks[t]],params[t],QString("%1.%2").arg(key).arg(tanks[t]),error)) return false;
+    }
+    return true;
+}
+
+bool sweepSpecFromJson(const QJsonObject& root,SweepSpec& spec,QString* error){
+    if(!tankParamsFromJson(root,"capacityL",spec.capacityL,error)) return false;
+    if(!tankParamsFromJson(root,"inputMaxLph",spec.inputMaxLph,error)) return false;
+    if(!tankParamsFromJson(root,"outputMaxLph",spec.outputMaxLph,error)) return false;
+
+    spec.replicates=root["replicates"].toInt(spec.replicates);
+    spec.seed=unsigned(root["seed"].toDouble(spec.seed));
+    spec.durationS=root["durationS"].toDouble(spec.durationS);
+    spec.tickS=root["tickS"].toDouble(spec.tickS);
+    spec.initialLevelFrac=root["initialLevelFrac"].toDouble(spec.initialLevelFrac);
+    spec.mainInputDial=root["mainInputDial"].toInt(spec.mainInputDial);
+    spec.transferDial=root["transferDial"].toInt(spec.transferDial);
+    spec.refillBelowFrac=root["refillBelowFrac"].toDouble(spec.refillBelowFrac);
+
+    if(root.contains("demand")){
+        const QJsonObject d=root["demand"].toObject();
+        if(d.contains("dial")){
+            const QJsonArray dial=d["dial"].toArray();
+            spec.demandDial.clear();
+            for(int k=0;k<int(dial.size());++k) spec.demandDial.push_back(dial[k].toDouble());
+        }
+        spec.demandStepS=d["stepS"].toDouble(spec.demandStepS);
+        spec.demandNoise=d["noise"].toDouble(spec.demandNoise);
+    }
+
+    if(spec.durationS<=0.0||spec.tickS<=0.0){
+        if(error) *error="durationS y tickS tienen que ser positivos";
+        return false;
+    }
+    if(sweepRunCount(spec)<0){
+        if(error) *error="demasiadas corridas (grillas x replicates)";
+        return false;
+    }
+    return true;
+}
+
+static QJsonObject statToJson(const SweepStat& s){
+    QJsonObject o;
+    o["mean"]=s.mean;
+    o["stddev"]=s.stddev;
+    o["min"]=s.min;
+    o["p50"]=s.p50;
+    o["p95"]=s.p95;
+    o["max"]=s.max;
+    return o;
+}
+
+QJsonObject sweepSummaryToJson(const SweepSummary& summary){
+    QJsonObject root;
+    root["runs"]=summary.runs;
+    QJsonObject tmin;
+    tmin["principal"]=statToJson(summary.timeAtMinimumS[SimEngine::Principal]);
+    tmin["aux1"]=statToJson(summary.timeAtMinimumS[SimEngine::Auxiliar1]);
+    tmin["aux2"]=statToJson(summary.timeAtMinimumS[SimEngine::Auxiliar2]);
+    root["timeAtMinimumS"]=tmin;
+    root["overflowEvents"]=statToJson(summary.overflowEvents);
+    root["unmetDemandL"]=statToJson(summary.unmetDemandL);
+    root["unmetDemandFrac"]=statToJson(summary.unmetDemandFrac);
+    return root;
+}
+
+namespace {
+
+struct ScenarioCommandName {
+    const char* name;
+    SimCommand::Type type;
+    bool perTank;
+};
+
+const ScenarioCommandName scenarioCommands[]={
+    {"mainInputDial",SimCommand::SetMainInputDial,false},
+    {"mainOutputDial",SimCommand::SetMainOutputDial,false},
+    {"distribution",SimCommand::ApplyDistribution,false},
+    {"auxOutputDial",SimCommand::SetAuxOutputDial,true},
+    {"auxInput",SimCommand::SetAuxInputEnabled,true},
+    {"reapplyAuxDials",SimCommand::ReapplyAuxOutputDials,false},
+    {"capacityL",SimCommand::SetCapacity,true},
+    {"levelL",SimCommand::SetLevel,true},
+    {"inputMaxLph",SimCommand::SetInputMax,true},
+    {"outputMaxLph",SimCommand::SetOutputMax,true},
+    {"inputEnabled",SimCommand::SetInputEnabled,true},
+    {"inputFlowLph",SimCommand::ApplyInputFlow,true},
+    {"outputFlowLph",SimCommand::ApplyOutputFlow,true},
+    {"updateCapacityL",SimCommand::UpdateCapacity,true},
+    {"updateInputMaxLph",SimCommand::UpdateInputMax,true},
+    {"updateOutputMaxLph",SimCommand::UpdateOutputMax,true}
+};
+
+int scenarioTankIndex(const QJsonValue& v,int n){
+    if(v.isString()){
+        const QString name=v.toString();
+        if(name=="principal") return SimEngine::Principal;
+        if(name=="aux1") return SimEngine::Auxiliar1;
+        if(name=="aux2") return SimEngine::Auxiliar2;
+        return -1;
+    }
+    const int i=v.toInt(-1);
+    return (i>=0&&i<n)?i:-1;
+}
+
+}
+
+bool scenarioFromJson(const QJsonObject& root,Scenario& scenario,QString* error){
+    scenario.tickS=root["tickS"].toDouble(scenario.tickS);
+    scenario.durationS=root["durationS"].toDouble(scenario.durationS);
+    scenario.sampleS=root["sampleS"].toDouble(scenario.sampleS);
+    const QString mode=root["mode"].toString("ticked");
+    if(mode=="ticked") scenario.mode=SimEngine::Ticked;
+    else if(mode=="analytic") scenario.mode=SimEngine::Analytic;
+    else if(mode=="adaptive") scenario.mode=SimEngine::Adaptive;
+    else{
+        if(error) *error=QString("modo desconocido: %1").arg(mode);
+        return false;
+    }
+    if(scenario.durationS<=0.0||scenario.tickS<=0.0||scenario.sampleS<0.0){
+        if(error) *error="durationS y tickS tienen que ser positivos y sampleS no negativo";
+        return false;
+    }
+
+    scenario.state=root["state"].toObject();
+    if(scenario.state.contains("extra")&&!scenario.state["extra"].isArray()){
+        if(error) *error="state.extra tiene que ser un arreglo";
+        return false;
+    }
+    const int tanks=SimEngine::Auxiliar2+1+int(scenario.state["extra"].toArray().size());
+
+    scenario.hasConsumers=root.contains("consumers");
+    scenario.consumers.clear();
+    const QJsonArray consumers=root["consumers"].toArray();
+    for(int k=0;k<int(consumers.size());++k){
+        const int i=scenarioTankIndex(consumers[k],tanks);
+        if(i<0){
+            if(error) *error=QString("consumidor %1 invalido").arg(k);
+            return false;
+        }
+        scenario.consumers.push_back(i);
+    }
+
+    scenario.events.clear();
+    const QJsonArray events=root["events"].toArray();
+    for(int k=0;k<int(events.size());++k){
+        const QJsonObject e=events[k].toObject();
+        const QString name=e["do"].toString();
+        const ScenarioCommandName* command=nullptr;
+        for(const ScenarioCommandName& c:scenarioCommands) if(name==QLatin1String(c.name)) command=&c;
+        if(!command){
+            if(error) *error=QString("evento %1: comando desconocido \"%2\"").arg(k).arg(name);
+            return false;
+        }
+        ScenarioEvent ev;
+        ev.timeS=qMax(0.0,e["t"].toDouble());
+        ev.command.type=command->type;
+        const QJsonValue value=e["value"];
+        ev.command.value=value.isBool()?(value.toBool()?1.0:0.0):value.toDouble();
+        if(command->perTank){
+            ev.command.tank=scenarioTankIndex(e["tank"],tanks);
+            if(ev.command.tank<0){
+                if(error) *error=QString("evento %1: tanque invalido").arg(k);
+                return false;
+            }
+        }
+        scenario.events.push_back(ev);
+    }
+    std::stable_sort(scenario.events.begin(),scenario.events.end(),
+                     [](const ScenarioEvent& a,const ScenarioEvent& b){ return a.timeS<b.timeS; });
+    return true;
+}
+
+static int graphTankIndex(const QJsonValue& v,const QHash<QString,int>& names,int n){
+    if(v.isString()) return names.value(v.toString(),-1);
+    const int i=v.toInt(-1);
+    return (i>=0&&i<n)?i:-1;
+}
+
+bool tankGraphFromJson(const QJsonObject& root,TankGraph& graph,QString* error){
+    const QJsonArray tanks=root["tanks"].toArray();
+    const QJsonArray pipes=root["pipes"].toArray();
+    if(tanks.isEmpty()){
+        if(error) *error="el grafo no tiene tanques";
+        return false;
+    }
+
+    QHash<QString,int> names;
+    for(int k=0;k<int(tanks.size());++k){
+        const QJsonObject t=tanks[k].toObject();
+        const int i=graph.addTank(t["capacityL"].toDouble(100.0));
+        TankNetwork& net=graph.network();
+        if(t.contains("levelL")) net.setLevelL(i,qBound(0.0,t["levelL"].toDouble(),net.capacityL(i)));
+        if(t.contains("inputMaxLph")) net.setInputMaxLph(i,t["inputMaxLph"].toDouble());
+        if(t.contains("outputMaxLph")) net.setOutputMaxLph(i,t["outputMaxLph"].toDouble());
+        if(t.contains("inputEnabled")) net.setInputEnabled(i,t["inputEnabled"].toBool());
+        graph.setSupplyLph(i,t["supplyLph"].toDouble());
+        graph.setDemandLph(i,t["demandLph"].toDouble());
+        if(t.contains("name")) names.insert(t["name"].toString(),i);
+    }
+
+    for(int k=0;k<int(pipes.size());++k){
+        const QJsonObject o=pipes[k].toObject();
+        const int from=graphTankIndex(o["from"],names,graph.tankCount());
+        const int to=graphTankIndex(o["to"],names,graph.tankCount());
+        const int p=graph.addPipe(from,to,o["maxLph"].toDouble(100.0));
+        if(p<0){
+            if(error) *error=QString("caño %1 invalido").arg(k);
+            return false;
+        }
+        if(o.contains("open")) graph.setPipeOpen(p,o["open"].toBool());
+    }
+
+    if(!graph.build()){
+        if(error) *error="el grafo tiene un ciclo";
+        return false;
+    }
+    return true;
+}
+
+QJsonObject tankGraphToJson(const TankGraph& graph){
+    const TankNetwork& net=graph.network();
+    QJsonArray tanks;
+    for(int i=0;i<graph.tankCount();++i){
+        QJsonObject t;
+        t["capacityL"]=net.capacityL(i);
+        t["levelL"]=net.levelL(i);
+        t["inputMaxLph"]=net.inputMaxLph(i);
+        t["outputMaxLph"]=net.outputMaxLph(i);
+        t["inputEnabled"]=net.isInputEnabled(i);
+        t["supplyLph"]=graph.supplyLph(i);
+        t["demandLph"]=graph.demandLph(i);
+        tanks.append(t);
+    }
+    QJsonArray pipes;
+    for(int p=0;p<graph.pipeCount();++p){
+        QJsonObject o;
+        o["from"]=graph.pipeFrom(p);
+        o["to"]=graph.pipeTo(p);
+        o["maxLph"]=graph.pipeMaxLph(p);
+        o["open"]=graph.isPipeOpen(p);
+        o["flowLph"]=graph.pipeFlowLph(p);
+        pipes.append(o);
+    }
+    QJsonObject root;
+    root["tanks"]=tanks;
+    root["pipes"]=pipes;
+    return root;
+}
@@ -0,0 +1,57 @@
+#ifndef SIMJSON_H
+#define SIMJSON_H
+
+#include <QJsonObject>
+
+#include <QString>
+
+#include "scenario.h"
+#include "simengine.h"
+#include "sweep.h"
+#include "tankgraph.h"
+
+// Estado en JSON con el mismo formato que sim_state.json de la GUI
+// ("principal", "aux1", "aux2"); los tanques extra van en el arreglo "extra".
+// Un tanque que descarga por gravedad lleva "outflow":"gravity" (por defecto
+// "constant", que no se escribe).
+
+QJsonObject tankToJson(const SimEngine& engine,int i);
+void tankFromJson(SimEngine& engine,int i,const QJsonObject& obj);
+
+QJsonObject stateToJson(const SimEngine& engine);
+bool stateFromJson(SimEngine& engine,const QJsonObject& root);
+
+// Especificacion de un barrido. Cada parametro por tanque ("principal", "aux1",
+// "aux2") es un numero fijo o {"grid":[desde,hasta,pasos]}, {"uniform":[desde,hasta]}
+// o {"normal":[media,desvio]}:
+//   {"replicates":100,"seed":1,"durationS":259200,"tickS":5,
+//    "capacityL":{"principal":{"grid":[500,2000,4]},"aux1":200,"aux2":200},
+//    "inputMaxLph":{...},"outputMaxLph":{...},
+//    "mainInputDial":100,"transferDial":100,"refillBelowFrac":0.9,"initialLevelFrac":0.5,
+//    "demand":{"dial":[20,20,...],"stepS":3600,"noise":5}}
+bool sweepSpecFromJson(const QJsonObject& root,SweepSpec& spec,QString* error=nullptr);
+QJsonObject sweepSummaryToJson(const SweepSummary& summary);
+
+// Escenario de aguacli. Los tanques van por nombre ("principal", "aux1", "aux2")
+// o por indice; "value" de las casillas es true/false. "mode" es "ticked"
+// (por defecto), "analytic" o "adaptive":
+//   {"tickS":0.2,"durationS":86400,"sampleS":60,"mode":"ticked",
+//    "state":{...como sim_state.json...},"consumers":[1,2],
+//    "events":[{"t":0,"do":"mainInputDial","value":100},
+//              {"t":600,"do":"auxInput","tank":"aux1","value":false},
+//              {"t":3600,"do":"capacityL","tank":"principal","value":1500},...]}
+// Comandos: mainInputDial, mainOutputDial, distribution, auxOutputDial, auxInput,
+// reapplyAuxDials, capacityL, levelL, inputMaxLph, outputMaxLph, inputEnabled,
+// inputFlowLph, outputFlowLph, y updateCapacityL, updateInputMaxLph y
+// updateOutputMaxLph, que ademas recalculan lo que depende del tanque (como la GUI).
+bool scenarioFromJson(const QJsonObject& root,Scenario& scenario,QString* error=nullptr);
+
+// Sitio como grafo. Los caños se refieren a los tanques por indice o por "name":
+//   {"tanks":[{"name":"cisterna","capacityL":20000,"levelL":10000,"inputMaxLph":3000,
+//              "outputMaxLph":3000,"supplyLph":2000,"demandLph":0},...],
+//    "pipes":[{"from":"cisterna","to":"torre","maxLph":1500,"open":true},...]}
+// tankGraphToJson escribe indices y agrega el caudal del ultimo tick ("flowLph").
+bool tankGraphFromJson(const QJsonObject& root,TankGraph& graph,QString* error=nullptr);
+QJsonObject tankGraphToJson(const TankGraph& graph);
+
+#endif // SIMJSON_H
@@ -0,0 +1,34 @@
+#include "simsnapshot.h"
+
+void SimSnapshot::capture(const SimEngine& e){
+    const TankNetwork& net=e.network();
+    const int n=net.size();
+
+    timeS=e.timeS();
+    tickS=e.tickS();
+    tick=e.tickCount();
+    mainInputDial=e.mainInputDial();
+    mainOutputDial=e.mainOutputDial();
+    mainInputRequestedLph=e.mainInputRequestedLph();
+    mainOutputRequestedLph=e.mapDialToLph(mainOutputDial);
+
+    auxOutputDial.resize(n);
+    capacityL.assign(net.capacities(),net.capacities()+n);
+    levelL.assign(net.levels(),net.levels()+n);
+    inputFlowLph.assign(net.inputFlows(),net.inputFlows()+n);
+    outputFlowLph.assign(net.outputFlows(),net.outputFlows()+n);
+    inputMaxLph.resize(n);
+    outputMaxLph.resize(n);
+    inputEnabled.resize(n);
+    canWithdraw.resize(n);
+    for(int i=0;i<n;++i){
+        auxOutputDial[i]=(i==SimEngine::Principal)?0:e.auxOutputDial(i);
+        inputMaxLph[i]=net.inputMaxLph(i);
+        outputMaxLph[i]=net.outputMaxLph(i);
+        inputEnabled[i]=net.isInputEnabled(i);
+        canWithdraw[i]=net.canWithdraw(i);
+    }
+    fullCount.resize(n,0u);
+    emptyCount.resize(n,0u);
+    canWithdrawCount.resize(n,0u);
+}
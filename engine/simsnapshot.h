@@ -0,0 +1,51 @@
+#ifndef SIMSNAPSHOT_H
+#define SIMSNAPSHOT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "simengine.h"
+
+// Foto consistente de todo el estado visible del motor. La escribe el hilo de
+// simulacion y la lee la GUI a traves de un TripleBuffer.
+// Los eventos van como contadores acumulados: si la GUI se saltea una foto no
+// pierde el aviso, solo compara contra el ultimo valor que vio.
+
+struct SimSnapshot {
+    double timeS=0.0;
+    double tickS=0.2;
+    unsigned long long tick=0;
+    unsigned long long commandSeq=0;
+
+    int mainInputDial=0;
+    int mainOutputDial=0;
+    double mainInputRequestedLph=0.0;
+    double mainOutputRequestedLph=0.0;
+    std::vector<int> auxOutputDial;
+
+    std::vector<double> capacityL;
+    std::vector<double> levelL;
+    std::vector<double> inputFlowLph;
+    std::vector<double> outputFlowLph;
+    std::vector<double> inputMaxLph;
+    std::vector<double> outputMaxLph;
+    std::vector<std::uint8_t> inputEnabled;
+    std::vector<std::uint8_t> canWithdraw;
+
+    std::vector<std::uint32_t> fullCount;
+    std::vector<std::uint32_t> emptyCount;
+    std::vector<std::uint32_t> canWithdrawCount;
+
+    // pronostico con los diales de esta foto (ver Forecast): instante en que
+    // cada tanque se llena / baja al 10%, infinito si no pasa en el horizonte
+    double forecastHorizonS=0.0;
+    std::vector<double> forecastFullAtS;
+    std::vector<double> forecastMinAtS;
+
+    int tankCount()const{return int(levelL.size());}
+
+    // copia el estado del motor; reutiliza la memoria de la foto anterior
+    void capture(const SimEngine& e);
+};
+
+#endif // SIMSNAPSHOT_H
@@ -0,0 +1,151 @@
+#include "simworker.h"
+
+#include "metrics.h"
+
+SimWorker::SimWorker(QObject* parent)
+    : QObject(parent),
+    m_thread(nullptr),
+    m_scheduler(nullptr),
+    m_tickIntervalMs(200),
+    m_journal(nullptr),
+    m_recorder(nullptr),
+    m_inputLog(nullptr),
+    m_wakePending(false),
+    m_postedSeq(0),
+    m_appliedSeq(0)
+{
+}
+
+SimWorker::~SimWorker(){
+    stop();
+}
+
+SimEngine& SimWorker::engine(){return m_engine;}
+void SimWorker::setJournal(Journal* journal){ if(!m_thread) m_journal=journal; }
+void SimWorker::setRecorder(Recorder* recorder){ if(!m_thread) m_recorder=recorder; }
+void SimWorker::setInputLog(InputLog* log){ if(!m_thread) m_inputLog=log; }
+void SimWorker::setForecastHorizonS(double s){ if(!m_thread) m_forecast.setHorizonS(s); }
+
+void SimWorker::start(int tickIntervalMs){
+    if(m_thread) return;
+    m_tickIntervalMs=qMax(1,tickIntervalMs);
+
+    // lo que se mando antes de arrancar se aplica aca, todavia en un solo hilo
+    drainCommands();
+    // el scheduler va a fijar el paso al intervalo: las fotos iniciales ya lo llevan
+    m_engine.setTickS(m_tickIntervalMs/1000.0);
+    if(m_journal) m_journal->start(m_engine);
+    if(m_inputLog) m_inputLog->start(m_engine);
+    if(m_recorder&&m_recorder->start(m_engine.tankCount())) m_engine.setTickObserver(m_recorder);
+    publish();
+    m_snapshots.fetch();
+
+    m_thread=new QThread;
+    m_thread->setObjectName("SimWorker");
+    moveToThread(m_thread);
+    connect(m_thread,&QThread::started,this,&SimWorker::onThreadStarted);
+    m_thread->start();
+}
+
+void SimWorker::stop(){
+    if(!m_thread) return;
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread=nullptr;
+    // el hilo de simulacion ya termino: la ultima foto se puede sacar desde aca
+    if(m_journal) m_journal->stop(m_engine);
+    if(m_inputLog) m_inputLog->stop(m_engine);
+    m_engine.setTickObserver(nullptr);
+    if(m_recorder) m_recorder->stop();
+}
+
+// corre en el hilo de simulacion: el QTimer del scheduler tiene que nacer aca
+void SimWorker::onThreadStarted(){
+    m_scheduler=new TickScheduler(&m_engine,this);
+    m_scheduler->setTickIntervalMs(m_tickIntervalMs);
+    connect(m_scheduler,&TickScheduler::aboutToStep,this,&SimWorker::drainCommands);
+    connect(m_scheduler,&TickScheduler::networkStepped,this,&SimWorker::onStepped);
+    connect(m_thread,&QThread::finished,m_scheduler,&TickScheduler::stop,Qt::DirectConnection);
+    m_scheduler->start();
+}
+
+// La cola solo se llena si el hilo de simulacion esta trabado (la vacia antes de
+// cada paso y apenas llega un comando): ahi la GUI no se queda esperando.
+unsigned long long SimWorker::post(const SimCommand& c){
+    if(!m_thread){
+        // nadie mas toca el motor; el diario y el InputLog todavia no arrancaron
+        AGUA_METRIC_COUNT(CommandsApplied);
+        applySimCommand(m_engine,c);
+        ++m_appliedSeq;
+        return ++m_postedSeq;
+    }
+    if(!m_commands.push(c)){
+        AGUA_METRIC_COUNT(CommandsDropped);
+        return 0;
+    }
+    ++m_postedSeq;
+    // un solo despertador pendiente a la vez para no llenar la cola de eventos de Qt
+    if(m_thread&&!m_wakePending.exchange(true,std::memory_order_acq_rel))
+        QMetaObject::invokeMethod(this,&SimWorker::drainCommands,Qt::QueuedConnection);
+    return m_postedSeq;
+}
+
+unsigned long long SimWorker::postedSeq()const{return m_postedSeq;}
+
+bool SimWorker::fetchSnapshot(){return m_snapshots.fetch();}
+const SimSnapshot& SimWorker::snapshot()const{return m_snapshots.readBuffer();}
+
+void SimWorker::drainCommands(){
+    m_wakePending.store(false,std::memory_order_release);
+    AGUA_METRIC_GAUGE(CommandQueueDepth,m_commands.size());
+    SimCommand c;
+    bool any=false;
+    while(m_commands.pop(c)){
+        AGUA_METRIC_COUNT(CommandsApplied);
+        applySimCommand(m_engine,c);
+        if(m_journal) m_journal->record(m_engine,c);
+        if(m_inputLog) m_inputLog->record(m_engine,c);
+        ++m_appliedSeq;
+        any=true;
+    }
+    if(!any) return;
+    m_forecast.invalidate();
+    publish();
+}
+
+void SimWorker::onStepped(){
+    if(m_journal) m_journal->stepped(m_engine);
+    publish();
+}
+
+void SimWorker::countEvents(){
+    const int n=m_engine.tankCount();
+    m_fullCount.resize(n,0u);
+    m_emptyCount.resize(n,0u);
+    m_canWithdrawCount.resize(n,0u);
+    for(int i=0;i<n;++i){
+        unsigned ev=m_engine.takeEvents(i);
+        if(!ev) continue;
+        if(ev&SimEngine::EventFull){ ++m_fullCount[i]; AGUA_METRIC_COUNT(EventsFull); }
+        if(ev&SimEngine::EventEmpty){ ++m_emptyCount[i]; AGUA_METRIC_COUNT(EventsEmpty); }
+        if(ev&SimEngine::EventCanWithdrawChanged){ ++m_canWithdrawCount[i]; AGUA_METRIC_COUNT(EventsCanWithdraw); }
+    }
+}
+
+void SimWorker::publish(){
+    AGUA_METRIC_SCOPE(PublishNs);
+    AGUA_METRIC_COUNT(SnapshotsPublished);
+    countEvents();
+    SimSnapshot& s=m_snapshots.writeBuffer();
+    s.capture(m_engine);
+    s.commandSeq=m_appliedSeq;
+    s.fullCount=m_fullCount;
+    s.emptyCount=m_emptyCount;
+    s.canWithdrawCount=m_canWithdrawCount;
+    m_forecast.update(m_engine);
+    s.forecastHorizonS=m_forecast.horizonS();
+    s.forecastFullAtS=m_forecast.fullAt();
+    s.forecastMinAtS=m_forecast.minAt();
+    m_snapshots.publish();
+}
@@ -0,0 +1,84 @@
+#ifndef SIMWORKER_H
+#define SIMWORKER_H
+
+#include <QObject>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+#include "forecast.h"
+#include "inputlog.h"
+#include "journal.h"
+#include "recorder.h"
+#include "simengine.h"
+#include "simcommand.h"
+#include "simsnapshot.h"
+#include "spscqueue.h"
+#include "triplebuffer.h"
+#include "tickscheduler.h"
+
+// Corre el SimEngine en su propio hilo. La GUI le manda comandos por una cola
+// lock-free (post) y lee fotos del estado por un triple buffer (fetchSnapshot /
+// snapshot). Ningun lado bloquea al otro.
+//
+// engine() solo se puede tocar antes de start(); despues todo pasa por post().
+// Con un Journal cada comando aplicado queda anotado para poder recuperarlo, con
+// un InputLog se graba la sesion para reproducirla y con un Recorder se graba la
+// serie de tiempo de cada tick. Cada foto lleva el pronostico de la red, que se
+// recalcula cuando se aplica un comando (ver Forecast).
+// No debe tener padre (se mueve al hilo de simulacion).
+
+class SimWorker:public QObject {
+    Q_OBJECT
+public:
+    explicit SimWorker(QObject* parent=nullptr);
+    ~SimWorker()override;
+
+    SimEngine& engine();
+    // opcional, antes de start(); el diario no pasa a ser del worker
+    void setJournal(Journal* journal);
+    void setRecorder(Recorder* recorder);
+    void setInputLog(InputLog* log);
+    void setForecastHorizonS(double s);
+
+    void start(int tickIntervalMs=200);
+    void stop();
+
+    // hilo de la GUI. Antes de start() (o despues de stop()) el comando se aplica
+    // en el acto. Andando nunca espera: si la cola (1024 comandos) esta llena
+    // devuelve 0 y el comando no se aplica; si no, su numero de secuencia.
+    unsigned long long post(const SimCommand& c);
+    unsigned long long postedSeq()const;
+    bool fetchSnapshot();
+    const SimSnapshot& snapshot()const;
+
+private slots:
+    void onThreadStarted();
+    void drainCommands();
+    void onStepped();
+
+private:
+    void countEvents();
+    void publish();
+
+    SimEngine m_engine;
+    QThread* m_thread;
+    TickScheduler* m_scheduler;
+    int m_tickIntervalMs;
+    Journal* m_journal;
+    Recorder* m_recorder;
+    InputLog* m_inputLog;
+    Forecast m_forecast;
+
+    SpscQueue<SimCommand,1024> m_commands;
+    TripleBuffer<SimSnapshot> m_snapshots;
+    std::atomic<bool> m_wakePending;
+    unsigned long long m_postedSeq;
+    unsigned long long m_appliedSeq;
+
+    std::vector<std::uint32_t> m_fullCount;
+    std::vector<std::uint32_t> m_emptyCount;
+    std::vector<std::uint32_t> m_canWithdrawCount;
+};
+
+#endif // SIMWORKER_H
@@ -0,0 +1,221 @@
+#include "snapshotfile.h"
+
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+
+static_assert(sizeof(int)==4,"la columna de diales se guarda como i32");
+
+namespace {
+
+const char Magic[8]={'A','G','U','A','S','N','A','P'};
+const quint32 HeaderFixedBytes=64;
+const quint32 HeaderBytes=HeaderFixedBytes+8*SnapshotFile::ColumnCount;
+
+const quint32 ColumnWidth[SnapshotFile::ColumnCount]={8,8,8,8,8,8,4,1,1};
+
+quint64 align8(quint64 v){return (v+7u)&~quint64(7u);}
+
+template<class T>
+void putLE(uchar* dst,T v){ qToLittleEndian<T>(v,dst); }
+
+template<class T>
+T getLE(const uchar* src){ return qFromLittleEndian<T>(src); }
+
+// en little-endian es una copia directa; si no, se convierte por partes
+template<class T>
+bool writeColumn(QSaveFile& out,const T* data,int n){
+#if Q_BYTE_ORDER==Q_LITTLE_ENDIAN
+    const qint64 bytes=qint64(n)*qint64(sizeof(T));
+    return out.write(reinterpret_cast<const char*>(data),bytes)==bytes;
+#else
+    T chunk[1024];
+    for(int k=0;k<n;k+=1024){
+        const int m=qMin(1024,n-k);
+        qToLittleEndian<T>(data+k,m,chunk);
+        const qint64 bytes=qint64(m)*qint64(sizeof(T));
+        if(out.write(reinterpret_cast<const char*>(chunk),bytes)!=bytes) return false;
+    }
+    return true;
+#endif
+}
+
+bool pad(QSaveFile& out,qint64 upTo){
+    static const char zeros[8]={0};
+    const qint64 n=upTo-out.pos();
+    return n<=0||out.write(zeros,n)==n;
+}
+
+}
+
+bool writeSnapshotFile(const SimSnapshot& snap,const QString& path,QString* error){
+    const int n=snap.tankCount();
+
+    quint64 offset[SnapshotFile::ColumnCount];
+    quint64 end=align8(HeaderBytes);
+    for(int c=0;c<SnapshotFile::ColumnCount;++c){
+        offset[c]=end;
+        end=align8(end+quint64(n)*ColumnWidth[c]);
+    }
+
+    uchar header[HeaderBytes];
+    std::memset(header,0,sizeof(header));
+    std::memcpy(header,Magic,sizeof(Magic));
+    putLE<quint32>(header+8,SnapshotFile::Version);
+    putLE<quint32>(header+12,HeaderBytes);
+    putLE<quint32>(header+16,quint32(n));
+    putLE<quint32>(header+20,quint32(SnapshotFile::ColumnCount));
+    putLE<double>(header+24,snap.timeS);
+    putLE<double>(header+32,snap.tickS);
+    putLE<quint64>(header+40,snap.tick);
+    putLE<qint32>(header+48,snap.mainInputDial);
+    putLE<qint32>(header+52,snap.mainOutputDial);
+    putLE<quint64>(header+56,end);
+    for(int c=0;c<SnapshotFile::ColumnCount;++c) putLE<quint64>(header+HeaderFixedBytes+8*c,offset[c]);
+
+    // QSaveFile escribe en un temporal y renombra: un corte a mitad no deja una foto rota
+    QSaveFile out(path);
+    bool ok=out.open(QIODevice::WriteOnly)
+        &&out.write(reinterpret_cast<const char*>(header),HeaderBytes)==HeaderBytes
+        &&pad(out,qint64(offset[SnapshotFile::CapacityL]))&&writeColumn(out,snap.capacityL.data(),n)
+        &&pad(out,qint64(offset[SnapshotFile::LevelL]))&&writeColumn(out,snap.levelL.data(),n)
+        &&pad(out,qint64(offset[SnapshotFile::InputFlowLph]))&&writeColumn(out,snap.inputFlowLph.data(),n)
+        &&pad(out,qint64(offset[SnapshotFile::OutputFlowLph]))&&writeColumn(out,snap.outputFlowLph.data(),n)
+        &&pad(out,qint64(offset[SnapshotFile::InputMaxLph]))&&writeColumn(out,snap.inputMaxLph.data(),n)
+        &&pad(out,qint64(offset[SnapshotFile::OutputMaxLph]))&&writeColumn(out,snap.outputMaxLph.data(),n)
+        &&pad(out,qint64(offset[SnapshotFile::AuxOutputDial]))&&writeColumn(out,snap.auxOutputDial.data(),n)
+        &&pad(out,qint64(offset[SnapshotFile::InputEnabled]))&&writeColumn(out,snap.inputEnabled.data(),n)
+        &&pad(out,qint64(offset[SnapshotFile::CanWithdraw]))&&writeColumn(out,snap.canWithdraw.data(),n)
+        &&pad(out,qint64(end))
+        &&out.commit();
+    if(!ok&&error) *error=out.errorString();
+    return ok;
+}
+
+bool writeSnapshotFile(const SimEngine& engine,const QString& path,QString* error){
+    SimSnapshot snap;
+    snap.capture(engine);
+    return writeSnapshotFile(snap,path,error);
+}
+
+SnapshotFile::SnapshotFile()
+    : m_data(nullptr),
+    m_size(0),
+    m_tankCount(0),
+    m_timeS(0.0),
+    m_tickS(0.2),
+    m_ticks(0),
+    m_inDial(0),
+    m_outDial(0)
+{
+    std::memset(m_offset,0,sizeof(m_offset));
+}
+
+SnapshotFile::~SnapshotFile(){
+    close();
+}
+
+bool SnapshotFile::fail(const QString& message){
+    close();
+    m_error=message;
+    return false;
+}
+
+bool SnapshotFile::open(const QString& path){
+    close();
+    m_error.clear();
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::ReadOnly)) return fail(m_file.errorString());
+    m_size=m_file.size();
+    if(m_size<qint64(HeaderFixedBytes)) return fail("archivo demasiado corto");
+    m_data=m_file.map(0,m_size);
+    if(!m_data) return fail(m_file.errorString());
+
+    if(std::memcmp(m_data,Magic,sizeof(Magic))!=0) return fail("no es una foto de Agua");
+    const quint32 version=getLE<quint32>(m_data+8);
+    if(version!=Version) return fail(QString("version %1 no soportada").arg(int(version)));
+    const quint32 headerBytes=getLE<quint32>(m_data+12);
+    const quint32 n=getLE<quint32>(m_data+16);
+    const quint32 columns=getLE<quint32>(m_data+20);
+    if(columns<quint32(ColumnCount)||headerBytes<HeaderFixedBytes+8u*columns||qint64(headerBytes)>m_size)
+        return fail("encabezado invalido");
+    if(n>quint32(0x7fffffff)||getLE<quint64>(m_data+56)!=quint64(m_size))
+        return fail("tamano de archivo inconsistente");
+    if(n<quint32(SimEngine::Auxiliar2+1)) return fail("faltan los tanques de la planta");
+
+    for(int c=0;c<ColumnCount;++c){
+        const quint64 off=getLE<quint64>(m_data+HeaderFixedBytes+8*c);
+        if(off%8u!=0||off<headerBytes||off+quint64(n)*ColumnWidth[c]>quint64(m_size))
+            return fail("columna fuera del archivo");
+        m_offset[c]=off;
+    }
+
+    m_tankCount=int(n);
+    m_timeS=getLE<double>(m_data+24);
+    m_tickS=getLE<double>(m_data+32);
+    m_ticks=getLE<quint64>(m_data+40);
+    m_inDial=getLE<qint32>(m_data+48);
+    m_outDial=getLE<qint32>(m_data+52);
+    return true;
+}
+
+void SnapshotFile::close(){
+    if(m_data) m_file.unmap(const_cast<uchar*>(m_data));
+    m_data=nullptr;
+    m_size=0;
+    m_tankCount=0;
+    if(m_file.isOpen()) m_file.close();
+}
+
+bool SnapshotFile::isOpen()const{return m_data!=nullptr;}
+QString SnapshotFile::errorString()const{return m_error;}
+
+int SnapshotFile::tankCount()const{return m_tankCount;}
+double SnapshotFile::timeS()const{return m_timeS;}
+double SnapshotFile::tickS()const{return m_tickS;}
+unsigned long long SnapshotFile::ticks()const{return m_ticks;}
+int SnapshotFile::mainInputDial()const{return m_inDial;}
+int SnapshotFile::mainOutputDial()const{return m_outDial;}
+
+const uchar* SnapshotFile::column(Column c)const{return m_data+m_offset[c];}
+double SnapshotFile::f64(Column c,int i)const{return getLE<double>(column(c)+8*i);}
+
+double SnapshotFile::capacityL(int i)const{return f64(CapacityL,i);}
+double SnapshotFile::levelL(int i)const{return f64(LevelL,i);}
+double SnapshotFile::inputFlowLph(int i)const{return f64(InputFlowLph,i);}
+double SnapshotFile::outputFlowLph(int i)const{return f64(OutputFlowLph,i);}
+double SnapshotFile::inputMaxLph(int i)const{return f64(InputMaxLph,i);}
+double SnapshotFile::outputMaxLph(int i)const{return f64(OutputMaxLph,i);}
+int SnapshotFile::auxOutputDial(int i)const{return getLE<qint32>(column(AuxOutputDial)+4*i);}
+bool SnapshotFile::isInputEnabled(int i)const{return column(InputEnabled)[i]!=0;}
+bool SnapshotFile::canWithdraw(int i)const{return column(CanWithdraw)[i]!=0;}
+
+// en little-endian las columnas del mapeo van directo al assign de la red (un memcpy
+// por columna); en big-endian se pasan primero por una copia convertida
+void SnapshotFile::restore(SimEngine& engine)const{
+    if(!isOpen()) return;
+    const int n=m_tankCount;
+
+#if Q_BYTE_ORDER==Q_LITTLE_ENDIAN
+    auto f64col=[&](Column c){return reinterpret_cast<const double*>(column(c));};
+    const int* dials=reinterpret_cast<const int*>(column(AuxOutputDial));
+#else
+    std::vector<double> tmp[6];
+    auto f64col=[&](Column c){
+        std::vector<double>& t=tmp[c];
+        t.resize(n);
+        qFromLittleEndian<double>(column(c),n,t.data());
+        return static_cast<const double*>(t.data());
+    };
+    std::vector<int> dialTmp(n);
+    qFromLittleEndian<qint32>(column(AuxOutputDial),n,dialTmp.data());
+    const int* dials=dialTmp.data();
+#endif
+
+    engine.network().restore(n,f64col(CapacityL),f64col(LevelL),
+                             f64col(InputFlowLph),f64col(OutputFlowLph),
+                             f64col(InputMaxLph),f64col(OutputMaxLph),
+                             column(InputEnabled),column(CanWithdraw));
+    engine.setTickS(m_tickS);
+    engine.restore(m_timeS,m_ticks,m_inDial,m_outDial,dials);
+}
@@ -0,0 +1,108 @@
+#ifndef SNAPSHOTFILE_H
+#define SNAPSHOTFILE_H
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+#include "simengine.h"
+#include "simsnapshot.h"
+
+// Foto binaria del motor ("AGUASNAP"). Todo en little-endian y cada columna
+// alineada a 8 bytes, asi el archivo se mapea con mmap y las columnas se usan
+// en el lugar sin parsear. JSON (simjson.h) queda para intercambio.
+//
+// Disposicion (version 1):
+//   0    char[8]  "AGUASNAP"
+//   8    u32      version
+//   12   u32      bytes del encabezado
+//   16   u32      cantidad de tanques (n)
+//   20   u32      cantidad de columnas
+//   24   f64      timeS
+//   32   f64      tickS
+//   40   u64      ticks
+//   48   i32      dial de entrada de la principal
+//   52   i32      dial de salida de la principal
+//   56   u64      bytes del archivo
+//   64   u64[]    offset de cada columna desde el comienzo del archivo
+// Columnas: capacidad, nivel, flujo de entrada, flujo de salida, maximos de
+// entrada y salida (f64[n]), dial de salida de cada tanque (i32[n]), entrada
+// habilitada y "se puede extraer" (u8[n]).
+// Las columnas nuevas se agregan al final de la tabla sin cambiar la version
+// (los lectores viejos las ignoran); version sube solo si cambia algo existente.
+
+bool writeSnapshotFile(const SimSnapshot& snap,const QString& path,QString* error=nullptr);
+bool writeSnapshotFile(const SimEngine& engine,const QString& path,QString* error=nullptr);
+
+class SnapshotFile {
+public:
+    enum Column {
+        CapacityL,
+        LevelL,
+        InputFlowLph,
+        OutputFlowLph,
+        InputMaxLph,
+        OutputMaxLph,
+        AuxOutputDial,
+        InputEnabled,
+        CanWithdraw,
+        ColumnCount
+    };
+
+    static constexpr std::uint32_t Version=1;
+
+    SnapshotFile();
+    ~SnapshotFile();
+    SnapshotFile(const SnapshotFile&)=delete;
+    SnapshotFile& operator=(const SnapshotFile&)=delete;
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen()const;
+    QString errorString()const;
+
+    int tankCount()const;
+    double timeS()const;
+    double tickS()const;
+    unsigned long long ticks()const;
+    int mainInputDial()const;
+    int mainOutputDial()const;
+
+    // valores sueltos; funcionan en cualquier CPU
+    double capacityL(int i)const;
+    double levelL(int i)const;
+    double inputFlowLph(int i)const;
+    double outputFlowLph(int i)const;
+    double inputMaxLph(int i)const;
+    double outputMaxLph(int i)const;
+    int auxOutputDial(int i)const;
+    bool isInputEnabled(int i)const;
+    bool canWithdraw(int i)const;
+
+    // columna cruda dentro del mapeo (little-endian): en CPUs little-endian se
+    // puede leer directo como arreglo del tipo de la columna
+    const uchar* column(Column c)const;
+
+    // carga la foto en el motor (copia de columnas, sin logica de diales)
+    void restore(SimEngine& engine)const;
+
+private:
+    QFile m_file;
+    const uchar* m_data;
+    qint64 m_size;
+    QString m_error;
+
+    int m_tankCount;
+    double m_timeS;
+    double m_tickS;
+    unsigned long long m_ticks;
+    int m_inDial;
+    int m_outDial;
+    quint64 m_offset[ColumnCount];
+
+    bool fail(const QString& message);
+    double f64(Column c,int i)const;
+};
+
+#endif // SNAPSHOTFILE_H
@@ -0,0 +1,47 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Cola lock-free de un productor y un consumidor con capacidad fija (potencia
+// de 2). Un solo hilo hace push() y un solo hilo hace pop().
+
+template<class T,std::size_t N>
+class SpscQueue {
+    static_assert(N>=2&&(N&(N-1))==0,"SpscQueue: N tiene que ser potencia de 2");
+public:
+    bool push(const T& v){
+        const std::size_t head=m_head.load(std::memory_order_relaxed);
+        const std::size_t next=(head+1)&(N-1);
+        if(next==m_tail.load(std::memory_order_acquire)) return false;
+        m_items[head]=v;
+        m_head.store(next,std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out){
+        const std::size_t tail=m_tail.load(std::memory_order_relaxed);
+        if(tail==m_head.load(std::memory_order_acquire)) return false;
+        out=m_items[tail];
+        m_tail.store((tail+1)&(N-1),std::memory_order_release);
+        return true;
+    }
+
+    bool empty()const{
+        return m_tail.load(std::memory_order_acquire)==m_head.load(std::memory_order_acquire);
+    }
+
+    std::size_t size()const{
+        return (m_head.load(std::memory_order_acquire)-m_tail.load(std::memory_order_acquire))&(N-1);
+    }
+
+    static constexpr std::size_t capacity(){return N-1;}
+
+private:
+    T m_items[N];
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+#endif // SPSCQUEUE_H
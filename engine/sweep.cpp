@@ -0,0 +1,223 @@
+#include "sweep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include "threadpool.h"
+
+ParamSpec ParamSpec::fixed(double v){ ParamSpec p; p.kind=Fixed; p.a=v; p.b=v; return p; }
+ParamSpec ParamSpec::grid(double from,double to,int steps){ ParamSpec p; p.kind=Grid; p.a=from; p.b=to; p.steps=std::max(1,steps); return p; }
+ParamSpec ParamSpec::uniform(double from,double to){ ParamSpec p; p.kind=Uniform; p.a=from; p.b=to; return p; }
+ParamSpec ParamSpec::normal(double mean,double stddev){ ParamSpec p; p.kind=Normal; p.a=mean; p.b=stddev; return p; }
+
+namespace {
+
+// semilla propia de cada corrida (splitmix64): no depende del orden de ejecucion
+unsigned runSeed(unsigned base,int index){
+    std::uint64_t z=(std::uint64_t(base)<<32)+std::uint64_t(index)+0x9e3779b97f4a7c15ull;
+    z=(z^(z>>30))*0xbf58476d1ce4e5b9ull;
+    z=(z^(z>>27))*0x94d049bb133111ebull;
+    return unsigned(z^(z>>31));
+}
+
+// los 9 parametros en orden fijo
+void sweepParams(const SweepSpec& spec,const ParamSpec* params[9]){
+    for(int t=0;t<3;++t){
+        params[t]=&spec.capacityL[t];
+        params[3+t]=&spec.inputMaxLph[t];
+        params[6+t]=&spec.outputMaxLph[t];
+    }
+}
+
+double gridValue(const ParamSpec& p,int k){
+    if(p.steps<=1) return p.a;
+    return p.a+(p.b-p.a)*double(k)/double(p.steps-1);
+}
+
+double sample(const ParamSpec& p,std::mt19937_64& rng){
+    switch(p.kind){
+    case ParamSpec::Uniform: return std::uniform_real_distribution<double>(p.a,p.b)(rng);
+    case ParamSpec::Normal: return std::normal_distribution<double>(p.a,p.b)(rng);
+    default: return p.a;
+    }
+}
+
+SweepStat stat(std::vector<double> v){
+    SweepStat s;
+    if(v.empty()) return s;
+    std::sort(v.begin(),v.end());
+    const double n=double(v.size());
+    double sum=0.0;
+    for(double x:v) sum+=x;
+    s.mean=sum/n;
+    double var=0.0;
+    for(double x:v) var+=(x-s.mean)*(x-s.mean);
+    s.stddev=v.size()>1?std::sqrt(var/(n-1.0)):0.0;
+    s.min=v.front();
+    s.max=v.back();
+    s.p50=v[std::size_t(std::ceil(0.50*n))-1];
+    s.p95=v[std::size_t(std::ceil(0.95*n))-1];
+    return s;
+}
+
+}
+
+int sweepRunCount(const SweepSpec& spec){
+    const ParamSpec* params[9];
+    sweepParams(spec,params);
+    long long runs=std::max(1,spec.replicates);
+    for(const ParamSpec* p:params){
+        if(p->kind!=ParamSpec::Grid) continue;
+        runs*=std::max(1,p->steps);
+        if(runs>std::numeric_limits<int>::max()) return -1;
+    }
+    return int(runs);
+}
+
+std::vector<SweepRun> expandSweep(const SweepSpec& spec){
+    // las grillas forman el producto cartesiano
+    const ParamSpec* params[9];
+    sweepParams(spec,params);
+    const int replicates=std::max(1,spec.replicates);
+    const int total=sweepRunCount(spec);
+    if(total<0) return {};
+    const int points=total/replicates;
+
+    std::vector<SweepRun> runs;
+    runs.reserve(std::size_t(total));
+    for(int point=0;point<points;++point){
+        for(int r=0;r<replicates;++r){
+            SweepRun run;
+            run.index=int(runs.size());
+            run.seed=runSeed(spec.seed,run.index);
+            std::mt19937_64 rng(run.seed);
+
+            double values[9];
+            int rest=point;
+            for(int k=0;k<9;++k){
+                const ParamSpec& p=*params[k];
+                if(p.kind==ParamSpec::Grid){
+                    values[k]=gridValue(p,rest%p.steps);
+                    rest/=p.steps;
+                }else{
+                    values[k]=sample(p,rng);
+                }
+            }
+            for(int t=0;t<3;++t){
+                run.capacityL[t]=std::max(1.0,values[t]);
+                run.inputMaxLph[t]=std::max(0.0,values[3+t]);
+                run.outputMaxLph[t]=std::max(0.0,values[6+t]);
+            }
+            runs.push_back(run);
+        }
+    }
+    return runs;
+}
+
+SweepResult runScenario(const SweepSpec& spec,const SweepRun& run){
+    SweepResult res;
+    res.run=run;
+
+    const double dt=spec.tickS>0.0?spec.tickS:5.0;
+    SimEngine e(dt);
+    for(int t=0;t<3;++t){
+        e.setCapacityL(t,run.capacityL[t]);
+        e.setInputMaxLph(t,run.inputMaxLph[t]);
+        e.setOutputMaxLph(t,run.outputMaxLph[t]);
+        e.setLevelL(t,run.capacityL[t]*spec.initialLevelFrac);
+    }
+    e.setMainInputDial(spec.mainInputDial);
+    e.applyDistributionFromDial(spec.transferDial);
+
+    std::mt19937_64 rng(run.seed^0x5bd1e995u);
+    std::normal_distribution<double> noise(0.0,spec.demandNoise>0.0?spec.demandNoise:1.0);
+    const std::size_t profileSize=spec.demandDial.empty()?1:spec.demandDial.size();
+    const double stepS=spec.demandStepS>0.0?spec.demandStepS:3600.0;
+    std::size_t segment=0;
+    double nextDemandS=0.0;
+    int demand[3]={0,0,0};
+    bool armed[3]={true,true,true};
+
+    const unsigned long long ticks=(unsigned long long)(spec.durationS/dt+0.5);
+    for(unsigned long long k=0;k<ticks;++k){
+        const double t=e.timeS();
+        if(t>=nextDemandS){
+            double d=spec.demandDial.empty()?0.0:spec.demandDial[segment%profileSize];
+            for(int i=SimEngine::Auxiliar1;i<=SimEngine::Auxiliar2;++i){
+                double v=d+(spec.demandNoise>0.0?noise(rng):0.0);
+                demand[i]=int(std::lround(std::min(100.0,std::max(0.0,v))));
+            }
+            ++segment;
+            nextDemandS+=stepS;
+        }
+
+        // operador automatico: reabre lo que la planta corto cuando vuelve a haber lugar
+        if(e.mainInputDial()==0&&e.levelL(SimEngine::Principal)<=spec.refillBelowFrac*e.capacityL(SimEngine::Principal))
+            e.setMainInputDial(spec.mainInputDial);
+        if(e.mainOutputDial()==0&&e.canWithdraw(SimEngine::Principal)){
+            bool room=false;
+            for(int i=SimEngine::Auxiliar1;i<=SimEngine::Auxiliar2;++i)
+                room=room||e.levelL(i)<=spec.refillBelowFrac*e.capacityL(i);
+            if(room) e.applyDistributionFromDial(spec.transferDial);
+        }
+
+        double requested[3];
+        double deliverable[3];
+        for(int i=SimEngine::Auxiliar1;i<=SimEngine::Auxiliar2;++i){
+            const int d=demand[i];
+            if(e.auxOutputDial(i)!=d||(d>0&&e.currentOutputLph(i)<=0.0&&e.canWithdraw(i))) e.setAuxOutputDial(i,d);
+            // lo que sale en este tick, limitado por el agua que hay sobre el 10%
+            const double cap=e.capacityL(i);
+            const double out=e.currentOutputLph(i)*dt/3600.0;
+            const double avail=e.levelL(i)-0.1*cap+e.currentInputLph(i)*dt/3600.0;
+            deliverable[i]=std::max(0.0,std::min(out,avail));
+            requested[i]=(d/100.0)*e.outputMaxLph(i)*dt/3600.0;
+        }
+
+        e.step();
+
+        for(int i=SimEngine::Principal;i<=SimEngine::Auxiliar2;++i){
+            if(!e.canWithdraw(i)) res.timeAtMinimumS[i]+=dt;
+            // EventFull se repite en cada tick a tope y la distribucion puede
+            // alternar entre auxiliares llenos: se cuenta una vez por llenado,
+            // y se vuelve a contar recien cuando el tanque bajo de refillBelowFrac
+            const bool full=(e.takeEvents(i)&SimEngine::EventFull)!=0;
+            if(full&&armed[i]){ ++res.overflowEvents; armed[i]=false; }
+            if(e.levelL(i)<=spec.refillBelowFrac*e.capacityL(i)) armed[i]=true;
+        }
+        for(int i=SimEngine::Auxiliar1;i<=SimEngine::Auxiliar2;++i){
+            res.demandL+=requested[i];
+            res.unmetDemandL+=std::max(0.0,requested[i]-deliverable[i]);
+        }
+    }
+    return res;
+}
+
+std::vector<SweepResult> runSweep(const SweepSpec& spec,ThreadPool& pool){
+    const std::vector<SweepRun> runs=expandSweep(spec);
+    std::vector<SweepResult> results(runs.size());
+    pool.parallelFor(int(runs.size()),[&](int i){ results[i]=runScenario(spec,runs[i]); });
+    return results;
+}
+
+SweepSummary summarizeSweep(const std::vector<SweepResult>& results){
+    SweepSummary s;
+    s.runs=int(results.size());
+    std::vector<double> v(results.size());
+
+    for(int t=0;t<3;++t){
+        for(std::size_t k=0;k<results.size();++k) v[k]=results[k].timeAtMinimumS[t];
+        s.timeAtMinimumS[t]=stat(v);
+    }
+    for(std::size_t k=0;k<results.size();++k) v[k]=results[k].overflowEvents;
+    s.overflowEvents=stat(v);
+    for(std::size_t k=0;k<results.size();++k) v[k]=results[k].unmetDemandL;
+    s.unmetDemandL=stat(v);
+    for(std::size_t k=0;k<results.size();++k)
+        v[k]=results[k].demandL>0.0?results[k].unmetDemandL/results[k].demandL:0.0;
+    s.unmetDemandFrac=stat(v);
+    return s;
+}
@@ -0,0 +1,104 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <vector>
+
+#include "simengine.h"
+
+class ThreadPool;
+
+// Barrido de parametros / Monte Carlo sobre la planta de tres tanques. Cada
+// corrida es una simulacion sin GUI e independiente de las demas, asi que se
+// reparten en un ThreadPool y escalan con los nucleos. Los resultados quedan en
+// el orden de las corridas y cada una tiene su semilla: el resultado no depende
+// de cuantos hilos haya.
+
+// Un parametro: fijo, grilla de "steps" valores en [a,b], o muestreado por
+// corrida de una uniforme [a,b) o una normal (media a, desvio b).
+struct ParamSpec {
+    enum Kind {
+        Fixed,
+        Grid,
+        Uniform,
+        Normal
+    };
+
+    Kind kind=Fixed;
+    double a=0.0;
+    double b=0.0;
+    int steps=1;
+
+    static ParamSpec fixed(double v);
+    static ParamSpec grid(double from,double to,int steps);
+    static ParamSpec uniform(double from,double to);
+    static ParamSpec normal(double mean,double stddev);
+};
+
+struct SweepSpec {
+    // indexados por tanque (Principal, Auxiliar1, Auxiliar2)
+    ParamSpec capacityL[3]={ParamSpec::fixed(1000.0),ParamSpec::fixed(200.0),ParamSpec::fixed(200.0)};
+    ParamSpec inputMaxLph[3]={ParamSpec::fixed(500.0),ParamSpec::fixed(300.0),ParamSpec::fixed(300.0)};
+    ParamSpec outputMaxLph[3]={ParamSpec::fixed(500.0),ParamSpec::fixed(100.0),ParamSpec::fixed(100.0)};
+
+    // consignas del operador; si el motor las corta se reabren cuando hay lugar
+    int mainInputDial=100;
+    int transferDial=100;
+    double refillBelowFrac=0.9;
+
+    // demanda de los auxiliares: dial (0..100) por tramo de demandStepS, ciclico,
+    // mas ruido normal de desvio demandNoise por tramo
+    std::vector<double> demandDial{50.0};
+    double demandStepS=3600.0;
+    double demandNoise=0.0;
+
+    double durationS=3.0*24.0*3600.0;
+    double tickS=5.0;
+    double initialLevelFrac=0.5;
+
+    int replicates=1;       // corridas por punto de la grilla
+    unsigned seed=1;
+};
+
+struct SweepRun {
+    int index=0;
+    unsigned seed=0;
+    double capacityL[3]={0,0,0};
+    double inputMaxLph[3]={0,0,0};
+    double outputMaxLph[3]={0,0,0};
+};
+
+struct SweepResult {
+    SweepRun run;
+    double timeAtMinimumS[3]={0,0,0};   // tiempo sin poder extraer (nivel <= 10%)
+    unsigned overflowEvents=0;          // llenados (con histeresis refillBelowFrac)
+    double demandL=0.0;                 // pedido por los auxiliares
+    double unmetDemandL=0.0;            // pedido que no se pudo entregar
+};
+
+struct SweepStat {
+    double mean=0.0;
+    double stddev=0.0;
+    double min=0.0;
+    double p50=0.0;
+    double p95=0.0;
+    double max=0.0;
+};
+
+struct SweepSummary {
+    int runs=0;
+    SweepStat timeAtMinimumS[3];
+    SweepStat overflowEvents;
+    SweepStat unmetDemandL;
+    SweepStat unmetDemandFrac;
+};
+
+// corridas de expandSweep(); -1 si no entran en un int
+int sweepRunCount(const SweepSpec& spec);
+// producto cartesiano de las grillas x replicates, con los muestreos ya hechos;
+// vacio si sweepRunCount() es -1
+std::vector<SweepRun> expandSweep(const SweepSpec& spec);
+SweepResult runScenario(const SweepSpec& spec,const SweepRun& run);
+std::vector<SweepResult> runSweep(const SweepSpec& spec,ThreadPool& pool);
+SweepSummary summarizeSweep(const std::vector<SweepResult>& results);
+
+#endif // SWEEP_H
@@ -0,0 +1,188 @@
+#include "tankgraph.h"
+
+#include <algorithm>
+
+#include "threadpool.h"
+
+int TankGraph::addTank(double capacityL){
+    m_supplyLph.push_back(0.0);
+    m_demandLph.push_back(0.0);
+    m_receivedLph.push_back(0.0);
+    m_built=false;
+    return m_net.addTank(capacityL);
+}
+
+int TankGraph::addPipe(int from,int to,double maxLph){
+    if(from<0||to<0||from>=tankCount()||to>=tankCount()||from==to) return -1;
+    m_pipeFrom.push_back(from);
+    m_pipeTo.push_back(to);
+    m_pipeMaxLph.push_back(std::max(0.0,maxLph));
+    m_pipeOpen.push_back(1);
+    m_pipeFlowLph.push_back(0.0);
+    m_built=false;
+    return pipeCount()-1;
+}
+
+int TankGraph::tankCount()const{return m_net.size();}
+int TankGraph::pipeCount()const{return int(m_pipeFrom.size());}
+TankNetwork& TankGraph::network(){return m_net;}
+const TankNetwork& TankGraph::network()const{return m_net;}
+
+void TankGraph::setSupplyLph(int i,double Lph){ m_supplyLph[i]=std::max(0.0,Lph); }
+void TankGraph::setDemandLph(int i,double Lph){ m_demandLph[i]=std::max(0.0,Lph); }
+double TankGraph::supplyLph(int i)const{return m_supplyLph[i];}
+double TankGraph::demandLph(int i)const{return m_demandLph[i];}
+
+void TankGraph::setPipeOpen(int p,bool open){ m_pipeOpen[p]=open?1:0; }
+void TankGraph::setPipeMaxLph(int p,double Lph){ m_pipeMaxLph[p]=std::max(0.0,Lph); }
+bool TankGraph::isPipeOpen(int p)const{return m_pipeOpen[p]!=0;}
+double TankGraph::pipeMaxLph(int p)const{return m_pipeMaxLph[p];}
+int TankGraph::pipeFrom(int p)const{return m_pipeFrom[p];}
+int TankGraph::pipeTo(int p)const{return m_pipeTo[p];}
+double TankGraph::pipeFlowLph(int p)const{return m_pipeFlowLph[p];}
+
+int TankGraph::componentCount()const{return m_built?int(m_compStart.size())-1:0;}
+int TankGraph::componentOf(int i)const{return m_built?m_component[i]:-1;}
+
+//topologia
+
+static int findRoot(std::vector<int>& parent,int i){
+    while(parent[i]!=i){
+        parent[i]=parent[parent[i]];
+        i=parent[i];
+    }
+    return i;
+}
+
+bool TankGraph::build(){
+    const int n=tankCount();
+    const int np=pipeCount();
+
+    m_outStart.assign(n+1,0);
+    for(int p=0;p<np;++p) ++m_outStart[m_pipeFrom[p]+1];
+    for(int i=0;i<n;++i) m_outStart[i+1]+=m_outStart[i];
+    m_outPipes.resize(np);
+    std::vector<int> fill(m_outStart.begin(),m_outStart.end()-1);
+    for(int p=0;p<np;++p) m_outPipes[fill[m_pipeFrom[p]]++]=p;
+
+    // orden topologico (Kahn), en orden de indice entre los que estan listos
+    std::vector<int> indegree(n,0);
+    for(int p=0;p<np;++p) ++indegree[m_pipeTo[p]];
+    std::vector<int> topo;
+    topo.reserve(n);
+    for(int i=0;i<n;++i) if(indegree[i]==0) topo.push_back(i);
+    for(int k=0;k<int(topo.size());++k){
+        const int u=topo[k];
+        for(int e=m_outStart[u];e<m_outStart[u+1];++e){
+            const int v=m_pipeTo[m_outPipes[e]];
+            if(--indegree[v]==0) topo.push_back(v);
+        }
+    }
+    if(int(topo.size())!=n){ m_built=false; return false; }
+
+    // subgrafos: union-find sin mirar la direccion de los caños, numerados por
+    // el menor indice de tanque de cada uno
+    std::vector<int> parent(n);
+    for(int i=0;i<n;++i) parent[i]=i;
+    for(int p=0;p<np;++p){
+        const int a=findRoot(parent,m_pipeFrom[p]);
+        const int b=findRoot(parent,m_pipeTo[p]);
+        if(a!=b) parent[std::max(a,b)]=std::min(a,b);
+    }
+    m_component.assign(n,-1);
+    std::vector<int> rootComp(n,-1);
+    int comps=0;
+    for(int i=0;i<n;++i){
+        const int r=findRoot(parent,i);
+        if(rootComp[r]<0) rootComp[r]=comps++;
+        m_component[i]=rootComp[r];
+    }
+
+    // reparto estable por subgrafo: cada uno conserva el orden topologico
+    m_compStart.assign(comps+1,0);
+    for(int i=0;i<n;++i) ++m_compStart[m_component[i]+1];
+    for(int c=0;c<comps;++c) m_compStart[c+1]+=m_compStart[c];
+    m_order.resize(n);
+    fill.assign(m_compStart.begin(),m_compStart.end()-1);
+    for(int u:topo) m_order[fill[m_component[u]]++]=u;
+
+    m_weight.assign(np,0.0);
+    m_cap.assign(np,0.0);
+    m_enabled.assign(np,0);
+    m_share.assign(np,0.0);
+    m_compEvents.assign(comps,0);
+    m_alloc.assign(comps,FlowAllocator());
+    for(int i=0;i<n;++i) m_alloc[m_component[i]].reserve(m_outStart[i+1]-m_outStart[i]);
+    m_built=true;
+    return true;
+}
+
+//avance
+
+int TankGraph::step(double dt_s,ThreadPool* pool){
+    if(dt_s<=0.0) return 0;
+    if(!m_built&&!build()) return -1;
+    const int comps=componentCount();
+    if(pool&&comps>1){
+        // varios subgrafos por tarea para que los chicos no paguen el costo del pool
+        const int grain=std::max(1,comps/(8*pool->threadCount()));
+        pool->parallelFor(comps,[this,dt_s](int c){ m_compEvents[c]=stepComponent(c,dt_s); },grain);
+    }else{
+        for(int c=0;c<comps;++c) m_compEvents[c]=stepComponent(c,dt_s);
+    }
+    int withEvents=0;
+    for(int c=0;c<comps;++c) withEvents+=m_compEvents[c];
+    return withEvents;
+}
+
+int TankGraph::stepComponent(int c,double dt_s){
+    const double toL=dt_s/3600.0;
+    const int begin=m_compStart[c];
+    const int end=m_compStart[c+1];
+    FlowAllocator& alloc=m_alloc[c];
+    int withEvents=0;
+
+    for(int k=begin;k<end;++k) m_receivedLph[m_order[k]]=0.0;
+
+    for(int k=begin;k<end;++k){
+        const int u=m_order[k];
+        // los padres ya pasaron (orden topologico): lo recibido esta completo
+        m_net.applyInputFlowLph(u,m_supplyLph[u]+m_receivedLph[u]);
+        const double in=m_net.inputFlowLph(u);
+
+        // lo que se puede sacar en este tick sin bajar del 10%, asi el kernel no
+        // recorta la salida y lo que mandan los caños es lo que sale del tanque
+        const double capL=m_net.capacityL(u);
+        const double L=m_net.levelL(u);
+        double budget=0.0;
+        if(L>0.1*capL) budget=std::min(m_net.outputMaxLph(u),std::max(0.0,(L+in*toL-0.1*capL)/toL));
+        const double served=std::min(m_demandLph[u],budget);
+
+        const int e0=m_outStart[u];
+        const int deg=m_outStart[u+1]-e0;
+        double sent=0.0;
+        if(deg>0){
+            for(int e=e0;e<e0+deg;++e){
+                const int p=m_outPipes[e];
+                const int v=m_pipeTo[p];
+                const double space=m_net.capacityL(v)-m_net.levelL(v);
+                const double room=m_net.inputMaxLph(v)-m_supplyLph[v]-m_receivedLph[v];
+                m_enabled[e]=m_pipeOpen[p]&&m_net.isInputEnabled(v)&&space>0.0;
+                m_weight[e]=space;
+                // no mas de lo que entra por el caño, por la entrada del hijo ni
+                // de lo que lo llena en este tick
+                m_cap[e]=std::max(0.0,std::min(m_pipeMaxLph[p],std::min(room,space/toL)));
+            }
+            sent=alloc.allocate(budget-served,m_weight.data()+e0,m_cap.data()+e0,
+                                m_enabled.data()+e0,deg,m_share.data()+e0);
+            for(int e=e0;e<e0+deg;++e){
+                const int p=m_outPipes[e];
+                m_pipeFlowLph[p]=m_share[e];
+                m_receivedLph[m_pipeTo[p]]+=m_share[e];
+            }
+        }
+        m_net.applyOutputFlowLph(u,served+sent);
+        withEvents+=m_net.tickRange(u,u+1,dt_s);
+    }
+    return withEvents;
+}
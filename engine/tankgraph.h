@@ -0,0 +1,91 @@
+#ifndef TANKGRAPH_H
+#define TANKGRAPH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "flowallocator.h"
+#include "tanknetwork.h"
+
+class ThreadPool;
+
+// Sitio descripto como grafo dirigido: tanques unidos por caños (cisternas ->
+// torres -> tanques de zona). En cada tick se recorre el grafo en orden
+// topologico: cada tanque recibe lo que le mandaron sus padres, calcula cuanto
+// puede entregar sin bajar del 10% y lo reparte entre sus hijos por llenado de
+// agua (FlowAllocator). La integracion usa las mismas reglas de TankNetwork
+// (las de ControlTanque): entrada cortada al llenarse, salida cortada al 10%.
+//
+// Los subgrafos sin caños entre si no dependen unos de otros y se pueden
+// integrar en paralelo. Para no compartir lineas de cache entre hilos conviene
+// numerar seguidos los tanques de cada subgrafo.
+
+class TankGraph {
+public:
+    TankGraph()=default;
+
+    int addTank(double capacityL=100.0);
+    int addPipe(int from,int to,double maxLph);
+    int tankCount()const;
+    int pipeCount()const;
+    TankNetwork& network();
+    const TankNetwork& network()const;
+
+    // entrada desde afuera (red de agua) y consumo hacia afuera, en L/h;
+    // el consumo tiene prioridad sobre lo que se manda por los caños
+    void setSupplyLph(int i,double Lph);
+    void setDemandLph(int i,double Lph);
+    double supplyLph(int i)const;
+    double demandLph(int i)const;
+
+    void setPipeOpen(int p,bool open);
+    void setPipeMaxLph(int p,double Lph);
+    bool isPipeOpen(int p)const;
+    double pipeMaxLph(int p)const;
+    int pipeFrom(int p)const;
+    int pipeTo(int p)const;
+    double pipeFlowLph(int p)const;   // lo que paso en el ultimo tick
+
+    // arma el orden topologico y separa los subgrafos; false si hay un ciclo.
+    // step() lo llama solo si cambio la topologia
+    bool build();
+    int componentCount()const;
+    int componentOf(int i)const;
+
+    // un tick de dt_s; con pool los subgrafos se reparten entre sus hilos.
+    // Devuelve cuantos tanques tuvieron eventos (-1 si el grafo tiene un ciclo)
+    int step(double dt_s,ThreadPool* pool=nullptr);
+
+private:
+    TankNetwork m_net;
+    std::vector<double> m_supplyLph;
+    std::vector<double> m_demandLph;
+    std::vector<double> m_receivedLph;
+
+    std::vector<int> m_pipeFrom;
+    std::vector<int> m_pipeTo;
+    std::vector<double> m_pipeMaxLph;
+    std::vector<std::uint8_t> m_pipeOpen;
+    std::vector<double> m_pipeFlowLph;
+
+    // caños salientes en formato CSR: los de i son m_outPipes[m_outStart[i]..m_outStart[i+1])
+    std::vector<int> m_outStart;
+    std::vector<int> m_outPipes;
+    // orden topologico agrupado por subgrafo: el c es m_order[m_compStart[c]..m_compStart[c+1])
+    std::vector<int> m_order;
+    std::vector<int> m_compStart;
+    std::vector<int> m_component;
+    std::vector<int> m_compEvents;
+    bool m_built=false;
+
+    // memoria de trabajo del reparto, indexada como m_outPipes
+    std::vector<double> m_weight;
+    std::vector<double> m_cap;
+    std::vector<std::uint8_t> m_enabled;
+    std::vector<double> m_share;
+    std::vector<FlowAllocator> m_alloc;
+
+    int stepComponent(int c,double dt_s);
+};
+
+#endif // TANKGRAPH_H
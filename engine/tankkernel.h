@@ -0,0 +1,60 @@
+#ifndef TANKKERNEL_H
+#define TANKKERNEL_H
+
+#include <cstdint>
+
+#include "tanknetwork.h"
+
+// Misma regla que el viejo ControlTanque::onTick pero escrita con selects en vez
+// de ramas: recorte al 10% de la capacidad, deteccion de lleno/vacio y cambio de
+// "se puede extraer". Sin ramas ni aliasing el compilador lo vectoriza (con gcc
+// hace falta -fno-trapping-math, ver engine.pri). Lo usan TankNetwork::tickRange
+// y FixedPlant; con n constante en tiempo de compilacion queda desenrollado.
+inline int tickKernel(const double* __restrict cap,double* __restrict lvl,
+                      double* __restrict inF,double* __restrict outF,
+                      std::uint8_t* __restrict cw,std::uint8_t* __restrict evs,
+                      int n,double dt_s){
+    const double toL=dt_s/3600.0;
+    const double toLph=3600.0/dt_s;
+    int withEvents=0;
+
+    for(int i=0;i<n;++i){
+        const double c=cap[i];
+        const double L=lvl[i];
+        const double minAllowed=0.1*c;
+        const double inFlow=inF[i];
+        const double inL=inFlow*toL;
+        double out=outF[i];
+
+        // recorte de la salida para no bajar del minimo
+        const bool clamp=(out>0.0)&(L+inL-out*toL<minAllowed);
+        const double maxRemovableL=L-minAllowed;
+        const double limitOut=maxRemovableL*toLph;
+        double clampedOut=(out<limitOut)?out:limitOut;
+        clampedOut=(maxRemovableL<=0.0)?0.0:clampedOut;
+        out=clamp?clampedOut:out;
+        double newLevel=L+inL-out*toL;
+        const bool floorHit=clamp&(maxRemovableL>0.0)&(newLevel<minAllowed);
+        newLevel=floorHit?minAllowed:newLevel;
+        out=floorHit?0.0:out;
+
+        const bool full=newLevel>=c;
+        const bool empty=(!full)&(newLevel<=0.0);
+        const double finalLevel=full?c:(empty?0.0:newLevel);
+        lvl[i]=finalLevel;
+        inF[i]=full?0.0:inFlow;
+        out=empty?0.0:out;
+
+        const bool canW=finalLevel>minAllowed;
+        const bool changed=canW!=(cw[i]!=0);
+        out=(changed&!canW)?0.0:out;
+        outF[i]=out;
+        cw[i]=canW;
+        const std::uint8_t ev=std::uint8_t(full*TankNetwork::EventFull|empty*TankNetwork::EventEmpty|changed*TankNetwork::EventCanWithdrawChanged);
+        evs[i]=ev;
+        withEvents+=(ev!=0);
+    }
+    return withEvents;
+}
+
+#endif // TANKKERNEL_H
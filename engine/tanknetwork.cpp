@@ -0,0 +1,205 @@
+#include "tanknetwork.h"
+#include "tankkernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+int TankNetwork::size()const{return int(m_levelL.size());}
+
+void TankNetwork::resize(int n){
+    m_capacityL.resize(n,100.0);
+    m_levelL.resize(n,0.0);
+    m_inputFlowLph.resize(n,0.0);
+    m_outputFlowLph.resize(n,0.0);
+    m_inputMaxLph.resize(n,100.0);
+    m_outputMaxLph.resize(n,100.0);
+    m_inputEnabled.resize(n,1);
+    m_canWithdraw.resize(n,0);
+    m_events.resize(n,0);
+    for(int i=n;i<int(m_outflowLaw.size());++i) m_gravityCount-=(m_outflowLaw[i]==OutflowGravity);
+    m_outflowLaw.resize(n,OutflowConstant);
+    m_inputSource.resize(n,-1);
+}
+
+void TankNetwork::reserve(int n){
+    m_capacityL.reserve(n);
+    m_levelL.reserve(n);
+    m_inputFlowLph.reserve(n);
+    m_outputFlowLph.reserve(n);
+    m_inputMaxLph.reserve(n);
+    m_outputMaxLph.reserve(n);
+    m_inputEnabled.reserve(n);
+    m_canWithdraw.reserve(n);
+    m_events.reserve(n);
+    m_outflowLaw.reserve(n);
+    m_inputSource.reserve(n);
+}
+
+int TankNetwork::addTank(double capacityL){
+    int i=size();
+    resize(i+1);
+    setCapacityL(i,capacityL);
+    return i;
+}
+
+void TankNetwork::restore(int n,const double* capacityL,const double* levelL,
+                          const double* inputFlowLph,const double* outputFlowLph,
+                          const double* inputMaxLph,const double* outputMaxLph,
+                          const std::uint8_t* inputEnabled,const std::uint8_t* canWithdraw){
+    m_capacityL.assign(capacityL,capacityL+n);
+    m_levelL.assign(levelL,levelL+n);
+    m_inputFlowLph.assign(inputFlowLph,inputFlowLph+n);
+    m_outputFlowLph.assign(outputFlowLph,outputFlowLph+n);
+    m_inputMaxLph.assign(inputMaxLph,inputMaxLph+n);
+    m_outputMaxLph.assign(outputMaxLph,outputMaxLph+n);
+    m_inputEnabled.assign(inputEnabled,inputEnabled+n);
+    m_canWithdraw.assign(canWithdraw,canWithdraw+n);
+    m_events.assign(n,0);
+    for(int i=n;i<int(m_outflowLaw.size());++i) m_gravityCount-=(m_outflowLaw[i]==OutflowGravity);
+    m_outflowLaw.resize(n,OutflowConstant);
+    m_inputSource.resize(n,-1);
+    for(int& src:m_inputSource) if(src>=n) src=-1;
+}
+
+int TankNetwork::tick(double dt_s){
+    return tickRange(0,size(),dt_s);
+}
+
+int TankNetwork::tickRange(int begin,int end,double dt_s){
+    if(end<=begin) return 0;
+    return tickKernel(m_capacityL.data()+begin,m_levelL.data()+begin,
+                      m_inputFlowLph.data()+begin,m_outputFlowLph.data()+begin,
+                      m_canWithdraw.data()+begin,m_events.data()+begin,
+                      end-begin,dt_s);
+}
+
+// justo sobre el 10% decide la pendiente: subiendo ya se puede extraer
+bool TankNetwork::analyticCanWithdraw(int i,double L,double rateLps)const{
+    const double minAllowed=0.1*m_capacityL[i];
+    const double tol=1e-9*m_capacityL[i];
+    if(L>minAllowed+tol) return true;
+    if(L<minAllowed-tol) return false;
+    return rateLps>0.0;
+}
+
+double TankNetwork::timeToNextEventS(int i)const{
+    const double c=m_capacityL[i];
+    const double L=m_levelL[i];
+    const double minAllowed=0.1*c;
+    const double in=m_inputFlowLph[i];
+    const double out=m_outputFlowLph[i];
+    const double rate=(in-out)/3600.0;
+    const bool cw=m_canWithdraw[i]!=0;
+
+    // estado inconsistente (salida bajo el minimo, bandera vieja): se resuelve ya
+    if(out>0.0&&L<=minAllowed) return 0.0;
+    if(analyticCanWithdraw(i,L,rate)!=cw) return 0.0;
+
+    double t=std::numeric_limits<double>::infinity();
+    if(rate>0.0){
+        if(in>0.0) t=std::min(t,(c-L)/rate);
+        if(!cw) t=std::min(t,(minAllowed-L)/rate);
+    }else if(rate<0.0&&cw&&out>0.0){
+        t=std::min(t,(L-minAllowed)/(-rate));
+    }
+    return std::max(0.0,t);
+}
+
+// avanza dt_s de forma exacta y aplica el evento si dt_s cae justo en el cruce
+unsigned TankNetwork::advanceLinear(int i,double dt_s){
+    const double rate=(m_inputFlowLph[i]-m_outputFlowLph[i])/3600.0;
+    return settleLevel(i,m_levelL[i]+rate*dt_s,rate);
+}
+
+unsigned TankNetwork::settle(int i){
+    const double* lvl=m_levelL.data();
+    const double rate=(effectiveInputLph(i,lvl)-effectiveOutputLph(i,lvl))/3600.0;
+    return settleLevel(i,m_levelL[i],rate);
+}
+
+// el nivel nunca baja del 10% porque la salida se corta ahi (no hay "vacio")
+unsigned TankNetwork::settleLevel(int i,double L,double rateLps){
+    const double c=m_capacityL[i];
+    const double minAllowed=0.1*c;
+    const double tol=1e-9*c;
+    unsigned ev=0u;
+
+    if(m_inputFlowLph[i]>0.0&&L>=c-tol){
+        L=c;
+        m_inputFlowLph[i]=0.0;
+        ev|=EventFull;
+    }else if(L>c){
+        L=c;
+    }
+    if(m_outputFlowLph[i]>0.0&&L<=minAllowed+tol){
+        L=std::max(L,minAllowed);
+        m_outputFlowLph[i]=0.0;
+    }
+
+    const bool cw=analyticCanWithdraw(i,L,rateLps);
+    if(cw!=(m_canWithdraw[i]!=0)){
+        m_canWithdraw[i]=cw;
+        if(!cw) m_outputFlowLph[i]=0.0;
+        ev|=EventCanWithdrawChanged;
+    }
+    m_levelL[i]=L;
+    m_events[i]=std::uint8_t(ev);
+    return ev;
+}
+
+//caudales que dependen del nivel
+
+void TankNetwork::setOutflowLaw(int i,OutflowLaw law){
+    m_gravityCount+=(law==OutflowGravity)-(m_outflowLaw[i]==OutflowGravity);
+    m_outflowLaw[i]=law;
+}
+
+void TankNetwork::setInputSource(int i,int source){
+    m_inputSource[i]=(source>=0&&source<size()&&source!=i)?source:-1;
+}
+
+bool TankNetwork::hasLevelDependentFlows()const{return m_gravityCount>0;}
+
+static double headFactor(double L,double c){return std::sqrt(std::max(0.0,L)/c);}
+
+double TankNetwork::effectiveInputLph(int i,const double* levelL)const{
+    const int src=m_inputSource[i];
+    if(src<0||m_outflowLaw[src]!=OutflowGravity) return m_inputFlowLph[i];
+    return m_inputFlowLph[i]*headFactor(levelL[src],m_capacityL[src]);
+}
+
+double TankNetwork::effectiveOutputLph(int i,const double* levelL)const{
+    if(m_outflowLaw[i]!=OutflowGravity) return m_outputFlowLph[i];
+    return m_outputFlowLph[i]*headFactor(levelL[i],m_capacityL[i]);
+}
+
+void TankNetwork::rates(const double* levelL,double* dLdtLps)const{
+    const int n=size();
+    for(int i=0;i<n;++i) dLdtLps[i]=(effectiveInputLph(i,levelL)-effectiveOutputLph(i,levelL))/3600.0;
+}
+
+void TankNetwork::setCapacityL(int i,double L){
+    double newCap=std::max(1.0,L);
+    if(m_levelL[i]>newCap) m_levelL[i]=newCap;
+    m_capacityL[i]=newCap;
+}
+
+void TankNetwork::setLevelL(int i,double L){ m_levelL[i]=L; }
+void TankNetwork::setInputMaxLph(int i,double Lph){ m_inputMaxLph[i]=std::max(0.0,Lph); }
+void TankNetwork::setOutputMaxLph(int i,double Lph){ m_outputMaxLph[i]=std::max(0.0,Lph); }
+
+void TankNetwork::setInputEnabled(int i,bool enabled){
+    m_inputEnabled[i]=enabled?1:0;
+    if(!enabled) m_inputFlowLph[i]=0.0;
+}
+
+void TankNetwork::applyInputFlowLph(int i,double Lph){
+    if(!m_inputEnabled[i]||m_levelL[i]>=m_capacityL[i]){ m_inputFlowLph[i]=0.0; return; }
+    m_inputFlowLph[i]=std::min(Lph,m_inputMaxLph[i]);
+}
+
+void TankNetwork::applyOutputFlowLph(int i,double Lph){
+    if(m_levelL[i]<=0.1*m_capacityL[i]){ m_outputFlowLph[i]=0.0; return; }
+    m_outputFlowLph[i]=std::min(Lph,m_outputMaxLph[i]);
+}
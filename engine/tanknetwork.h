@@ -0,0 +1,108 @@
+#ifndef TANKNETWORK_H
+#define TANKNETWORK_H
+
+#include <cstdint>
+#include <vector>
+
+// Red de tanques en formato struct-of-arrays: cada propiedad vive en su propio
+// arreglo contiguo para que el tick recorra todos los tanques en un solo loop
+// sin saltos (el compilador lo puede vectorizar).
+
+class TankNetwork {
+public:
+    enum Event : std::uint8_t {
+        EventFull=1u<<0,
+        EventEmpty=1u<<1,
+        EventCanWithdrawChanged=1u<<2
+    };
+
+    // como depende la salida del nivel; el tick fijo y el modo analitico suponen
+    // caudales constantes, la descarga por gravedad necesita un Integrator
+    enum OutflowLaw : std::uint8_t {
+        OutflowConstant,    // la salida es la fijada con applyOutputFlowLph
+        OutflowGravity      // Torricelli: salida fijada (a tanque lleno) x sqrt(nivel/capacidad)
+    };
+
+    TankNetwork()=default;
+
+    int size()const;
+    void resize(int n);
+    void reserve(int n);
+    int addTank(double capacityL=100.0);
+
+    // copia columnas guardadas tal cual, sin aplicar reglas (fotos binarias); la
+    // ley de salida y el origen de la entrada no se guardan y se conservan
+    void restore(int n,const double* capacityL,const double* levelL,
+                 const double* inputFlowLph,const double* outputFlowLph,
+                 const double* inputMaxLph,const double* outputMaxLph,
+                 const std::uint8_t* inputEnabled,const std::uint8_t* canWithdraw);
+
+    // integra [begin,end) un paso de dt_s segundos; devuelve cuantos tanques tuvieron eventos
+    int tick(double dt_s);
+    int tickRange(int begin,int end,double dt_s);
+
+    // modo analitico: con flujos constantes el nivel es lineal en el tiempo, asi
+    // que se puede calcular cuando ocurre el proximo evento y saltar hasta ahi
+    double timeToNextEventS(int i)const;
+    unsigned advanceLinear(int i,double dt_s);
+
+    // caudales que dependen del nivel: la entrada de un tanque alimentado por uno
+    // que descarga por gravedad baja con la salida de ese origen (-1: externa)
+    void setOutflowLaw(int i,OutflowLaw law);
+    OutflowLaw outflowLaw(int i)const{return OutflowLaw(m_outflowLaw[i]);}
+    void setInputSource(int i,int source);
+    int inputSource(int i)const{return m_inputSource[i];}
+    bool hasLevelDependentFlows()const;
+    double effectiveInputLph(int i,const double* levelL)const;
+    double effectiveOutputLph(int i,const double* levelL)const;
+    // derivada de cada nivel (L/s) con los niveles dados, lo que integra un Integrator
+    void rates(const double* levelL,double* dLdtLps)const;
+
+    // reglas de umbral (lleno, 10%) sobre el nivel actual, como al final de
+    // advanceLinear; la pendiente en el umbral sale de los caudales efectivos
+    unsigned settle(int i);
+
+    void setCapacityL(int i,double L);
+    void setLevelL(int i,double L);
+    void setInputMaxLph(int i,double Lph);
+    void setOutputMaxLph(int i,double Lph);
+    void setInputEnabled(int i,bool enabled);
+    void applyInputFlowLph(int i,double Lph);
+    void applyOutputFlowLph(int i,double Lph);
+
+    double capacityL(int i)const{return m_capacityL[i];}
+    double levelL(int i)const{return m_levelL[i];}
+    double inputMaxLph(int i)const{return m_inputMaxLph[i];}
+    double outputMaxLph(int i)const{return m_outputMaxLph[i];}
+    double inputFlowLph(int i)const{return m_inputFlowLph[i];}
+    double outputFlowLph(int i)const{return m_outputFlowLph[i];}
+    bool isInputEnabled(int i)const{return m_inputEnabled[i]!=0;}
+    bool canWithdraw(int i)const{return m_canWithdraw[i]!=0;}
+    unsigned events(int i)const{return m_events[i];}
+
+    // acceso directo a los arreglos para recorridos masivos
+    const double* capacities()const{return m_capacityL.data();}
+    const double* levels()const{return m_levelL.data();}
+    const double* inputFlows()const{return m_inputFlowLph.data();}
+    const double* outputFlows()const{return m_outputFlowLph.data();}
+    const std::uint8_t* eventFlags()const{return m_events.data();}
+
+private:
+    bool analyticCanWithdraw(int i,double L,double rateLps)const;
+    unsigned settleLevel(int i,double L,double rateLps);
+
+    std::vector<double> m_capacityL;
+    std::vector<double> m_levelL;
+    std::vector<double> m_inputFlowLph;
+    std::vector<double> m_outputFlowLph;
+    std::vector<double> m_inputMaxLph;
+    std::vector<double> m_outputMaxLph;
+    std::vector<std::uint8_t> m_inputEnabled;
+    std::vector<std::uint8_t> m_canWithdraw;
+    std::vector<std::uint8_t> m_events;
+    std::vector<std::uint8_t> m_outflowLaw;
+    std::vector<int> m_inputSource;
+    int m_gravityCount=0;
+};
+
+#endif // TANKNETWORK_H
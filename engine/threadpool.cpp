@@ -0,0 +1,101 @@
+#include "threadpool.h"
+
+#include <utility>
+
+namespace {
+// indice del hilo del pool que esta corriendo (-1 fuera del pool)
+thread_local const ThreadPool* tlsPool=nullptr;
+thread_local int tlsIndex=-1;
+}
+
+ThreadPool::ThreadPool(int threads)
+    : m_next(0),
+    m_queued(0),
+    m_unfinished(0),
+    m_stop(false)
+{
+    if(threads<=0) threads=int(std::thread::hardware_concurrency());
+    if(threads<=0) threads=1;
+    for(int i=0;i<threads;++i) m_queues.emplace_back(new Queue);
+    for(int i=0;i<threads;++i) m_threads.emplace_back([this,i]{ workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop=true;
+    }
+    m_workReady.notify_all();
+    for(std::thread& t:m_threads) t.join();
+}
+
+int ThreadPool::threadCount()const{return int(m_threads.size());}
+
+// desde un hilo del pool va a su propia cola; desde afuera, en ronda
+void ThreadPool::submit(Task task){
+    const int n=int(m_queues.size());
+    const int target=(tlsPool==this)?tlsIndex:int(m_next.fetch_add(1,std::memory_order_relaxed)%unsigned(n));
+    {
+        std::lock_guard<std::mutex> lock(m_queues[target]->mutex);
+        m_queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_queued;
+        ++m_unfinished;
+    }
+    m_workReady.notify_one();
+}
+
+void ThreadPool::wait(){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_allDone.wait(lock,[this]{ return m_unfinished==0; });
+}
+
+bool ThreadPool::popLocal(int self,Task& task){
+    Queue& q=*m_queues[self];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if(q.tasks.empty()) return false;
+    task=std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(int self,Task& task){
+    const int n=int(m_queues.size());
+    for(int k=1;k<n;++k){
+        Queue& q=*m_queues[(self+k)%n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if(q.tasks.empty()) continue;
+        task=std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int self){
+    tlsPool=this;
+    tlsIndex=self;
+    for(;;){
+        {
+            // m_queued cuenta lo que todavia esta en alguna cola: sin eso no hay que buscar
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workReady.wait(lock,[this]{ return m_stop||m_queued>0; });
+            if(m_queued==0) return;
+            --m_queued;
+        }
+
+        // ya se reservo una tarea: alguna cola la tiene
+        Task task;
+        while(!popLocal(self,task)&&!steal(self,task)) std::this_thread::yield();
+        task();
+
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            done=(--m_unfinished==0);
+        }
+        if(done) m_allDone.notify_all();
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de hilos con robo de trabajo. Cada hilo tiene su propia cola: saca del
+// final lo que el mismo agrego (lo mas reciente, todavia en cache) y cuando se
+// queda sin nada le roba del principio a otro. Las tareas que llegan de afuera
+// se reparten en ronda entre las colas.
+
+class ThreadPool {
+public:
+    using Task=std::function<void()>;
+
+    // threads<=0 usa un hilo por nucleo
+    explicit ThreadPool(int threads=0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&)=delete;
+    ThreadPool& operator=(const ThreadPool&)=delete;
+
+    int threadCount()const;
+
+    void submit(Task task);
+    // espera a que terminen todas las tareas enviadas (no llamar desde una tarea)
+    void wait();
+
+    // f(i) para i en [0,n), en bloques de "grain" indices por tarea
+    template<class F>
+    void parallelFor(int n,F f,int grain=1){
+        if(n<=0) return;
+        grain=grain>0?grain:1;
+        for(int b=0;b<n;b+=grain){
+            const int e=b+grain<n?b+grain:n;
+            submit([f,b,e]{ for(int i=b;i<e;++i) f(i); });
+        }
+        wait();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<unsigned> m_next;
+
+    std::mutex m_mutex;
+    std::condition_variable m_workReady;
+    std::condition_variable m_allDone;
+    long m_queued;
+    long m_unfinished;
+    bool m_stop;
+
+    void workerLoop(int self);
+    bool popLocal(int self,Task& task);
+    bool steal(int self,Task& task);
+};
+
+#endif // THREADPOOL_H
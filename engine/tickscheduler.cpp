@@ -0,0 +1,50 @@
+#include "tickscheduler.h"
+
+#include "metrics.h"
+
+TickScheduler::TickScheduler(SimEngine* engine,QObject* parent)
+    : QObject(parent),
+    m_engine(engine),
+    m_timer(new QTimer(this)),
+    m_stepsPerTick(1)
+{
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(int(m_engine->tickS()*1000.0+0.5));
+    connect(m_timer,&QTimer::timeout,this,&TickScheduler::onTimeout);
+}
+
+// el paso del motor sigue al intervalo para que 1 tick = tiempo real
+void TickScheduler::setTickIntervalMs(int ms){
+    ms=qMax(1,ms);
+    m_timer->setInterval(ms);
+    m_engine->setTickS(ms/1000.0);
+}
+
+int TickScheduler::tickIntervalMs()const{return m_timer->interval();}
+
+// mas de un paso por disparo = simulacion acelerada
+void TickScheduler::setStepsPerTick(int n){ m_stepsPerTick=qMax(1,n); }
+int TickScheduler::stepsPerTick()const{return m_stepsPerTick;}
+
+void TickScheduler::start(){ m_timer->start(); }
+void TickScheduler::stop(){ m_timer->stop(); }
+bool TickScheduler::isRunning()const{return m_timer->isActive();}
+
+void TickScheduler::onTimeout(){
+#ifdef AGUA_METRICS
+    // atraso o adelanto del disparo respecto del intervalo pedido
+    if(m_sinceFire.isValid()){
+        const qint64 lateNs=m_sinceFire.nsecsElapsed()-qint64(m_timer->interval())*1000000;
+        AGUA_METRIC_SAMPLE(TimerJitterUs,qAbs(lateNs)/1000);
+    }
+    m_sinceFire.start();
+#endif
+    emit aboutToStep();
+    {
+        AGUA_METRIC_SCOPE(TickStepNs);
+        m_engine->step(m_stepsPerTick);
+    }
+    AGUA_METRIC_ADD(TicksStepped,m_stepsPerTick);
+    AGUA_METRIC_COUNT(NetworkSteppedSignals);
+    emit networkStepped(m_engine->tickCount(),m_engine->timeS());
+}
@@ -0,0 +1,43 @@
+#ifndef TICKSCHEDULER_H
+#define TICKSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include "simengine.h"
+
+// Un solo reloj para toda la red: cada disparo avanza todos los tanques del
+// SimEngine en una pasada (orden fijo por indice) y avisa una sola vez.
+
+class TickScheduler:public QObject {
+    Q_OBJECT
+public:
+    explicit TickScheduler(SimEngine* engine,QObject* parent=nullptr);
+
+    void setTickIntervalMs(int ms);
+    int tickIntervalMs()const;
+    void setStepsPerTick(int n);
+    int stepsPerTick()const;
+
+    void start();
+    void stop();
+    bool isRunning()const;
+
+signals:
+    void aboutToStep();
+    void networkStepped(unsigned long long tick,double timeS);
+
+private slots:
+    void onTimeout();
+
+private:
+    SimEngine* m_engine;
+    QTimer* m_timer;
+    int m_stepsPerTick;
+#ifdef AGUA_METRICS
+    QElapsedTimer m_sinceFire;
+#endif
+};
+
+#endif // TICKSCHEDULER_H
@@ -0,0 +1,39 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Triple buffer lock-free: el escritor llena writeBuffer() y publica, el lector
+// toma el ultimo publicado con fetch(). Ninguno espera al otro; si el lector es
+// lento simplemente se saltea los intermedios y siempre ve un estado completo.
+
+template<class T>
+class TripleBuffer {
+public:
+    T& writeBuffer(){return m_buffers[m_back];}
+
+    void publish(){
+        int prev=m_middle.exchange(m_back|Fresh,std::memory_order_acq_rel);
+        m_back=prev&IndexMask;
+    }
+
+    // true si habia un buffer nuevo; readBuffer() queda estable hasta el proximo fetch()
+    bool fetch(){
+        if(!(m_middle.load(std::memory_order_acquire)&Fresh)) return false;
+        int prev=m_middle.exchange(m_front,std::memory_order_acq_rel);
+        m_front=prev&IndexMask;
+        return true;
+    }
+
+    const T& readBuffer()const{return m_buffers[m_front];}
+
+private:
+    enum { IndexMask=3, Fresh=4 };
+
+    T m_buffers[3];
+    int m_back=0;
+    int m_front=1;
+    alignas(64) std::atomic<int> m_middle{2};
+};
+
+#endif // TRIPLEBUFFER_H
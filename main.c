@@ -1,93 +1,129 @@
 #include "audio_player.h"
+#include "audio_dsp.h"
+#include "audio_list.h"
+#include "audio_stream.h"
+#include "audio_summary.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-struct pistas{
-    uint32_t samplerate: 4; //bitmap
-    uint32_t samplecount: 28;
+#define CACHE_BYTES (256ull<<20) //pistas recientes que quedan en memoria
+#define SALIDA_HZ 48000 //todas las pistas salen a la frecuencia del dispositivo
+#define VOLUMEN 1.0f
+
+#define ARCHIVO "C:\\Users\\ezequ\\OneDrive\\Escritorio\\Informatica 2\\Ejercicio de parcial (TP6)\\audio_list.raw"
+
+struct salida{
+    struct audio_resampler r;
+    float *buffer;
 };
 
-int main(void){
-    FILE *f=fopen("C:\\Users\\ezequ\\OneDrive\\Escritorio\\Informatica 2\\Ejercicio de parcial (TP6)\\audio_list.raw","rb");
-    if(f==NULL){
-        printf("Hubo un error al abrir el archivo");
+//play_audio recibe la pista de a un bloque por vez, ya pasada a SALIDA_HZ; el
+//volumen va en el filtro y audio_gain solo recorta lo que pase de [-1,1]
+static void reproducir(uint32_t vel,uint32_t muestras,float *datos,void *ctx){
+    struct salida *s=(struct salida*)ctx;
+    (void)vel;
+    const uint32_t n=audio_resampler_process(&s->r,datos,muestras,s->buffer);
+    audio_gain(s->buffer,s->buffer,n,1.0f);
+    play_audio(SALIDA_HZ,n,s->buffer);
+}
+
+static int reproducir_pista(const struct audio_list *lista,int selec,struct audio_cache *cache){
+    struct salida s;
+    const uint32_t hz=audio_samplerate_hz(lista->pistas[selec].audio.samplerate);
+    if(audio_resampler_init(&s.r,hz,SALIDA_HZ,VOLUMEN)!=0){
         return -1;
     }
+    s.buffer=(float*)malloc((size_t)audio_resampler_max_out(&s.r,AUDIO_BLOQUE_MUESTRAS)*sizeof(float));
+    int r=s.buffer?audio_stream_play(lista,selec,cache,reproducir,&s):-1;
+    if(r==0){
+        //lo que queda dentro del filtro
+        const uint32_t n=audio_resampler_flush(&s.r,s.buffer);
+        audio_gain(s.buffer,s.buffer,n,1.0f);
+        if(n>0) play_audio(SALIDA_HZ,n,s.buffer);
+    }
+    free(s.buffer);
+    audio_resampler_free(&s.r);
+    return r;
+}
 
-    fseek(f,0,SEEK_END);//muevo el puntero al final del archivo
-    long tamañototal=ftell(f);//consigo el tamaño del archivo con tell
-    printf("\nEl archivo con tiene un total de %ld bytes\n",tamañototal);
-    fseek(f,0,SEEK_SET);
-    int flag=0;
-    int selec=0;
-    int n=0;
-    struct pistas audio;
-    float *a;
-    size_t leidos;
-    uint32_t vel=0;
+//nivel en dBFS para el menu
+static double dbfs(float x){
+    return 20.0*log10(x);
+}
 
-    while(ftell(f)<tamañototal){
-        fread(&audio,sizeof(audio),1,f);
-        fseek(f,audio.samplecount*sizeof(float),SEEK_CUR);
-        n++;
+//una linea del menu por pista, sin tocar las muestras
+static void mostrar_pista(int i,const struct audio_resumen *p){
+    const double s=audio_summary_seconds(p);
+    printf("%d) %d:%02d",i+1,(int)s/60,(int)s%60);
+    if(p->pico>0){
+        printf("  pico %.1f dBFS  rms %.1f dBFS",dbfs(p->pico),dbfs(p->rms));
+    }else{
+        printf("  silencio");
     }
-    fseek(f,0,SEEK_SET);
-    printf("\nHay %d pistas de audio en el archivo\n",n);
-    uint8_t velpist[n];
-    uint32_t pistasguard[n];
-    float **canciones=malloc(n*sizeof(float *));//creo puntero a puntero para n punteros y le asigno memoria para las pistas
-
-for(int i=0;i<n;i++){
-    fread(&audio,sizeof(audio),1,f);
-    //printf("\nCantidad de bytes: %u\n",audio.samplecount);
-    //printf("\nVelocidad de las muestras: %u=44100Hz\n",audio.samplerate);
+    if(p->no_finitas>0){
+        printf("  [%u muestras invalidas]",p->no_finitas);
+    }
+    if(p->recortadas>0){
+        printf("  [%u recortes]",p->recortadas);
+    }
+    if(p->checksum_ok==0){
+        printf("  [no coincide con el indice]");
+    }
+    printf("\n");
+}
 
-    a=malloc(audio.samplecount*sizeof(float));
-    if(a==NULL){
-        printf("\nError al asignar memoria\n");
-        fclose(f);
+int main(int argc,char *argv[]){
+    //el archivo se puede pasar por linea de comandos
+    const char *path=argc>1?argv[1]:ARCHIVO;
+    struct audio_list lista;
+    //con el indice al lado del archivo no hace falta recorrerlo
+    if(audio_list_open_indexed(&lista,path)!=0){
+        printf("Hubo un error al abrir el archivo");
         return -1;
     }
-    fread(a, sizeof(float), audio.samplecount, f);
 
-    velpist[i]=audio.samplerate;
-    pistasguard[i]=audio.samplecount;
-    canciones[i]=malloc(audio.samplecount*sizeof(float));
-    canciones[i]=a;
+    printf("\nEl archivo con tiene un total de %llu bytes\n",(unsigned long long)lista.size);
+    printf("\nHay %d pistas de audio en el archivo%s\n",lista.n,lista.desde_indice?" (segun el indice)":"");
+    if(lista.truncado){
+        printf("\nLa ultima pista esta incompleta y se ignora\n");
+    }
+    //validacion y niveles de todas las pistas en paralelo; despues salen del .sum
+    struct audio_resumenes resumen;
+    if(audio_summary_open(&lista,path,&resumen,0)!=0){
+        printf("Hubo un error al validar las pistas");
+        audio_list_close(&lista);
+        return -1;
     }
+    struct audio_cache *cache=audio_cache_new(CACHE_BYTES);
+    int flag=0;
+    int selec=0;
 
     do{
     printf("\n||-------------------------MENU------------------------||\n");
-    printf("Que cancion quieres seleccionar?\n1)\n2)\n3)\n4)\n5)\n9)Salir\n");
-    scanf("%d",&selec);
-    selec--; //le resto una para que el menu tenga coerencia con el numero ingresado ya que no existe como tal una cancion 0 pero en el codigo si hay
-    if(selec<6&&selec!=9){
-        if(velpist[selec]==0){ //cambia la primera variable de playaudio segun la pista seleccionada 
-        vel=32000;
+    printf("Que cancion quieres seleccionar?\n");
+    for(int i=0;i<lista.n&&i<8;++i){
+        mostrar_pista(i,&resumen.pistas[i]);
     }
-        if(velpist[selec]==1){
-        vel=44100;
+    printf("9)Salir\n");
+    if(scanf("%d",&selec)!=1){
+        break;
     }
-        if(velpist[selec]==2){
-        vel=48000;
-    }
-        if(velpist[selec]==3){
-        vel=88200;
-    }
-
-    play_audio(vel,pistasguard[selec], canciones[selec]);
+    selec--; //le resto una para que el menu tenga coerencia con el numero ingresado ya que no existe como tal una cancion 0 pero en el codigo si hay
+    if(selec>=0&&selec<lista.n&&selec!=8&&resumen.pistas[selec].no_finitas>0){
+        printf("\nLa pista tiene muestras invalidas y no se reproduce\n");
+    }else if(selec>=0&&selec<lista.n&&selec!=8){
+        //se lee recien ahora, por bloques; si se escucho hace poco sale del cache
+        if(reproducir_pista(&lista,selec,cache)!=0){
+            printf("\nNo se pudo reproducir la pista\n");
+        }
     }
     if(selec==8){
         flag=1;
     }
     }while(flag==0);
-    for(int i=0;i<n;i++){
-        free(canciones[i]);
-    }
-    free(canciones);
-    free(pistasguard);
-    free(velpist);
-    fclose(f);
-    free(a);
+    audio_cache_free(cache);
+    audio_summary_free(&resumen);
+    audio_list_close(&lista);
     return 0;
-}
\ No newline at end of file
+}
@@ -10,6 +10,13 @@
 #include <QLayout>
 #include <QScrollArea>
 #include <QSplitter>
+#include <QSignalBlocker>
+#include <QDockWidget>
+#include <QMenu>
+#include <QMenuBar>
+#include <QStatusBar>
+
+#include "metrics.h"
 
 static double readLphFromLineEdit(QLineEdit* e,double fallback=0.0){
     if(!e) return fallback;
@@ -18,131 +25,113 @@ static double readLphFromLineEdit(QLineEdit* e,double fallback=0.0){
     return ok ? qMax(0.0,v) : fallback;
 }
 
-//uso de ControlTanque
+// vuelve a escribir el campo solo si no muestra el valor que quedo (texto invalido o negativo)
+static void showLph(QLineEdit* e,double v){
+    bool ok=false;
+    const double shown=e->text().toDouble(&ok);
+    if(!ok||shown!=v) e->setText(QString::number(v));
+}
+
+//uso de ControlTanque (vista de un tanque: lee fotos del SimWorker y le manda comandos)
 
-ControlTanque::ControlTanque(QProgressBar* bar,QObject* parent)
+ControlTanque::ControlTanque(SimWorker* worker,int index,QObject* parent)
     : QObject(parent),
-    m_bar(bar),
-    m_timer(new QTimer(this)),
-    m_capacityL(100.0),
-    m_levelL(0.0),
-    m_inputFlowLph(0.0),
-    m_outputFlowLph(0.0),
-    m_inputMaxLph(100.0),
-    m_outputMaxLph(100.0),
-    m_inputEnabled(true),
-    m_canWithdraw(false)
+    m_worker(worker),
+    m_index(index),
+    m_capacityL(worker->engine().capacityL(index)),
+    m_inputMaxLph(worker->engine().inputMaxLph(index)),
+    m_outputMaxLph(worker->engine().outputMaxLph(index)),
+    m_seenFull(0),
+    m_seenEmpty(0),
+    m_seenCanWithdraw(0)
 {
-    m_timer->setInterval(200);
-    connect(m_timer,&QTimer::timeout,this,&ControlTanque::onTick);
-    m_timer->start();
-    updateBar();
 }
 
-void ControlTanque::setCapacityL(double L){
-    double newCap=qMax(1.0,L);
-    if(m_levelL>newCap) m_levelL=newCap;
-    m_capacityL=newCap;
-    updateBar();
-}
-
-void ControlTanque::setInputMaxLph(double Lph){ m_inputMaxLph=qMax(0.0,Lph); }
-void ControlTanque::setOutputMaxLph(double Lph){ m_outputMaxLph=qMax(0.0,Lph); }
-double ControlTanque::getInputMaxLph()const{return m_inputMaxLph;}
-double ControlTanque::getOutputMaxLph()const{return m_outputMaxLph;}
-double ControlTanque::capacityL()const{return m_capacityL;}
-double ControlTanque::currentInputLph()const{return m_inputFlowLph;}
-double ControlTanque::currentOutputLph()const{return m_outputFlowLph;}
+const SimSnapshot& ControlTanque::snap()const{return m_worker->snapshot();}
 
-void ControlTanque::setInputEnabled(bool enabled){
-    m_inputEnabled=enabled;
-    if(!m_inputEnabled) m_inputFlowLph=0.0;
+void ControlTanque::post(SimCommand::Type type,double value){
+    SimCommand c;
+    c.type=type;
+    c.tank=m_index;
+    c.value=value;
+    if(!m_worker->post(c)) emit commandDropped();
 }
 
-bool ControlTanque::isInputEnabled()const{return m_inputEnabled;}
-double ControlTanque::levelL()const{return m_levelL;}
+void ControlTanque::setCapacityL(double L){ m_capacityL=qMax(1.0,L); post(SimCommand::SetCapacity,L); }
+void ControlTanque::setInputMaxLph(double Lph){ m_inputMaxLph=qMax(0.0,Lph); post(SimCommand::SetInputMax,Lph); }
+void ControlTanque::setOutputMaxLph(double Lph){ m_outputMaxLph=qMax(0.0,Lph); post(SimCommand::SetOutputMax,Lph); }
 
-void ControlTanque::applyInputFlowLph(double Lph){
-    if(!m_inputEnabled){ m_inputFlowLph=0.0; return; }
-    if(m_levelL>=m_capacityL){ m_inputFlowLph=0.0; return; }
-    m_inputFlowLph=qMin(Lph,m_inputMaxLph);
-    if(m_levelL>=m_capacityL) m_inputFlowLph=0.0;
+bool ControlTanque::updateCapacityL(double L){
+    if(qMax(1.0,L)==m_capacityL) return false;
+    m_capacityL=qMax(1.0,L);
+    post(SimCommand::UpdateCapacity,L);
+    return true;
 }
 
-void ControlTanque::applyOutputFlowLph(double Lph){
-    if(m_levelL<=0.1*m_capacityL){ m_outputFlowLph=0.0; return; }
-    m_outputFlowLph=qMin(Lph,m_outputMaxLph);
+bool ControlTanque::updateInputMaxLph(double Lph){
+    if(qMax(0.0,Lph)==m_inputMaxLph) return false;
+    m_inputMaxLph=qMax(0.0,Lph);
+    post(SimCommand::UpdateInputMax,Lph);
+    return true;
 }
 
-void ControlTanque::onTick(){
-    const double dt_s=m_timer->interval()/1000.0;
-    double inL=m_inputFlowLph/3600.0*dt_s;
-    double outL=m_outputFlowLph/3600.0*dt_s;
-
-    double newLevel=m_levelL+inL-outL;
-    double minAllowed=0.1*m_capacityL;
-
-    if(outL>0.0&&newLevel<minAllowed){
-        double maxRemovableL=m_levelL-minAllowed;
-        if(maxRemovableL<=0.0){
-            newLevel=m_levelL+inL;
-            m_outputFlowLph=0.0;
-        }else{
-            double allowedOutLph=(maxRemovableL/dt_s)*3600.0;
-            m_outputFlowLph=qMin(m_outputFlowLph,allowedOutLph);
-            outL=m_outputFlowLph/3600.0*dt_s;
-            newLevel=m_levelL+inL-outL;
-            if(newLevel<minAllowed){ newLevel=minAllowed; m_outputFlowLph=0.0; }
-        }
-    }
-
-    if(newLevel>=m_capacityL){
-        m_levelL=m_capacityL;
-        m_inputFlowLph=0.0;
-        emit becameFull();
-    }else if(newLevel<=0.0){
-        m_levelL=0.0;
-        m_outputFlowLph=0.0;
-        emit becameEmpty();
-    }else{
-        m_levelL=newLevel;
-    }
-
-    bool newCanWithdraw=(m_levelL>0.1*m_capacityL);
-    if(newCanWithdraw!=m_canWithdraw){
-        m_canWithdraw=newCanWithdraw;
-        if(!m_canWithdraw) m_outputFlowLph=0.0;
-        emit canWithdrawChanged(m_canWithdraw);
-    }
-
-    updateBar();
-    emit levelChanged(m_levelL);
+bool ControlTanque::updateOutputMaxLph(double Lph){
+    if(qMax(0.0,Lph)==m_outputMaxLph) return false;
+    m_outputMaxLph=qMax(0.0,Lph);
+    post(SimCommand::UpdateOutputMax,Lph);
+    return true;
 }
 
-void ControlTanque::updateBar(){
-    if(!m_bar) return;
-    int pct=(m_capacityL>0.0)?int((m_levelL/m_capacityL)*100.0+0.5):0;
-    pct=qBound(0,pct,100);
-    m_bar->setValue(pct);
+double ControlTanque::getInputMaxLph()const{return m_inputMaxLph;}
+double ControlTanque::getOutputMaxLph()const{return m_outputMaxLph;}
+double ControlTanque::capacityL()const{return m_capacityL;}
+void ControlTanque::setInputEnabled(bool enabled){ post(SimCommand::SetInputEnabled,enabled?1.0:0.0); }
+void ControlTanque::applyInputFlowLph(double Lph){ post(SimCommand::ApplyInputFlow,Lph); }
+void ControlTanque::applyOutputFlowLph(double Lph){ post(SimCommand::ApplyOutputFlow,Lph); }
+int ControlTanque::index()const{return m_index;}
+
+double ControlTanque::currentInputLph()const{ return m_index<snap().tankCount()?snap().inputFlowLph[m_index]:0.0; }
+double ControlTanque::currentOutputLph()const{ return m_index<snap().tankCount()?snap().outputFlowLph[m_index]:0.0; }
+bool ControlTanque::isInputEnabled()const{ return m_index<snap().tankCount()&&snap().inputEnabled[m_index]; }
+double ControlTanque::levelL()const{ return m_index<snap().tankCount()?snap().levelL[m_index]:0.0; }
+
+// compara los contadores de eventos de la foto con los ultimos vistos
+void ControlTanque::syncFromSnapshot(const SimSnapshot& s){
+    if(m_index>=s.tankCount()) return;
+
+    if(s.fullCount[m_index]!=m_seenFull){ m_seenFull=s.fullCount[m_index]; emit becameFull(); }
+    if(s.emptyCount[m_index]!=m_seenEmpty){ m_seenEmpty=s.emptyCount[m_index]; emit becameEmpty(); }
+    if(s.canWithdrawCount[m_index]!=m_seenCanWithdraw){
+        m_seenCanWithdraw=s.canWithdrawCount[m_index];
+        emit canWithdrawChanged(s.canWithdraw[m_index]!=0);
+    }
 }
 
 QJsonObject ControlTanque::toJson()const{
     QJsonObject obj;
-    obj["capacityL"]=m_capacityL;
-    obj["levelL"]=m_levelL;
-    obj["inputMaxLph"]=m_inputMaxLph;
-    obj["outputMaxLph"]=m_outputMaxLph;
-    obj["inputEnabled"]=m_inputEnabled;
+    obj["capacityL"]=capacityL();
+    obj["levelL"]=levelL();
+    obj["inputMaxLph"]=getInputMaxLph();
+    obj["outputMaxLph"]=getOutputMaxLph();
+    obj["inputEnabled"]=isInputEnabled();
     return obj;
 }
 
 void ControlTanque::fromJson(const QJsonObject& obj){
     if(obj.contains("capacityL")) setCapacityL(obj["capacityL"].toDouble());
-    if(obj.contains("levelL")) m_levelL=obj["levelL"].toDouble();
+    if(obj.contains("levelL")) post(SimCommand::SetLevel,obj["levelL"].toDouble());
     if(obj.contains("inputMaxLph")) setInputMaxLph(obj["inputMaxLph"].toDouble());
     if(obj.contains("outputMaxLph")) setOutputMaxLph(obj["outputMaxLph"].toDouble());
     if(obj.contains("inputEnabled")) setInputEnabled(obj["inputEnabled"].toBool());
-    updateBar();
+}
+
+void ControlTanque::fromSnapshotFile(const SnapshotFile& file){
+    if(m_index>=file.tankCount()) return;
+    setCapacityL(file.capacityL(m_index));
+    post(SimCommand::SetLevel,file.levelL(m_index));
+    setInputMaxLph(file.inputMaxLph(m_index));
+    setOutputMaxLph(file.outputMaxLph(m_index));
+    setInputEnabled(file.isInputEnabled(m_index));
 }
 
 // parte de Mainwindow
@@ -150,9 +139,17 @@ void ControlTanque::fromJson(const QJsonObject& obj){
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent),
     ui(new Ui::MainWindow),
+    m_journal(new Journal("sim_journal")),
+    m_recorder(nullptr),
+    m_inputLog(nullptr),
+    m_worker(new SimWorker),
+    m_presenter(nullptr),
+    m_metrics(nullptr),
     TanquePrincipal(nullptr),
     TanqueAuxiliar1(nullptr),
-    TanqueAuxiliar2(nullptr)
+    TanqueAuxiliar2(nullptr),
+    m_saveRequest(0),
+    m_shownCapL{0,0,0}
 {
     ui->setupUi(this);
     if(ui->centralwidget) ui->centralwidget->setSizePolicy(QSizePolicy::Expanding,QSizePolicy::Expanding);
@@ -166,31 +163,80 @@ MainWindow::MainWindow(QWidget* parent)
         if(!w->objectName().isEmpty()){ w->setSizePolicy(QSizePolicy::Expanding,QSizePolicy::Expanding); w->setMinimumSize(16,16); }
     }
 
-    TanquePrincipal=new ControlTanque(ui->Principal,this);
-    TanqueAuxiliar1=new ControlTanque(ui->Auxiliar1,this);
-    TanqueAuxiliar2=new ControlTanque(ui->Auxiliar2,this);
+    // lo que dejo la corrida anterior: ultima foto del diario + replay de los cambios
+    const bool recovered=Journal::recover(m_journal->directory(),m_worker->engine());
 
-    TanquePrincipal->setCapacityL(1000.0);
-    TanqueAuxiliar1->setCapacityL(200.0);
-    TanqueAuxiliar2->setCapacityL(200.0);
+    TanquePrincipal=new ControlTanque(m_worker,SimEngine::Principal,this);
+    TanqueAuxiliar1=new ControlTanque(m_worker,SimEngine::Auxiliar1,this);
+    TanqueAuxiliar2=new ControlTanque(m_worker,SimEngine::Auxiliar2,this);
 
-    TanquePrincipal->setInputMaxLph(500.0);
-    TanquePrincipal->setOutputMaxLph(500.0);
+    // barras y etiquetas se refrescan a ritmo de pantalla, desacopladas del paso del modelo
+    m_presenter=new TankPresenter(m_worker,this);
+    m_presenter->addTank(SimEngine::Principal,ui->Principal,ui->label_PrincipalLevel,ui->label_PrincipalForecast);
+    m_presenter->addTank(SimEngine::Auxiliar1,ui->Auxiliar1,ui->label_Aux1Level,ui->label_Aux1Forecast);
+    m_presenter->addTank(SimEngine::Auxiliar2,ui->Auxiliar2,ui->label_Aux2Level,ui->label_Aux2Forecast);
+    m_presenter->setRateLabels(ui->label_InRate,ui->label_OutRate);
 
-    TanqueAuxiliar1->setInputMaxLph(300.0);
-    TanqueAuxiliar2->setInputMaxLph(300.0);
+    if(!recovered){
+        TanquePrincipal->setCapacityL(1000.0);
+        TanqueAuxiliar1->setCapacityL(200.0);
+        TanqueAuxiliar2->setCapacityL(200.0);
+
+        TanquePrincipal->setInputMaxLph(500.0);
+        TanquePrincipal->setOutputMaxLph(500.0);
+
+        TanqueAuxiliar1->setInputMaxLph(300.0);
+        TanqueAuxiliar2->setInputMaxLph(300.0);
+    }
 
     setupConnections();
+    setupMetricsPanel();
+    setupStateMenu();
 
-    if(ui->checkBox) TanqueAuxiliar1->setInputEnabled(ui->checkBox->isChecked());
-    if(ui->checkBox_2) TanqueAuxiliar2->setInputEnabled(ui->checkBox_2->isChecked());
+    if(recovered){
+        // los diales se acomodan con la primera foto; los checkboxes van a mano
+        if(ui->checkBox){ QSignalBlocker block(ui->checkBox); ui->checkBox->setChecked(m_worker->engine().isInputEnabled(SimEngine::Auxiliar1)); }
+        if(ui->checkBox_2){ QSignalBlocker block(ui->checkBox_2); ui->checkBox_2->setChecked(m_worker->engine().isInputEnabled(SimEngine::Auxiliar2)); }
+    }else{
+        if(ui->checkBox) TanqueAuxiliar1->setInputEnabled(ui->checkBox->isChecked());
+        if(ui->checkBox_2) TanqueAuxiliar2->setInputEnabled(ui->checkBox_2->isChecked());
+    }
 
     syncUiFromState();
 
-    if(ui->Salida) applyDistributionFromDial(ui->Salida->value());
+    if(!recovered&&ui->Salida) applyDistributionFromDial(ui->Salida->value());
+
+    // la simulacion corre en su hilo; lo que se configuro arriba se aplica al arrancar
+    m_worker->setJournal(m_journal);
+    // AGUA_RECORD=<archivo> graba la serie de tiempo (CSV si termina en .csv)
+    const QString recordPath=qEnvironmentVariable("AGUA_RECORD");
+    if(!recordPath.isEmpty()){
+        m_recorder=new Recorder(recordPath,recordPath.endsWith(".csv",Qt::CaseInsensitive)?Recorder::Csv:Recorder::Binary);
+        m_worker->setRecorder(m_recorder);
+    }
+    // AGUA_INPUTS=<directorio> graba la sesion del operador (ver aguareplay)
+    const QString inputsDir=qEnvironmentVariable("AGUA_INPUTS");
+    if(!inputsDir.isEmpty()){
+        m_inputLog=new InputLog(inputsDir);
+        m_worker->setInputLog(m_inputLog);
+    }
+    // AGUA_FORECAST_H=<horas> cambia el horizonte del pronostico (24 h por defecto)
+    const double forecastH=qEnvironmentVariable("AGUA_FORECAST_H").toDouble();
+    if(forecastH>0.0) m_worker->setForecastHorizonS(forecastH*3600.0);
+    m_worker->start();
+    m_presenter->refresh();
+    m_presenter->start();
 }
 
-MainWindow::~MainWindow(){ delete ui; }
+MainWindow::~MainWindow(){
+    m_presenter->stop();
+    m_worker->stop();
+    delete m_worker;
+    delete m_recorder;
+    delete m_inputLog;
+    delete m_journal;
+    delete ui;
+}
 
 void MainWindow::resizeEvent(QResizeEvent* event){
     QMainWindow::resizeEvent(event);
@@ -204,132 +250,38 @@ void MainWindow::resizeEvent(QResizeEvent* event){
     cw->update();
 }
 
-double MainWindow::mapDialToLph(int dialValue)const{
-    if(!TanquePrincipal) return 0.0;
-    double maxLph=TanquePrincipal->getOutputMaxLph();
-    if(maxLph<=0.0) maxLph=TanquePrincipal->capacityL()*2.0;
-    return (dialValue/100.0)*maxLph;
-}
-
-// Distribucion para auxiliares
-void MainWindow::updateAuxiliaryInputs(double totalOutLph){
-    if(!TanquePrincipal||!TanqueAuxiliar1||!TanqueAuxiliar2) return;
-
-    if(TanquePrincipal->levelL()<=0.1*TanquePrincipal->capacityL()){
-        TanquePrincipal->applyOutputFlowLph(0.0);
-        if(ui->Salida) ui->Salida->setValue(0);
-        TanqueAuxiliar1->applyInputFlowLph(0.0);
-        TanqueAuxiliar2->applyInputFlowLph(0.0);
-        return;
-    }
-
-    bool a1can=TanqueAuxiliar1->isInputEnabled()&&(TanqueAuxiliar1->levelL()<TanqueAuxiliar1->capacityL());
-    bool a2can=TanqueAuxiliar2->isInputEnabled()&&(TanqueAuxiliar2->levelL()<TanqueAuxiliar2->capacityL());
-
-    if(!a1can&&!a2can){
-        TanquePrincipal->applyOutputFlowLph(0.0);
-        if(ui->Salida) ui->Salida->setValue(0);
-        TanqueAuxiliar1->applyInputFlowLph(0.0);
-        TanqueAuxiliar2->applyInputFlowLph(0.0);
-        return;
-    }
-
-    double space1=a1can?(TanqueAuxiliar1->capacityL()-TanqueAuxiliar1->levelL()):0.0;
-    double space2=a2can?(TanqueAuxiliar2->capacityL()-TanqueAuxiliar2->levelL()):0.0;
-
-    if(space1<=1e-9&&a2can){
-        TanqueAuxiliar1->applyInputFlowLph(0.0);
-        double take=qMin(totalOutLph,TanqueAuxiliar2->getInputMaxLph());
-        TanqueAuxiliar2->applyInputFlowLph(take);
-        TanquePrincipal->applyOutputFlowLph(take);
-        return;
-    }
-    if(space2<=1e-9&&a1can){
-        TanqueAuxiliar2->applyInputFlowLph(0.0);
-        double take=qMin(totalOutLph,TanqueAuxiliar1->getInputMaxLph());
-        TanqueAuxiliar1->applyInputFlowLph(take);
-        TanquePrincipal->applyOutputFlowLph(take);
-        return;
-    }
-
-    double sumSpace=qMax(1.0,space1+space2);
-    double desired1=totalOutLph*(space1/sumSpace);
-    double desired2=totalOutLph*(space2/sumSpace);
-
-    TanqueAuxiliar1->applyInputFlowLph(desired1);
-    TanqueAuxiliar2->applyInputFlowLph(desired2);
-
-    double realIn1=TanqueAuxiliar1->currentInputLph();
-    double realIn2=TanqueAuxiliar2->currentInputLph();
-    double totalApplied=realIn1+realIn2;
-
-    TanquePrincipal->applyOutputFlowLph(totalApplied);
-
-    if(TanquePrincipal->levelL()>=TanquePrincipal->capacityL()-1e-6){
-        TanquePrincipal->setInputEnabled(false);
-        if(ui->Entrada) ui->Entrada->setValue(0);
-    }
-
-    if(TanquePrincipal->levelL()<=0.1*TanquePrincipal->capacityL()){
-        TanquePrincipal->applyOutputFlowLph(0.0);
-        if(ui->Salida) ui->Salida->setValue(0);
-    }
-}
-
 void MainWindow::setupConnections(){
     if(ui->Salida){
         connect(ui->Salida,&QDial::valueChanged,this,[this](int v){
-            double valLph=mapDialToLph(v);
-            if(ui->label_OutRate) ui->label_OutRate->setText(QString::number(valLph,'f',0)+" L/h ->");
-            if(TanquePrincipal) TanquePrincipal->applyOutputFlowLph(valLph);
-            double actualOut=TanquePrincipal?TanquePrincipal->currentOutputLph():valLph;
-            updateAuxiliaryInputs(actualOut);
+            post(SimCommand::SetMainOutputDial,v);
         });
     }
 
     if(ui->dial_Aux1Out){
         connect(ui->dial_Aux1Out,&QDial::valueChanged,this,[this](int v){
-            if(!TanqueAuxiliar1) return;
-            double out=(v/100.0)*TanqueAuxiliar1->getOutputMaxLph();
-            TanqueAuxiliar1->applyOutputFlowLph(out);
+            post(SimCommand::SetAuxOutputDial,v,SimEngine::Auxiliar1);
         });
     }
     if(ui->dial_Aux2Out){
         connect(ui->dial_Aux2Out,&QDial::valueChanged,this,[this](int v){
-            if(!TanqueAuxiliar2) return;
-            double out=(v/100.0)*TanqueAuxiliar2->getOutputMaxLph();
-            TanqueAuxiliar2->applyOutputFlowLph(out);
+            post(SimCommand::SetAuxOutputDial,v,SimEngine::Auxiliar2);
         });
     }
 
     if(ui->checkBox){
         connect(ui->checkBox,&QCheckBox::toggled,this,[this](bool checked){
-            TanqueAuxiliar1->setInputEnabled(checked);
-            applyDistributionFromDial(ui->Salida?ui->Salida->value():0);
+            post(SimCommand::SetAuxInputEnabled,checked?1.0:0.0,SimEngine::Auxiliar1);
         });
     }
     if(ui->checkBox_2){
         connect(ui->checkBox_2,&QCheckBox::toggled,this,[this](bool checked){
-            TanqueAuxiliar2->setInputEnabled(checked);
-            applyDistributionFromDial(ui->Salida?ui->Salida->value():0);
+            post(SimCommand::SetAuxInputEnabled,checked?1.0:0.0,SimEngine::Auxiliar2);
         });
     }
 
-    if(TanquePrincipal&&ui->label_PrincipalLevel){
-        connect(TanquePrincipal,&ControlTanque::levelChanged,this,[this](double L){
-            ui->label_PrincipalLevel->setText(QString::number(L,'f',1)+" L");
-        });
-    }
-    if(TanqueAuxiliar1&&ui->label_Aux1Level){
-        connect(TanqueAuxiliar1,&ControlTanque::levelChanged,this,[this](double L){
-            ui->label_Aux1Level->setText(QString::number(L,'f',1)+" L");
-        });
-    }
-    if(TanqueAuxiliar2&&ui->label_Aux2Level){
-        connect(TanqueAuxiliar2,&ControlTanque::levelChanged,this,[this](double L){
-            ui->label_Aux2Level->setText(QString::number(L,'f',1)+" L");
-        });
-    }
+    connect(m_presenter,&TankPresenter::snapshotChanged,this,&MainWindow::onSnapshot);
+    for(ControlTanque* t:{TanquePrincipal,TanqueAuxiliar1,TanqueAuxiliar2})
+        connect(t,&ControlTanque::commandDropped,this,&MainWindow::onCommandDropped);
 
     if(ui->pushButtonLoadState) connect(ui->pushButtonLoadState,&QPushButton::clicked,this,&MainWindow::onLoadState);
     if(ui->pushButtonSaveState) connect(ui->pushButtonSaveState,&QPushButton::clicked,this,&MainWindow::onSaveState);
@@ -339,35 +291,56 @@ void MainWindow::setupConnections(){
 
     if(ui->Entrada){
         connect(ui->Entrada,&QDial::valueChanged,this,[this](int v){
-            if(TanquePrincipal&&TanquePrincipal->levelL()<TanquePrincipal->capacityL()-1e-6) TanquePrincipal->setInputEnabled(true);
-            double inRequested=(v/100.0)*TanquePrincipal->getInputMaxLph();
-            TanquePrincipal->applyInputFlowLph(inRequested);
-            if(ui->label_InRate) ui->label_InRate->setText(QString::number(inRequested,'f',0)+" L/h <-");
+            post(SimCommand::SetMainInputDial,v);
         });
     }
+}
 
-    if(TanquePrincipal){
-        connect(TanquePrincipal,&ControlTanque::becameFull,this,[this](){
-            if(ui->Entrada) ui->Entrada->setValue(0);
-            TanquePrincipal->setInputEnabled(false);
-        });
-        connect(TanquePrincipal,&ControlTanque::canWithdrawChanged,this,[this](bool canWithdraw){
-            if(!canWithdraw) if(ui->Salida) ui->Salida->setValue(0);
-        });
-    }
+// panel acoplable, oculto al arrancar; el volcado tambien esta en el menu
+void MainWindow::setupMetricsPanel(){
+    m_metrics=new MetricsPanel(this);
+    QDockWidget* dock=new QDockWidget("Metricas",this);
+    dock->setObjectName("dockMetrics");
+    dock->setWidget(m_metrics);
+    addDockWidget(Qt::RightDockWidgetArea,dock);
+    dock->hide();
+
+    QMenu* menu=menuBar()->addMenu("Metricas");
+    menu->addAction(dock->toggleViewAction());
+    menu->addAction("Volcar a metrics.json",this,&MainWindow::onDumpMetrics);
+}
 
-    if(TanqueAuxiliar1){
-        connect(TanqueAuxiliar1,&ControlTanque::becameFull,this,[this](){
-            if(ui->dial_Aux1Out) ui->dial_Aux1Out->setValue(0);
-            applyDistributionFromDial(ui->Salida?ui->Salida->value():0);
-        });
-    }
-    if(TanqueAuxiliar2){
-        connect(TanqueAuxiliar2,&ControlTanque::becameFull,this,[this](){
-            if(ui->dial_Aux2Out) ui->dial_Aux2Out->setValue(0);
-            applyDistributionFromDial(ui->Salida?ui->Salida->value():0);
-        });
-    }
+// guardar y cargar usan el diario; el JSON queda como exportar/importar explicito
+void MainWindow::setupStateMenu(){
+    QMenu* menu=menuBar()->addMenu("Estado");
+    menu->addAction("Exportar sim_state.json",this,&MainWindow::onExportJson);
+    menu->addAction("Importar sim_state.json",this,&MainWindow::onImportJson);
+}
+
+void MainWindow::onDumpMetrics(){
+    const bool ok=MetricsPanel::dumpToFile("metrics.json");
+    qInfo().noquote()<<Metrics::instance().dump();
+    statusBar()->showMessage(ok?"Metricas guardadas en metrics.json":"No se pudo escribir metrics.json",3000);
+}
+
+void MainWindow::post(SimCommand::Type type,double value,int tank){
+    SimCommand c;
+    c.type=type;
+    c.tank=tank;
+    c.value=value;
+    if(!m_worker->post(c)) onCommandDropped();
+}
+
+void MainWindow::onCommandDropped(){
+    statusBar()->showMessage("La simulacion no responde: se descarto un comando",3000);
+}
+
+// foto nueva del hilo de simulacion: se despachan los eventos y se reflejan los diales
+void MainWindow::onSnapshot(){
+    const SimSnapshot& snap=m_worker->snapshot();
+    for(ControlTanque* t:{TanquePrincipal,TanqueAuxiliar1,TanqueAuxiliar2}) if(t) t->syncFromSnapshot(snap);
+    syncDialsFromSnapshot();
+    checkSaveDone();
 }
 
 void MainWindow::Distribucion(int outputDialValue){
@@ -375,47 +348,90 @@ void MainWindow::Distribucion(int outputDialValue){
 }
 
 void MainWindow::applyDistributionFromDial(int dialValue){
-    if(!TanquePrincipal) return;
+    post(SimCommand::ApplyDistribution,dialValue);
+}
 
-    double requestedOutLph=mapDialToLph(dialValue);
-    TanquePrincipal->applyOutputFlowLph(requestedOutLph);
+// refleja en los diales los cambios que hizo el motor, sin volver a disparar valueChanged.
+// Mientras haya comandos sin aplicar la foto esta atrasada respecto de los diales y no se toca nada.
+void MainWindow::syncDialsFromSnapshot(){
+    const SimSnapshot& snap=m_worker->snapshot();
+    if(snap.commandSeq!=m_worker->postedSeq()||snap.tankCount()<=SimEngine::Auxiliar2) return;
 
-    double actualOutLph=TanquePrincipal->currentOutputLph();
-    updateAuxiliaryInputs(actualOutLph);
+    if(ui->Entrada&&ui->Entrada->value()!=snap.mainInputDial){
+        QSignalBlocker block(ui->Entrada);
+        ui->Entrada->setValue(snap.mainInputDial);
+    }
+    if(ui->Salida&&ui->Salida->value()!=snap.mainOutputDial){
+        QSignalBlocker block(ui->Salida);
+        ui->Salida->setValue(snap.mainOutputDial);
+    }
+    if(ui->dial_Aux1Out&&ui->dial_Aux1Out->value()!=snap.auxOutputDial[SimEngine::Auxiliar1]){
+        QSignalBlocker block(ui->dial_Aux1Out);
+        ui->dial_Aux1Out->setValue(snap.auxOutputDial[SimEngine::Auxiliar1]);
+    }
+    if(ui->dial_Aux2Out&&ui->dial_Aux2Out->value()!=snap.auxOutputDial[SimEngine::Auxiliar2]){
+        QSignalBlocker block(ui->dial_Aux2Out);
+        ui->dial_Aux2Out->setValue(snap.auxOutputDial[SimEngine::Auxiliar2]);
+    }
+}
 
-    if(ui->Entrada){
-        if(TanquePrincipal->capacityL()-TanquePrincipal->levelL()>1e-6) TanquePrincipal->setInputEnabled(true);
-        double inRequested=(ui->Entrada->value()/100.0)*TanquePrincipal->getInputMaxLph();
-        TanquePrincipal->applyInputFlowLph(inRequested);
-        if(ui->label_InRate) ui->label_InRate->setText(QString::number(inRequested,'f',0)+" L/h <-");
+// el diario ya tiene todos los cambios: guardar solo adelanta la foto. La saca el
+// hilo de simulacion en el proximo paso y la escribe el hilo del diario; el
+// resultado se muestra cuando llega (checkSaveDone)
+void MainWindow::onSaveState(){
+    if(!m_journal->isRunning()){
+        statusBar()->showMessage("El diario no esta andando",3000);
+        return;
     }
+    m_saveRequest=m_journal->requestCheckpoint();
+    statusBar()->showMessage("Guardado solicitado");
+}
 
-    if(TanqueAuxiliar1&&ui->dial_Aux1Out&&TanqueAuxiliar1->levelL()>=TanqueAuxiliar1->capacityL()-1e-6) ui->dial_Aux1Out->setValue(0);
-    if(TanqueAuxiliar2&&ui->dial_Aux2Out&&TanqueAuxiliar2->levelL()>=TanqueAuxiliar2->capacityL()-1e-6) ui->dial_Aux2Out->setValue(0);
+void MainWindow::checkSaveDone(){
+    if(!m_saveRequest) return;
+    QString error;
+    if(m_journal->completedCheckpoint(&error)<m_saveRequest) return;
+    m_saveRequest=0;
+    statusBar()->showMessage(error.isEmpty()?"Estado guardado en "+m_journal->directory()
+                                            :"No se pudo guardar: "+error,3000);
+}
 
-    if(TanqueAuxiliar1&&TanqueAuxiliar2&&
-        TanqueAuxiliar1->levelL()>=TanqueAuxiliar1->capacityL()-1e-6&&
-        TanqueAuxiliar2->levelL()>=TanqueAuxiliar2->capacityL()-1e-6){
-        if(ui->Salida) ui->Salida->setValue(0);
-        TanquePrincipal->applyOutputFlowLph(0.0);
+// vuelve a la foto mas nueva del diario
+void MainWindow::onLoadState(){
+    AGUA_METRIC_SCOPE(LoadStateUs);
+    SnapshotFile file;
+    QString error;
+    if(!Journal::openLatestCheckpoint(m_journal->directory(),file,nullptr,&error)){
+        statusBar()->showMessage("No se pudo cargar: "+error,3000);
+        return;
     }
+    TanquePrincipal->fromSnapshotFile(file);
+    TanqueAuxiliar1->fromSnapshotFile(file);
+    TanqueAuxiliar2->fromSnapshotFile(file);
+    post(SimCommand::SetMainInputDial,file.mainInputDial());
+    for(int i:{SimEngine::Auxiliar1,SimEngine::Auxiliar2})
+        if(i<file.tankCount()) post(SimCommand::SetAuxOutputDial,file.auxOutputDial(i),i);
+    syncUiFromState();
+    applyDistributionFromDial(file.mainOutputDial());
 }
 
-void MainWindow::onSaveState(){
+void MainWindow::onExportJson(){
     QJsonObject root;
     root["principal"]=TanquePrincipal->toJson();
     root["aux1"]=TanqueAuxiliar1->toJson();
     root["aux2"]=TanqueAuxiliar2->toJson();
 
     QFile f("sim_state.json");
-    if(f.open(QFile::WriteOnly)){
+    bool ok=f.open(QFile::WriteOnly);
+    if(ok){
         QJsonDocument doc(root);
-        f.write(doc.toJson());
+        ok=f.write(doc.toJson())>=0;
         f.close();
     }
+    statusBar()->showMessage(ok?"Estado exportado a sim_state.json":"No se pudo escribir sim_state.json",3000);
 }
 
-void MainWindow::onLoadState(){
+void MainWindow::onImportJson(){
     QFile f("sim_state.json");
     if(!f.open(QFile::ReadOnly)) return;
     QJsonDocument doc=QJsonDocument::fromJson(f.readAll());
@@ -429,56 +445,59 @@ void MainWindow::onLoadState(){
     applyDistributionFromDial(ui->Salida?ui->Salida->value():0);
 }
 
+// solo los campos que cambiaron: cada uno recalcula lo que depende de su tanque
+// en el hilo de simulacion, sin volver a repartir todo ni reescribir la UI
 void MainWindow::onApplyCapacities(){
-    if(ui->spinBox_CapPrincipal){ double v=ui->spinBox_CapPrincipal->value(); TanquePrincipal->setCapacityL(v); }
-    if(ui->spinBox_CapAux1){ double v=ui->spinBox_CapAux1->value(); TanqueAuxiliar1->setCapacityL(v); }
-    if(ui->spinBox_CapAux2){ double v=ui->spinBox_CapAux2->value(); TanqueAuxiliar2->setCapacityL(v); }
-    syncUiFromState();
-    applyDistributionFromDial(ui->Salida?ui->Salida->value():0);
+    const struct { QSpinBox* box; ControlTanque* tank; int& shown; } caps[]={
+        {ui->spinBox_CapPrincipal,TanquePrincipal,m_shownCapL[0]},
+        {ui->spinBox_CapAux1,TanqueAuxiliar1,m_shownCapL[1]},
+        {ui->spinBox_CapAux2,TanqueAuxiliar2,m_shownCapL[2]}
+    };
+    for(const auto& c:caps){
+        // el spinbox muestra la capacidad truncada: solo cuenta si el usuario lo movio,
+        // asi una capacidad con decimales no se recorta en cada Aplicar
+        if(!c.box||c.box->value()==c.shown) continue;
+        c.shown=c.box->value();
+        c.tank->updateCapacityL(c.shown);
+    }
 }
 
 void MainWindow::onApplyFlows(){
     if(ui->lineEdit_CisternaInLph){
         double v=readLphFromLineEdit(ui->lineEdit_CisternaInLph,TanquePrincipal->getInputMaxLph());
-        TanquePrincipal->setInputMaxLph(v);
+        TanquePrincipal->updateInputMaxLph(v);
+        showLph(ui->lineEdit_CisternaInLph,v);
     }
     if(ui->lineEdit_CisternaOutLph){
         double v=readLphFromLineEdit(ui->lineEdit_CisternaOutLph,TanquePrincipal->getOutputMaxLph());
-        TanquePrincipal->setOutputMaxLph(v);
-        TanqueAuxiliar1->setInputMaxLph(v);
-        TanqueAuxiliar2->setInputMaxLph(v);
+        TanquePrincipal->updateOutputMaxLph(v);
+        TanqueAuxiliar1->updateInputMaxLph(v);
+        TanqueAuxiliar2->updateInputMaxLph(v);
+        showLph(ui->lineEdit_CisternaOutLph,v);
     }
     if(ui->lineEdit_Aux1OutLph){
         double v=readLphFromLineEdit(ui->lineEdit_Aux1OutLph,TanqueAuxiliar1->getOutputMaxLph());
-        TanqueAuxiliar1->setOutputMaxLph(v);
+        TanqueAuxiliar1->updateOutputMaxLph(v);
+        showLph(ui->lineEdit_Aux1OutLph,v);
     }
     if(ui->lineEdit_Aux2OutLph){
         double v=readLphFromLineEdit(ui->lineEdit_Aux2OutLph,TanqueAuxiliar2->getOutputMaxLph());
-        TanqueAuxiliar2->setOutputMaxLph(v);
-    }
-    syncUiFromState();
-    if(ui->Salida&&TanquePrincipal){
-        double requestedMainOut=mapDialToLph(ui->Salida->value());
-        TanquePrincipal->applyOutputFlowLph(requestedMainOut);
-    }else if(TanquePrincipal) TanquePrincipal->applyOutputFlowLph(TanquePrincipal->getOutputMaxLph());
-
-    if(ui->dial_Aux1Out&&TanqueAuxiliar1){
-        double aux1OutRequested=(ui->dial_Aux1Out->value()/100.0)*TanqueAuxiliar1->getOutputMaxLph();
-        TanqueAuxiliar1->applyOutputFlowLph(aux1OutRequested);
+        TanqueAuxiliar2->updateOutputMaxLph(v);
+        showLph(ui->lineEdit_Aux2OutLph,v);
     }
-    if(ui->dial_Aux2Out&&TanqueAuxiliar2){
-        double aux2OutRequested=(ui->dial_Aux2Out->value()/100.0)*TanqueAuxiliar2->getOutputMaxLph();
-        TanqueAuxiliar2->applyOutputFlowLph(aux2OutRequested);
-    }
-
-    if(ui->Salida) applyDistributionFromDial(ui->Salida->value());
-    else{ double manualOut=TanquePrincipal->currentOutputLph(); updateAuxiliaryInputs(manualOut); }
 }
 
 void MainWindow::syncUiFromState(){
-    if(ui->spinBox_CapPrincipal) ui->spinBox_CapPrincipal->setValue((int)TanquePrincipal->capacityL());
-    if(ui->spinBox_CapAux1) ui->spinBox_CapAux1->setValue((int)TanqueAuxiliar1->capacityL());
-    if(ui->spinBox_CapAux2) ui->spinBox_CapAux2->setValue((int)TanqueAuxiliar2->capacityL());
+    const struct { QSpinBox* box; ControlTanque* tank; int& shown; } caps[]={
+        {ui->spinBox_CapPrincipal,TanquePrincipal,m_shownCapL[0]},
+        {ui->spinBox_CapAux1,TanqueAuxiliar1,m_shownCapL[1]},
+        {ui->spinBox_CapAux2,TanqueAuxiliar2,m_shownCapL[2]}
+    };
+    for(const auto& c:caps){
+        if(!c.box) continue;
+        c.box->setValue((int)c.tank->capacityL());
+        c.shown=c.box->value();
+    }
 
     if(ui->lineEdit_CisternaOutLph) ui->lineEdit_CisternaOutLph->setText(QString::number(TanquePrincipal->getOutputMaxLph()));
     if(ui->lineEdit_CisternaInLph) ui->lineEdit_CisternaInLph->setText(QString::number(TanquePrincipal->getInputMaxLph()));
@@ -4,13 +4,17 @@
 #include <QMainWindow>
 #include <QProgressBar>
 #include <QDial>
-#include <QTimer>
 #include <QCheckBox>
 #include <QJsonObject>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QSpinBox>
 
+#include "journal.h"
+#include "metricspanel.h"
+#include "simworker.h"
+#include "tankpresenter.h"
+
 QT_BEGIN_NAMESPACE
 namespace Ui {class MainWindow; }
 QT_END_NAMESPACE
@@ -18,11 +22,15 @@ QT_END_NAMESPACE
 class ControlTanque:public QObject {
     Q_OBJECT
 public:
-    explicit ControlTanque(QProgressBar* bar,QObject*parent=nullptr);
+    explicit ControlTanque(SimWorker* worker,int index,QObject*parent=nullptr);
 
     void setCapacityL(double L);
     void setInputMaxLph(double Lph);
     void setOutputMaxLph(double Lph);
+    // solo mandan el comando si el valor cambia; el motor recalcula lo afectado
+    bool updateCapacityL(double L);
+    bool updateInputMaxLph(double Lph);
+    bool updateOutputMaxLph(double Lph);
     double getInputMaxLph()const;
     double getOutputMaxLph()const;
     double capacityL()const;
@@ -33,32 +41,35 @@ public:
     double levelL()const;
     void applyInputFlowLph(double Lph);
     void applyOutputFlowLph(double Lph);
+    int index()const;
+    void syncFromSnapshot(const SimSnapshot& snap);
 
     QJsonObject toJson()const;
     void fromJson(const QJsonObject&obj);
+    void fromSnapshotFile(const SnapshotFile& file);
 
 signals:
-    void levelChanged(double newLevelL);
     void becameFull();
     void becameEmpty();
     void canWithdrawChanged(bool canWithdraw);
-
-private slots:
-    void onTick();
+    void commandDropped();
 
 private:
-    QProgressBar*m_bar;
-    QTimer*m_timer;
+    SimWorker*m_worker;
+    int m_index;
 
+    // la configuracion la decide la GUI: se guarda aca para no depender de que el
+    // hilo de simulacion ya haya aplicado el comando
     double m_capacityL;
-    double m_levelL;
-    double m_inputFlowLph;
-    double m_outputFlowLph;
     double m_inputMaxLph;
     double m_outputMaxLph;
-    bool m_inputEnabled;
-    bool m_canWithdraw;
-    void updateBar();
+
+    quint32 m_seenFull;
+    quint32 m_seenEmpty;
+    quint32 m_seenCanWithdraw;
+
+    const SimSnapshot& snap()const;
+    void post(SimCommand::Type type,double value);
 };
 
 class MainWindow:public QMainWindow {
@@ -75,21 +86,37 @@ private slots:
     void Distribucion(int outputDialValue);
     void onSaveState();
     void onLoadState();
+    void onExportJson();
+    void onImportJson();
     void onApplyCapacities();
     void onApplyFlows();
+    void onSnapshot();
+    void onDumpMetrics();
+    void onCommandDropped();
 
 private:
     Ui::MainWindow *ui;
 
+    Journal* m_journal;
+    Recorder* m_recorder;
+    InputLog* m_inputLog;
+    SimWorker* m_worker;
+    TankPresenter* m_presenter;
+    MetricsPanel* m_metrics;
     ControlTanque* TanquePrincipal;
     ControlTanque* TanqueAuxiliar1;
     ControlTanque* TanqueAuxiliar2;
+    unsigned long long m_saveRequest;   // pedido de Guardar que todavia no esta en disco
+    int m_shownCapL[3];                 // lo que syncUiFromState puso en cada spinbox de capacidad
 
-    double mapDialToLph(int dialValue) const;
     void setupConnections();
+    void setupMetricsPanel();
+    void setupStateMenu();
     void applyDistributionFromDial(int dialValue);
-    void updateAuxiliaryInputs(double totalOutLph);
+    void post(SimCommand::Type type,double value=0.0,int tank=0);
+    void syncDialsFromSnapshot();
     void syncUiFromState();
+    void checkSaveDone();
 };
 
 #endif // MAINWINDOW_H
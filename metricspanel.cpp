@@ -0,0 +1,63 @@
+#include "metricspanel.h"
+
+#include <QFile>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QJsonDocument>
+#include <QScrollBar>
+#include <QVBoxLayout>
+
+#include "metrics.h"
+
+MetricsPanel::MetricsPanel(QWidget* parent)
+    : QWidget(parent),
+    m_text(new QPlainTextEdit(this)),
+    m_dump(new QPushButton("Volcar a metrics.json",this)),
+    m_reset(new QPushButton("Reiniciar",this)),
+    m_timer(new QTimer(this))
+{
+    m_text->setReadOnly(true);
+    m_text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    m_text->setLineWrapMode(QPlainTextEdit::NoWrap);
+
+    QHBoxLayout* buttons=new QHBoxLayout;
+    buttons->addWidget(m_dump);
+    buttons->addWidget(m_reset);
+    buttons->addStretch();
+    QVBoxLayout* layout=new QVBoxLayout(this);
+    layout->addWidget(m_text);
+    layout->addLayout(buttons);
+
+    m_dump->setEnabled(Metrics::enabled());
+    m_reset->setEnabled(Metrics::enabled());
+    connect(m_dump,&QPushButton::clicked,this,[]{ dumpToFile("metrics.json"); });
+    connect(m_reset,&QPushButton::clicked,this,[this]{ Metrics::instance().reset(); refresh(); });
+
+    m_timer->setInterval(1000);
+    connect(m_timer,&QTimer::timeout,this,&MetricsPanel::refresh);
+}
+
+bool MetricsPanel::dumpToFile(const QString& path){
+    QFile f(path);
+    if(!f.open(QFile::WriteOnly|QFile::Truncate)) return false;
+    f.write(QJsonDocument(Metrics::instance().toJson()).toJson());
+    return true;
+}
+
+void MetricsPanel::refresh(){
+    // se conserva el scroll para poder leer mientras se actualiza
+    const int scroll=m_text->verticalScrollBar()->value();
+    m_text->setPlainText(Metrics::instance().dump());
+    m_text->verticalScrollBar()->setValue(scroll);
+}
+
+void MetricsPanel::showEvent(QShowEvent* event){
+    QWidget::showEvent(event);
+    refresh();
+    m_timer->start();
+}
+
+void MetricsPanel::hideEvent(QHideEvent* event){
+    QWidget::hideEvent(event);
+    m_timer->stop();
+}
@@ -0,0 +1,34 @@
+#ifndef METRICSPANEL_H
+#define METRICSPANEL_H
+
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QTimer>
+#include <QWidget>
+
+// Panel chico con el volcado de Metrics::instance(): se refresca una vez por
+// segundo solo mientras esta visible.
+
+class MetricsPanel:public QWidget {
+    Q_OBJECT
+public:
+    explicit MetricsPanel(QWidget* parent=nullptr);
+
+    // escribe el volcado en JSON; devuelve false si no se pudo abrir el archivo
+    static bool dumpToFile(const QString& path);
+
+public slots:
+    void refresh();
+
+protected:
+    void showEvent(QShowEvent* event)override;
+    void hideEvent(QHideEvent* event)override;
+
+private:
+    QPlainTextEdit* m_text;
+    QPushButton* m_dump;
+    QPushButton* m_reset;
+    QTimer* m_timer;
+};
+
+#endif // METRICSPANEL_H
@@ -0,0 +1,112 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <cstdio>
+#include <vector>
+
+#include "inputlog.h"
+#include "recorder.h"
+
+// avanza hasta target; con speed>0 reparte los pasos para ir a speed x tiempo real
+static void stepTo(SimEngine& engine,unsigned long long target,double speed,
+                   QElapsedTimer& wall,double simStartS){
+    if(speed<=0.0){
+        if(target>engine.tickCount()) engine.step(target-engine.tickCount());
+        return;
+    }
+    const unsigned long long chunk=qMax<unsigned long long>(1,(unsigned long long)(speed*0.01/engine.tickS()));
+    while(engine.tickCount()<target){
+        engine.step(qMin(chunk,target-engine.tickCount()));
+        const double aheadS=(engine.timeS()-simStartS)/speed-wall.nsecsElapsed()/1e9;
+        if(aheadS>0.0) QThread::usleep((unsigned long)(aheadS*1e6));
+    }
+}
+
+int main(int argc,char* argv[]){
+    QCoreApplication app(argc,argv);
+    QCoreApplication::setApplicationName("aguareplay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Reproduce una sesion grabada del operador");
+    parser.addHelpOption();
+    parser.addPositionalArgument("sesion","Directorio de la grabacion (AGUA_INPUTS).");
+    QCommandLineOption untilOpt("until","Corta a los <s> segundos de simulacion desde el arranque.","s");
+    QCommandLineOption speedOpt("speed","Veces el tiempo real (por defecto lo mas rapido posible).","x","0");
+    QCommandLineOption seriesOpt("series","Graba la serie de tiempo de cada tick (CSV si termina en .csv).","archivo");
+    QCommandLineOption verifyOpt("verify","Compara el estado final con end.bin (sale con 2 si difiere).");
+    parser.addOption(untilOpt);
+    parser.addOption(speedOpt);
+    parser.addOption(seriesOpt);
+    parser.addOption(verifyOpt);
+    parser.process(app);
+
+    const QStringList args=parser.positionalArguments();
+    if(args.size()!=1) parser.showHelp(1);
+    const QString dir=args.at(0);
+
+    SimEngine engine;
+    std::vector<InputLog::Entry> entries;
+    unsigned long long endTick=0;
+    QString error;
+    if(!InputLog::load(dir,engine,entries,&endTick,&error)){
+        std::fprintf(stderr,"%s: %s\n",dir.toLocal8Bit().constData(),error.toLocal8Bit().constData());
+        return 1;
+    }
+    const unsigned long long startTick=engine.tickCount();
+    const double simStartS=engine.timeS();
+    if(parser.isSet(untilOpt)){
+        const double untilS=parser.value(untilOpt).toDouble();
+        endTick=qMin(endTick,startTick+(unsigned long long)(qMax(0.0,untilS)/engine.tickS()+0.5));
+    }
+
+    // sin reloj de por medio el escritor no puede perder cuadros
+    Recorder* series=nullptr;
+    if(parser.isSet(seriesOpt)){
+        const QString path=parser.value(seriesOpt);
+        series=new Recorder(path,path.endsWith(".csv",Qt::CaseInsensitive)?Recorder::Csv:Recorder::Binary);
+        series->setLossless(true);
+        if(!series->start(engine.tankCount())){
+            std::fprintf(stderr,"no se pudo escribir %s: %s\n",path.toLocal8Bit().constData(),series->errorString().toLocal8Bit().constData());
+            delete series;
+            return 1;
+        }
+        engine.setTickObserver(series);
+    }
+
+    // igual que InputLog::replay pero con ritmo opcional
+    const double speed=parser.value(speedOpt).toDouble();
+    QElapsedTimer wall;
+    wall.start();
+    int applied=0;
+    for(const InputLog::Entry& e:entries){
+        if(e.tick>endTick) break;
+        stepTo(engine,e.tick,speed,wall,simStartS);
+        if(e.command.tank<0||e.command.tank>=engine.tankCount()) continue;
+        applySimCommand(engine,e.command);
+        ++applied;
+    }
+    stepTo(engine,endTick,speed,wall,simStartS);
+    const double wallS=wall.nsecsElapsed()/1e9;
+
+    engine.setTickObserver(nullptr);
+    if(series){
+        series->stop();
+        delete series;
+    }
+
+    const double simS=engine.timeS()-simStartS;
+    std::printf("%llu ticks, %.1f s simulados, %d comandos en %.3f s (%.0fx tiempo real)\n",
+                engine.tickCount()-startTick,simS,applied,wallS,wallS>0.0?simS/wallS:0.0);
+    for(int i=0;i<engine.tankCount();++i)
+        std::printf("tanque %d: %.3f / %.0f L\n",i,engine.levelL(i),engine.capacityL(i));
+
+    if(parser.isSet(verifyOpt)){
+        QString report;
+        const bool same=InputLog::matchesEnd(dir,engine,&report);
+        std::printf("verificacion contra end.bin: %s\n",report.toLocal8Bit().constData());
+        if(!same) return 2;
+    }
+    return 0;
+}
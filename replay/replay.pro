@@ -0,0 +1,14 @@
+# Reproduccion sin GUI de una sesion grabada con AGUA_INPUTS=<directorio>:
+#   aguareplay sesion/ --verify [--series serie.csv] [--speed 1000]
+# El formato de la grabacion esta en engine/inputlog.h.
+
+TEMPLATE = app
+TARGET = aguareplay
+QT = core
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+SOURCES += \
+    main.cpp
+
+include(../engine/engine.pri)
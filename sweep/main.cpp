@@ -0,0 +1,103 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <cstdio>
+
+#include "simjson.h"
+#include "sweep.h"
+#include "threadpool.h"
+
+// una linea por corrida: parametros sorteados y metricas
+static bool writeCsv(const QString& path,const std::vector<SweepResult>& results){
+    QFile f(path);
+    if(!f.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Text)) return false;
+    QTextStream out(&f);
+    out<<"run,seed,capP,capA1,capA2,inMaxP,inMaxA1,inMaxA2,outMaxP,outMaxA1,outMaxA2,"
+         "tMinP_s,tMinA1_s,tMinA2_s,overflows,demandL,unmetL\n";
+    for(const SweepResult& r:results){
+        out<<r.run.index<<','<<r.run.seed;
+        for(double v:r.run.capacityL) out<<','<<v;
+        for(double v:r.run.inputMaxLph) out<<','<<v;
+        for(double v:r.run.outputMaxLph) out<<','<<v;
+        for(double v:r.timeAtMinimumS) out<<','<<v;
+        out<<','<<r.overflowEvents<<','<<r.demandL<<','<<r.unmetDemandL<<'\n';
+    }
+    return true;
+}
+
+static void printStat(const char* name,const SweepStat& s){
+    std::printf("%-22s mean %12.2f  sd %12.2f  min %12.2f  p50 %12.2f  p95 %12.2f  max %12.2f\n",
+                name,s.mean,s.stddev,s.min,s.p50,s.p95,s.max);
+}
+
+int main(int argc,char* argv[]){
+    QCoreApplication app(argc,argv);
+    QCoreApplication::setApplicationName("aguasweep");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Barrido de parametros de la planta de tanques");
+    parser.addHelpOption();
+    parser.addPositionalArgument("spec","Especificacion del barrido (JSON).");
+    QCommandLineOption threadsOpt(QStringList{"j","threads"},"Hilos (por defecto uno por nucleo).","n","0");
+    QCommandLineOption csvOpt(QStringList{"o","output"},"CSV con una linea por corrida.","archivo");
+    QCommandLineOption summaryOpt("summary","Resumen en JSON.","archivo");
+    parser.addOption(threadsOpt);
+    parser.addOption(csvOpt);
+    parser.addOption(summaryOpt);
+    parser.process(app);
+
+    const QStringList args=parser.positionalArguments();
+    if(args.size()!=1) parser.showHelp(1);
+
+    QFile f(args.at(0));
+    if(!f.open(QIODevice::ReadOnly)){
+        std::fprintf(stderr,"no se pudo abrir %s\n",args.at(0).toLocal8Bit().constData());
+        return 1;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc=QJsonDocument::fromJson(f.readAll(),&parseError);
+    SweepSpec spec;
+    QString error;
+    if(!doc.isObject()) error=parseError.error!=QJsonParseError::NoError?parseError.errorString():"se espera un objeto JSON";
+    if(!doc.isObject()||!sweepSpecFromJson(doc.object(),spec,&error)){
+        std::fprintf(stderr,"especificacion invalida: %s\n",error.toLocal8Bit().constData());
+        return 1;
+    }
+
+    ThreadPool pool(parser.value(threadsOpt).toInt());
+    QElapsedTimer timer;
+    timer.start();
+    const std::vector<SweepResult> results=runSweep(spec,pool);
+    const double elapsedS=timer.nsecsElapsed()/1e9;
+    const SweepSummary summary=summarizeSweep(results);
+
+    std::printf("%d corridas en %.2f s con %d hilos (%.1f corridas/s)\n",
+                summary.runs,elapsedS,pool.threadCount(),elapsedS>0.0?summary.runs/elapsedS:0.0);
+    printStat("t. minimo principal s",summary.timeAtMinimumS[SimEngine::Principal]);
+    printStat("t. minimo aux1 s",summary.timeAtMinimumS[SimEngine::Auxiliar1]);
+    printStat("t. minimo aux2 s",summary.timeAtMinimumS[SimEngine::Auxiliar2]);
+    printStat("llenados",summary.overflowEvents);
+    printStat("demanda no cubierta L",summary.unmetDemandL);
+    printStat("demanda no cubierta %",SweepStat{summary.unmetDemandFrac.mean*100.0,summary.unmetDemandFrac.stddev*100.0,
+                                                 summary.unmetDemandFrac.min*100.0,summary.unmetDemandFrac.p50*100.0,
+                                                 summary.unmetDemandFrac.p95*100.0,summary.unmetDemandFrac.max*100.0});
+
+    if(parser.isSet(csvOpt)&&!writeCsv(parser.value(csvOpt),results)){
+        std::fprintf(stderr,"no se pudo escribir %s\n",parser.value(csvOpt).toLocal8Bit().constData());
+        return 1;
+    }
+    if(parser.isSet(summaryOpt)){
+        QFile s(parser.value(summaryOpt));
+        if(!s.open(QIODevice::WriteOnly|QIODevice::Truncate)){
+            std::fprintf(stderr,"no se pudo escribir %s\n",parser.value(summaryOpt).toLocal8Bit().constData());
+            return 1;
+        }
+        s.write(QJsonDocument(sweepSummaryToJson(summary)).toJson());
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+# Barrido de parametros / Monte Carlo de la planta sin GUI, en todos los nucleos:
+#   aguasweep spec.json -o corridas.csv [-j hilos]
+# El formato de spec.json esta en engine/simjson.h.
+
+TEMPLATE = app
+TARGET = aguasweep
+QT = core
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+SOURCES += \
+    main.cpp
+
+include(../engine/engine.pri)
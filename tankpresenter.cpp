@@ -0,0 +1,116 @@
+#include "tankpresenter.h"
+
+#include <QtMath>
+
+#include <cmath>
+
+#include "metrics.h"
+
+TankPresenter::TankPresenter(SimWorker* worker,QObject* parent)
+    : QObject(parent),
+    m_worker(worker),
+    m_frame(new QTimer(this)),
+    m_inRate(nullptr),
+    m_outRate(nullptr),
+    m_inRateLph(-1),
+    m_outRateLph(-1),
+    m_dirty(true)
+{
+    m_frame->setInterval(33);
+    connect(m_frame,&QTimer::timeout,this,&TankPresenter::onFrame);
+}
+
+void TankPresenter::addTank(int index,QProgressBar* bar,QLabel* levelLabel,QLabel* forecastLabel){
+    m_views.append(TankView{index,bar,levelLabel,forecastLabel,-1,-1,-1});
+    m_dirty=true;
+}
+
+void TankPresenter::setRateLabels(QLabel* inRate,QLabel* outRate){
+    m_inRate=inRate;
+    m_outRate=outRate;
+    m_inRateLph=-1;
+    m_outRateLph=-1;
+    m_dirty=true;
+}
+
+// lo primero que le pasa al tanque: minutos que faltan x 4 + que pasa (0 nada
+// dentro del horizonte, 1 se llena, 2 baja al 10%), para redibujar solo si cambia
+static long long forecastKey(const SimSnapshot& snap,int i){
+    if(i>=int(snap.forecastFullAtS.size())||i>=int(snap.forecastMinAtS.size())) return 0;
+    const double full=snap.forecastFullAtS[i];
+    const double min=snap.forecastMinAtS[i];
+    const double at=qMin(full,min);
+    if(!std::isfinite(at)) return 0;
+    const long long minutes=qMax(0LL,qRound64((at-snap.timeS)/60.0));
+    return minutes*4+(full<=min?1:2);
+}
+
+static QString forecastText(long long key,double horizonS){
+    if(key==0) return QString("sin cambios en %1 h").arg(qRound(horizonS/3600.0));
+    const long long minutes=key/4;
+    const QString what=(key%4==1)?"lleno":"10%";
+    if(minutes==0) return what;
+    if(minutes<60) return QString("%1 en %2 min").arg(what).arg(minutes);
+    return QString("%1 en %2 h %3 min").arg(what).arg(minutes/60).arg(minutes%60,2,10,QChar('0'));
+}
+
+void TankPresenter::setFrameIntervalMs(int ms){ m_frame->setInterval(qMax(1,ms)); }
+int TankPresenter::frameIntervalMs()const{return m_frame->interval();}
+void TankPresenter::start(){ m_frame->start(); }
+void TankPresenter::stop(){ m_frame->stop(); }
+
+void TankPresenter::markDirty(){ m_dirty=true; }
+
+void TankPresenter::onFrame(){
+    bool fresh=m_worker->fetchSnapshot();
+    if(!fresh&&!m_dirty) return;
+    {
+        AGUA_METRIC_SCOPE(PresenterFrameNs);
+        refresh();
+    }
+    if(!fresh) return;
+    AGUA_METRIC_COUNT(SnapshotChangedSignals);
+    emit snapshotChanged();
+}
+
+// todos los setValue/setText de un frame salen del mismo slot, asi Qt junta las
+// regiones sucias en un solo repintado
+void TankPresenter::refresh(){
+    m_dirty=false;
+    const SimSnapshot& snap=m_worker->snapshot();
+
+    for(TankView& v:m_views){
+        if(v.index>=snap.tankCount()) continue;
+        double cap=snap.capacityL[v.index];
+        double L=snap.levelL[v.index];
+
+        if(v.bar){
+            int pct=(cap>0.0)?int((L/cap)*100.0+0.5):0;
+            pct=qBound(0,pct,100);
+            if(pct!=v.pct){ v.pct=pct; v.bar->setValue(pct); }
+        }
+        if(v.label){
+            long long tenths=qRound64(L*10.0);
+            if(tenths!=v.levelTenths){
+                v.levelTenths=tenths;
+                v.label->setText(QString::number(tenths/10.0,'f',1)+" L");
+            }
+        }
+        if(v.forecast){
+            long long key=forecastKey(snap,v.index);
+            if(key!=v.forecastKey){
+                v.forecastKey=key;
+                v.forecast->setText(forecastText(key,snap.forecastHorizonS));
+            }
+        }
+    }
+
+    if(m_inRate){
+        long long inLph=qRound64(snap.mainInputRequestedLph);
+        if(inLph!=m_inRateLph){ m_inRateLph=inLph; m_inRate->setText(QString::number(inLph)+" L/h <-"); }
+    }
+    if(m_outRate){
+        long long outLph=qRound64(snap.mainOutputRequestedLph);
+        if(outLph!=m_outRateLph){ m_outRateLph=outLph; m_outRate->setText(QString::number(outLph)+" L/h ->"); }
+    }
+}
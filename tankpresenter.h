@@ -0,0 +1,61 @@
+#ifndef TANKPRESENTER_H
+#define TANKPRESENTER_H
+
+#include <QObject>
+#include <QProgressBar>
+#include <QLabel>
+#include <QTimer>
+#include <QVector>
+
+#include "simworker.h"
+
+// Capa de presentacion: toma la ultima foto del SimWorker a ritmo de pantalla
+// (no en cada paso del modelo) y solo toca los widgets cuyo valor visible cambio.
+// Al lado de cada tanque puede ir el pronostico de la foto (cuanto falta para que
+// se llene o baje al 10%), redondeado al minuto.
+
+class TankPresenter:public QObject {
+    Q_OBJECT
+public:
+    explicit TankPresenter(SimWorker* worker,QObject* parent=nullptr);
+
+    void addTank(int index,QProgressBar* bar,QLabel* levelLabel,QLabel* forecastLabel=nullptr);
+    void setRateLabels(QLabel* inRate,QLabel* outRate);
+    void setFrameIntervalMs(int ms);
+    int frameIntervalMs()const;
+
+    void start();
+    void stop();
+
+signals:
+    void snapshotChanged();
+
+public slots:
+    void markDirty();
+    void refresh();
+
+private slots:
+    void onFrame();
+
+private:
+    struct TankView {
+        int index;
+        QProgressBar* bar;
+        QLabel* label;
+        QLabel* forecast;
+        int pct;
+        long long levelTenths;
+        long long forecastKey;
+    };
+
+    SimWorker* m_worker;
+    QTimer* m_frame;
+    QVector<TankView> m_views;
+    QLabel* m_inRate;
+    QLabel* m_outRate;
+    long long m_inRateLph;
+    long long m_outRateLph;
+    bool m_dirty;
+};
+
+#endif // TANKPRESENTER_H